@@ -0,0 +1,106 @@
+// bench_dict.cpp : Compares Dict (dict.h) with the std::unordered_map /
+// std::unordered_set stores it replaced: insert and lookup throughput, and the
+// per-insert latency tail, where a one-shot rehash shows up as the max.
+//
+//     bench_dict [keys]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "dict.h"
+
+namespace
+{
+// Same shape as StringMap in mock_redis.h
+struct StringHash
+{
+    using is_transparent = void;
+
+    auto operator()(std::string_view s) const noexcept -> size_t { return std::hash<std::string_view>{}(s); }
+};
+using StdMap = std::unordered_map<std::string, std::string, StringHash, std::equal_to<>>;
+
+struct Result
+{
+    double insertNsPerOp;
+    double lookupNsPerOp;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t maxNanos;
+};
+
+auto nanosSince(std::chrono::steady_clock::time_point start) -> uint64_t
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+template <typename Map> auto run(const std::vector<std::string>& keys) -> Result
+{
+    Map map;
+    std::vector<uint64_t> latencies(keys.size());
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        map.emplace(keys[i], keys[i]);
+        latencies[i] = nanosSince(start);
+    }
+    double insertNs = static_cast<double>(nanosSince(begin)) / static_cast<double>(keys.size());
+
+    size_t hits = 0;
+    begin = std::chrono::steady_clock::now();
+    for (size_t round = 0; round < 4; ++round)
+    {
+        for (const std::string& key : keys)
+        {
+            hits += map.find(std::string_view(key)) != map.end() ? 1 : 0;
+        }
+    }
+    double lookupNs = static_cast<double>(nanosSince(begin)) / static_cast<double>(4 * keys.size());
+    if (hits != 4 * keys.size())
+    {
+        std::fprintf(stderr, "lookup missed %zu keys\n", 4 * keys.size() - hits);
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto at = [&](double fraction) { return latencies[static_cast<size_t>(fraction * (latencies.size() - 1))]; };
+    return {insertNs, lookupNs, at(0.50), at(0.99), at(0.999), latencies.back()};
+}
+
+void print(const char* name, const Result& r)
+{
+    std::printf("%-16s %12.1f %12.1f %10llu %10llu %10llu %12llu\n", name, r.insertNsPerOp, r.lookupNsPerOp,
+                static_cast<unsigned long long>(r.p50), static_cast<unsigned long long>(r.p99),
+                static_cast<unsigned long long>(r.p999), static_cast<unsigned long long>(r.maxNanos));
+}
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2'000'000;
+
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        keys.push_back("key:" + std::to_string(i * 2654435761u % (count * 4)));
+    }
+
+    std::printf("%zu keys\n\n%-16s %12s %12s %10s %10s %10s %12s\n", count, "", "insert ns/op", "lookup ns/op",
+                "insert p50", "p99", "p99.9", "max");
+    print("unordered_map", run<StdMap>(keys));
+    print("Dict", run<DictMap<std::string>>(keys));
+    return 0;
+}
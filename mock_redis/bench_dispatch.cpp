@@ -0,0 +1,61 @@
+// bench_dispatch.cpp : Compares command lookup in the compile-time table
+// against the std::unordered_map<std::string, CommandInfo> registry it replaced.
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mock_redis.h"
+
+namespace
+{
+constexpr std::size_t iterations = 5'000'000;
+
+template <typename Fn> auto nsPerLookup(const std::vector<const char*>& formats, Fn&& lookup) -> double
+{
+    std::size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        hits += lookup(formats[i % formats.size()]) != nullptr ? 1 : 0;
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    if (hits != iterations)
+    {
+        std::cerr << "lookup missed " << (iterations - hits) << " formats\n";
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+} // namespace
+
+auto main() -> int
+{
+    // Same shape as the old CommandRegistry::get() singleton
+    std::unordered_map<std::string, CommandInfo> legacy;
+    std::vector<const char*> formats;
+    for (const auto& info : CommandRegistry::all())
+    {
+        legacy[info.format] = info;
+        formats.push_back(info.format);
+    }
+
+    // Old dispatcher: contains() followed by at(), each building a std::string key
+    double mapNs = nsPerLookup(formats,
+                               [&](const char* name) -> const CommandInfo*
+                               {
+                                   if (!legacy.contains(name)) return nullptr;
+                                   return &legacy.at(name);
+                               });
+
+    double tableNs = nsPerLookup(formats, [](const char* name) { return CommandRegistry::find(name); });
+
+    std::cout << "commands:            " << formats.size() << "\n";
+    std::cout << "unordered_map (ns):  " << mapNs << "\n";
+    std::cout << "perfect hash (ns):   " << tableNs << "\n";
+    std::cout << "speedup:             " << (mapNs / tableNs) << "x\n";
+    return 0;
+}
@@ -0,0 +1,189 @@
+// bench_zset.cpp : Compares the sorted set value (ZSetValue, backed by
+// ScoreTree in score_tree.h) with a naive std::map version: a member->score
+// map beside a std::map ordered by (score, member), where a rank is a walk
+// from the front.  Reports ns per operation for ZADD, ZINCRBY, ZRANK, a
+// 10-member ZRANGE at a random rank and a 10-member ZRANGEBYSCORE.
+//
+//     bench_zset [members]
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "collections.h"
+
+namespace
+{
+constexpr size_t window = 10; // members read per range query
+
+class NaiveZSet
+{
+  public:
+    void add(std::string_view member, double score)
+    {
+        auto [it, inserted] = scores.try_emplace(std::string(member), score);
+        if (!inserted)
+        {
+            ordered.erase({it->second, it->first});
+            it->second = score;
+        }
+        ordered.emplace(std::pair{score, std::string(member)}, 0);
+    }
+
+    [[nodiscard]] auto score(const std::string& member) const -> double { return scores.at(member); }
+
+    [[nodiscard]] auto rank(const std::string& member) const -> size_t
+    {
+        auto it = ordered.find({scores.at(member), member});
+        return static_cast<size_t>(std::distance(ordered.begin(), it));
+    }
+
+    template <typename Fn> void forRange(size_t start, size_t stop, Fn&& fn) const
+    {
+        auto it = std::next(ordered.begin(), static_cast<std::ptrdiff_t>(start));
+        for (size_t i = start; i <= stop && it != ordered.end(); ++i, ++it)
+        {
+            fn(std::string_view(it->first.second), it->first.first);
+        }
+    }
+
+    template <typename Fn> void forScores(double min, size_t n, Fn&& fn) const
+    {
+        auto it = ordered.lower_bound({min, std::string()});
+        for (size_t i = 0; i < n && it != ordered.end(); ++i, ++it)
+        {
+            fn(std::string_view(it->first.second), it->first.first);
+        }
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return ordered.size(); }
+
+  private:
+    std::unordered_map<std::string, double> scores;
+    std::map<std::pair<double, std::string>, char> ordered;
+};
+
+// ZRANGEBYSCORE on the real set: find the first rank, then walk
+template <typename Fn> void forScores(const ZSetValue& zset, double min, size_t n, Fn&& fn)
+{
+    size_t first = zset.lowerBound(min, false);
+    if (first >= zset.size()) return;
+    zset.forRange(first, std::min(first + n, zset.size()) - 1, fn);
+}
+
+template <typename Fn> void forScores(const NaiveZSet& zset, double min, size_t n, Fn&& fn)
+{
+    zset.forScores(min, n, fn);
+}
+
+auto rankOf(const ZSetValue& zset, const std::string& member) -> size_t { return *zset.rank(member); }
+auto rankOf(const NaiveZSet& zset, const std::string& member) -> size_t { return zset.rank(member); }
+
+auto scoreOf(const ZSetValue& zset, const std::string& member) -> double { return *zset.score(member); }
+auto scoreOf(const NaiveZSet& zset, const std::string& member) -> double { return zset.score(member); }
+
+struct Result
+{
+    double addNs;
+    double incrNs;
+    double rankNs;
+    double rangeNs;
+    double byScoreNs;
+};
+
+auto nanosSince(std::chrono::steady_clock::time_point start) -> double
+{
+    return static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+}
+
+template <typename ZSet>
+auto run(const std::vector<std::string>& members, const std::vector<double>& scores, size_t queries) -> Result
+{
+    ZSet zset;
+    std::mt19937_64 rng(7);
+    size_t checksum = 0;
+    auto sink = [&](std::string_view member, double) { checksum += member.size(); };
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+        zset.add(members[i], scores[i]);
+    }
+    double addNs = nanosSince(start) / static_cast<double>(members.size());
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i)
+    {
+        const std::string& member = members[rng() % members.size()];
+        zset.add(member, scoreOf(zset, member) + 1);
+    }
+    double incrNs = nanosSince(start) / static_cast<double>(queries);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i)
+    {
+        checksum += rankOf(zset, members[rng() % members.size()]);
+    }
+    double rankNs = nanosSince(start) / static_cast<double>(queries);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i)
+    {
+        size_t first = rng() % (zset.size() - window);
+        zset.forRange(first, first + window - 1, sink);
+    }
+    double rangeNs = nanosSince(start) / static_cast<double>(queries);
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; ++i)
+    {
+        forScores(zset, scores[rng() % scores.size()], window, sink);
+    }
+    double byScoreNs = nanosSince(start) / static_cast<double>(queries);
+
+    if (checksum == 0) std::fprintf(stderr, "nothing was read\n");
+    return {addNs, incrNs, rankNs, rangeNs, byScoreNs};
+}
+
+void print(const char* name, const Result& r)
+{
+    std::printf("%-10s %10.1f %10.1f %12.1f %12.1f %14.1f\n", name, r.addNs, r.incrNs, r.rankNs, r.rangeNs,
+                r.byScoreNs);
+}
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200'000;
+    size_t queries = 2'000; // the naive rank is a linear walk, so keep this modest
+    if (count <= window) count = window + 1;
+
+    std::vector<std::string> members;
+    std::vector<double> scores;
+    members.reserve(count);
+    scores.reserve(count);
+    std::mt19937_64 rng(42);
+    for (size_t i = 0; i < count; ++i)
+    {
+        members.push_back("player:" + std::to_string(i));
+        scores.push_back(static_cast<double>(rng() % 1'000'000));
+    }
+
+    std::printf("%zu members, %zu queries, %zu-member ranges\n\n%-10s %10s %10s %12s %12s %14s\n", count, queries,
+                window, "ns/op", "ZADD", "ZINCRBY", "ZRANK", "ZRANGE", "ZRANGEBYSCORE");
+    print("std::map", run<NaiveZSet>(members, scores, queries));
+    print("ZSetValue", run<ZSetValue>(members, scores, queries));
+    return 0;
+}
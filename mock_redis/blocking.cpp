@@ -0,0 +1,105 @@
+#include "blocking.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "keyspace.h"
+
+auto blockedClients() -> BlockedClients&
+{
+    static BlockedClients clients;
+    return clients;
+}
+
+void BlockedClients::block(BlockedPop& waiter)
+{
+    if (neverBlock)
+    {
+        waiter.state = BlockedPop::State::TimedOut;
+        return;
+    }
+
+    for (std::string_view key : waiter.keys)
+    {
+        auto [it, inserted] = byKey.emplace(key);
+        it->second.push_back(&waiter);
+    }
+    ++waiting;
+
+    // Sleeping releases commandMutex(), so other commands (the push that serves us) run meanwhile
+    std::mutex& mutex = commandMutex();
+    while (waiter.state == BlockedPop::State::Waiting)
+    {
+        if (waiter.forever)
+        {
+            waiter.wake.wait(mutex);
+        }
+        else if (virtualClockActive())
+        {
+            // A virtual deadline passes in cron(); the bounded wait notices virtual time being switched off
+            waiter.wake.wait_for(mutex, virtualClockRecheck);
+        }
+        else if (waiter.wake.wait_until(mutex, waiter.deadline) == std::cv_status::timeout &&
+                 waiter.state == BlockedPop::State::Waiting)
+        {
+            unlink(waiter);
+            waiter.state = BlockedPop::State::TimedOut;
+        }
+    }
+}
+
+auto BlockedClients::next(std::string_view key) -> BlockedPop*
+{
+    if (waiting == 0) return nullptr;
+
+    auto it = byKey.find(key);
+    if (it == byKey.end()) return nullptr;
+
+    BlockedPop* waiter = it->second.front();
+    waiter->servedKey = static_cast<size_t>(std::find(waiter->keys.begin(), waiter->keys.end(), key) -
+                                            waiter->keys.begin());
+    unlink(*waiter);
+    return waiter;
+}
+
+void BlockedClients::finish(BlockedPop& waiter, BlockedPop::State state, std::string_view value)
+{
+    waiter.value.assign(value);
+    waiter.state = state;
+    waiter.wake.notify_one();
+}
+
+void BlockedClients::unlink(BlockedPop& waiter)
+{
+    for (std::string_view key : waiter.keys)
+    {
+        auto it = byKey.find(key);
+        if (it == byKey.end()) continue; // a repeated key, already done
+
+        std::erase(it->second, &waiter);
+        if (it->second.empty()) byKey.erase(it);
+    }
+    --waiting;
+}
+
+void BlockedClients::expireWaiters()
+{
+    MonotonicTime now = commandNow();
+
+    // Collected first: a waiter sits in the queue of each of its keys, and unlinking erases queues
+    std::vector<BlockedPop*> expired;
+    for (auto& [key, queue] : byKey)
+    {
+        for (BlockedPop* waiter : queue)
+        {
+            if (waiter->forever || waiter->deadline > now || waiter->state != BlockedPop::State::Waiting) continue;
+            finish(*waiter, BlockedPop::State::TimedOut);
+            expired.push_back(waiter);
+        }
+    }
+
+    for (BlockedPop* waiter : expired)
+    {
+        unlink(*waiter);
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "clock.h"
+#include "dict.h"
+
+/*
+ * Blocked clients
+ * ---------------
+ *
+ * BLPOP, BRPOP and BLMOVE on an empty list park the calling thread here
+ * instead of polling.  Each key has a FIFO queue of waiters, as in Redis:
+ *
+ *   - A BLPOP or BRPOP on several keys waits in the queue of each.  The
+ *     first push onto any of them serves it and takes it out of the others.
+ *   - A push onto a missing list first offers its element to the oldest
+ *     waiter on that key (see pushList in mock_redis_list.cpp).  The element
+ *     is handed over directly, never stored in the list and read back, and
+ *     only that one waiter is woken.
+ *   - A push of several elements stores them all first, then serves waiters
+ *     from the list, each from its own end, the way Redis serves them once
+ *     the command is done.
+ *   - For BLMOVE the pusher also performs the move into the destination,
+ *     inside its own command, so the move is atomic as in Redis.
+ *   - A waiter gives up at its deadline on the command clock (clock.h).  In
+ *     real time it sleeps until then; under virtual time it sleeps until
+ *     cron() sees the clock pass the deadline, which advanceVirtualClock
+ *     runs itself, so a test times a pop out by advancing the clock from
+ *     another thread.  It also wakes every few milliseconds to notice
+ *     virtual time being switched off, and then waits for the deadline in
+ *     real time.  A lone thread blocking under virtual time still sleeps
+ *     until virtual time is switched off or another thread advances it.
+ *
+ * All of this relies on commands running one at a time under
+ * commandMutex() (keyspace.h): a waiter releases the mutex while it sleeps
+ * and holds it again when it returns to finish its command.
+ */
+
+// How often a waiter under virtual time wakes to check that virtual time is still on
+inline constexpr std::chrono::milliseconds virtualClockRecheck{10};
+
+enum class ListEnd : unsigned char
+{
+    Left,
+    Right,
+};
+
+// One blocked BLPOP/BRPOP/BLMOVE; lives on the blocked thread's stack
+struct BlockedPop
+{
+    enum class State : unsigned char
+    {
+        Waiting,
+        Served,    // `value` holds the element
+        WrongType, // BLMOVE: the destination stopped being a list
+        TimedOut,
+    };
+
+    std::vector<std::string_view> keys; // in command order; views of the blocked command's arguments
+    size_t servedKey = 0;               // index into keys of the key whose push served the pop
+    ListEnd from = ListEnd::Left;       // the end an element already in the list is taken from
+    std::string_view destination;       // BLMOVE only
+    ListEnd to = ListEnd::Left;         // BLMOVE only
+    MonotonicTime deadline;
+    bool forever = false; // timeout 0
+
+    State state = State::Waiting;
+    std::string value;
+    std::condition_variable_any wake;
+
+    [[nodiscard]] auto isMove() const -> bool { return destination.data() != nullptr; }
+};
+
+class BlockedClients
+{
+  public:
+    // Block the calling command on every key in waiter.keys until served or timed out; commandMutex()
+    // must be held
+    void block(BlockedPop& waiter);
+
+    // Remove and return the oldest waiter on key, or nullptr; it leaves the queues of its other keys too
+    // and records key as its servedKey
+    auto next(std::string_view key) -> BlockedPop*;
+
+    // Complete a waiter taken from next() and wake its thread
+    static void finish(BlockedPop& waiter, BlockedPop::State state, std::string_view value = {});
+
+    // Time out waiters whose deadline has passed; called by the dispatcher after each command and by
+    // advanceVirtualClock
+    void cron()
+    {
+        if (waiting != 0 && virtualClockActive()) expireWaiters();
+    }
+
+    [[nodiscard]] auto blockedCount() const -> size_t { return waiting; }
+
+    // While on, a pop on an empty key times out at once instead of parking, like a blocking pop inside
+    // MULTI in Redis.  The replay tool runs with it on: its one thread has nobody to serve it.
+    void setNeverBlock(bool on) { neverBlock = on; }
+
+  private:
+    void expireWaiters();
+    // Take the waiter out of the queue of each of its keys
+    void unlink(BlockedPop& waiter);
+
+    DictMap<std::deque<BlockedPop*>> byKey; // only keys with waiters
+    size_t waiting = 0;
+    bool neverBlock = false;
+};
+
+// The process-wide registry, alongside keyspace()
+auto blockedClients() -> BlockedClients&;
@@ -0,0 +1,32 @@
+#include "clock.h"
+
+#include <mutex>
+
+#include "blocking.h"
+#include "keyspace.h"
+
+std::atomic<int64_t> detail::commandClock{0};
+std::atomic<int64_t> detail::virtualClock{0};
+std::atomic<bool> detail::virtualClockOn{false};
+
+void useVirtualClock(bool on)
+{
+    if (on)
+    {
+        detail::virtualClock.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                                   std::memory_order_relaxed);
+    }
+    detail::virtualClockOn.store(on, std::memory_order_relaxed);
+    refreshCommandClock();
+}
+
+void advanceVirtualClock(std::chrono::nanoseconds delta)
+{
+    // Taken like a command, so blocked pops whose deadline has now passed time out here rather than
+    // waiting for some later command's cron()
+    std::lock_guard lock(commandMutex());
+    detail::virtualClock.fetch_add(std::chrono::duration_cast<MonotonicTime::duration>(delta).count(),
+                                   std::memory_order_relaxed);
+    refreshCommandClock();
+    blockedClients().cron();
+}
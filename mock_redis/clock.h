@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/*
+ * Command clock
+ * -------------
+ *
+ * All TTL logic (SETEX, EXPIRE, TTL, lazy and active expiry) reads
+ * `commandNow()`, a monotonic time cached once per dispatched command rather
+ * than a clock call per check.  The dispatchers refresh it from the start
+ * time they already take for command statistics, so it costs no extra clock
+ * read, and every check within one command sees the same instant.  Being
+ * steady_clock based, wall-clock steps (NTP, manual changes) neither expire
+ * nor resurrect keys.
+ *
+ * Tests can switch to virtual time, which stands still until advanced:
+ *
+ *     useVirtualClock(true);
+ *     redisCommand(c, "SETEX %s %d %s", "k", 10, "v");
+ *     advanceVirtualClock(std::chrono::seconds(11));
+ *     redisCommand(c, "GET %s", "k"); // nil, without sleeping
+ *
+ * A blocking pop with a timeout (BLPOP, BRPOP, BLMOVE) on an empty key waits
+ * on virtual time too: it returns when another thread pushes, advances the
+ * clock past its deadline or switches virtual time off (the wait then runs
+ * out on the real clock).  A test with a single thread has nobody to do any
+ * of these, so it must not block on an empty key while virtual time is on.
+ */
+
+using MonotonicTime = std::chrono::steady_clock::time_point;
+
+namespace detail
+{
+extern std::atomic<int64_t> commandClock;  // cached time, steady_clock ticks
+extern std::atomic<int64_t> virtualClock;  // virtual time, steady_clock ticks
+extern std::atomic<bool> virtualClockOn;
+} // namespace detail
+
+// The time cached for the command being dispatched
+inline auto commandNow() -> MonotonicTime
+{
+    return MonotonicTime(MonotonicTime::duration(detail::commandClock.load(std::memory_order_relaxed)));
+}
+
+// Cache `realNow` (or the virtual time, when on) as the current command's time
+inline void refreshCommandClock(MonotonicTime realNow)
+{
+    int64_t ticks = detail::virtualClockOn.load(std::memory_order_relaxed)
+                        ? detail::virtualClock.load(std::memory_order_relaxed)
+                        : realNow.time_since_epoch().count();
+    detail::commandClock.store(ticks, std::memory_order_relaxed);
+}
+
+// Same, reading the real clock; for work done outside a dispatch
+inline void refreshCommandClock()
+{
+    refreshCommandClock(std::chrono::steady_clock::now());
+}
+
+// Switch virtual time on (frozen at the current real time) or back off
+void useVirtualClock(bool on);
+
+// Move virtual time forward; the next command sees the new time, and blocked pops whose deadline
+// it passes return nil at once.  Takes commandMutex() (keyspace.h), so never call it while holding it.
+void advanceVirtualClock(std::chrono::nanoseconds delta);
+
+// True while virtual time is on; real-time waits (blocking pops) cannot sleep until a virtual deadline
+inline auto virtualClockActive() -> bool
+{
+    return detail::virtualClockOn.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,512 @@
+#include "collections.h"
+
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+auto encodingLimits() -> EncodingLimits&
+{
+    static EncodingLimits limits;
+    return limits;
+}
+
+namespace
+{
+// a + b into result, unless the sum does not fit
+auto addInteger(int64_t a, int64_t b, int64_t& result) -> bool
+{
+    if (b > 0 ? a > std::numeric_limits<int64_t>::max() - b : a < std::numeric_limits<int64_t>::min() - b)
+    {
+        return false;
+    }
+    result = a + b;
+    return true;
+}
+
+auto formatInteger(Digits& digits, int64_t value) -> std::string_view
+{
+    auto [end, ec] = std::to_chars(digits.data(), digits.data() + digits.size(), value);
+    return {digits.data(), static_cast<size_t>(end - digits.data())};
+}
+} // namespace
+
+// -------------------
+// String
+// -------------------
+
+void StringValue::assign(std::string_view text)
+{
+    int64_t value = 0;
+    if (IntSet::parse(text, value))
+    {
+        repr = value;
+    }
+    else if (auto* str = std::get_if<std::string>(&repr))
+    {
+        str->assign(text); // reuses the buffer
+    }
+    else
+    {
+        repr.emplace<std::string>(text);
+    }
+}
+
+auto StringValue::view(Digits& digits) const -> std::string_view
+{
+    if (const int64_t* value = integer()) return formatInteger(digits, *value);
+    return std::get<std::string>(repr);
+}
+
+auto StringValue::size() const -> size_t
+{
+    Digits digits;
+    return view(digits).size();
+}
+
+auto StringValue::incrBy(int64_t delta, int64_t& result) -> IncrResult
+{
+    int64_t current = 0;
+    if (const int64_t* value = integer())
+    {
+        current = *value;
+    }
+    else if (!IntSet::parse(std::get<std::string>(repr), current))
+    {
+        // Only text built by APPEND can still read as an integer; anything assigned would be one already
+        return IncrResult::NotInteger;
+    }
+
+    if (!addInteger(current, delta, result)) return IncrResult::Overflow;
+    repr = result;
+    return IncrResult::Ok;
+}
+
+void StringValue::append(std::string_view suffix)
+{
+    if (const int64_t* value = integer())
+    {
+        Digits digits;
+        repr = std::string(formatInteger(digits, *value));
+    }
+    std::get<std::string>(repr).append(suffix);
+}
+
+auto StringValue::encoding() const -> const char*
+{
+    if (integer() != nullptr) return "int";
+    return std::get<std::string>(repr).size() <= 44 ? "embstr" : "raw"; // Redis's embedded-string limit
+}
+
+// -------------------
+// Hash
+// -------------------
+
+auto HashValue::get(std::string_view field, Digits& digits) const -> std::optional<std::string_view>
+{
+    if (table)
+    {
+        auto it = table->find(field);
+        if (it == table->end()) return std::nullopt;
+        return it->second.view(digits);
+    }
+
+    size_t pos = packed.find(field, 2);
+    if (pos == packed.end()) return std::nullopt;
+    return packed.get(packed.next(pos));
+}
+
+auto HashValue::contains(std::string_view field) const -> bool
+{
+    if (table) return table->contains(field);
+    return packed.find(field, 2) != packed.end();
+}
+
+auto HashValue::set(std::string_view field, std::string_view value) -> bool
+{
+    const EncodingLimits& limits = encodingLimits();
+    if (!table && (field.size() > limits.hashMaxListpackValue || value.size() > limits.hashMaxListpackValue))
+    {
+        convert();
+    }
+
+    if (table)
+    {
+        auto [it, inserted] = table->emplace(field, value);
+        if (!inserted) it->second.assign(value);
+        return inserted;
+    }
+
+    size_t pos = packed.find(field, 2);
+    if (pos != packed.end())
+    {
+        packed.replace(packed.next(pos), value);
+        return false;
+    }
+
+    packed.pushBack(field);
+    packed.pushBack(value);
+    if (size() > limits.hashMaxListpackEntries) convert();
+    return true;
+}
+
+auto HashValue::erase(std::string_view field) -> bool
+{
+    if (table) return table->erase(field);
+
+    size_t pos = packed.find(field, 2);
+    if (pos == packed.end()) return false;
+    packed.erase(pos, 2);
+    return true;
+}
+
+auto HashValue::incrBy(std::string_view field, int64_t delta, int64_t& result) -> IncrResult
+{
+    if (table)
+    {
+        auto [it, inserted] = table->emplace(field, int64_t{0});
+        return it->second.incrBy(delta, result);
+    }
+
+    // A listpack holds text, so the value is parsed and rewritten where it lies, without allocating
+    size_t pos = packed.find(field, 2);
+    int64_t current = 0;
+    if (pos != packed.end() && !IntSet::parse(packed.get(packed.next(pos)), current)) return IncrResult::NotInteger;
+    if (!addInteger(current, delta, result)) return IncrResult::Overflow;
+
+    Digits digits;
+    if (pos != packed.end())
+    {
+        packed.replace(packed.next(pos), formatInteger(digits, result));
+    }
+    else
+    {
+        set(field, formatInteger(digits, result));
+    }
+    return IncrResult::Ok;
+}
+
+void HashValue::convert()
+{
+    auto converted = std::make_unique<DictMap<StringValue>>();
+    forEach([&](std::string_view field, std::string_view value) { converted->emplace(field, value); });
+    table = std::move(converted);
+    packed = Listpack();
+}
+
+// -------------------
+// Set
+// -------------------
+
+auto SetValue::size() const -> size_t
+{
+    if (const auto* ints = std::get_if<IntSet>(&members)) return ints->size();
+    if (const auto* packed = std::get_if<Listpack>(&members)) return packed->size();
+    return std::get<Table>(members)->size();
+}
+
+auto SetValue::contains(std::string_view member) const -> bool
+{
+    if (const auto* ints = std::get_if<IntSet>(&members))
+    {
+        int64_t value = 0;
+        return IntSet::parse(member, value) && ints->contains(value);
+    }
+    if (const auto* packed = std::get_if<Listpack>(&members)) return packed->find(member) != packed->end();
+    return std::get<Table>(members)->contains(member);
+}
+
+auto SetValue::add(std::string_view member) -> bool
+{
+    const EncodingLimits& limits = encodingLimits();
+
+    if (auto* ints = std::get_if<IntSet>(&members))
+    {
+        int64_t value = 0;
+        if (!IntSet::parse(member, value))
+        {
+            if (ints->size() < limits.setMaxListpackEntries && member.size() <= limits.setMaxListpackValue)
+            {
+                convertToListpack();
+            }
+            else
+            {
+                convertToTable();
+            }
+        }
+        else if (ints->size() < limits.setMaxIntsetEntries || ints->contains(value))
+        {
+            return ints->add(value);
+        }
+        else
+        {
+            convertToTable();
+        }
+    }
+
+    if (auto* packed = std::get_if<Listpack>(&members))
+    {
+        if (packed->find(member) != packed->end()) return false;
+        if (member.size() <= limits.setMaxListpackValue && packed->size() < limits.setMaxListpackEntries)
+        {
+            packed->pushBack(member);
+            return true;
+        }
+        convertToTable();
+    }
+
+    return std::get<Table>(members)->emplace(member).second;
+}
+
+auto SetValue::remove(std::string_view member) -> bool
+{
+    if (auto* ints = std::get_if<IntSet>(&members))
+    {
+        int64_t value = 0;
+        return IntSet::parse(member, value) && ints->remove(value);
+    }
+    if (auto* packed = std::get_if<Listpack>(&members))
+    {
+        size_t pos = packed->find(member);
+        if (pos == packed->end()) return false;
+        packed->erase(pos);
+        return true;
+    }
+    return std::get<Table>(members)->erase(member);
+}
+
+auto SetValue::encoding() const -> const char*
+{
+    static constexpr const char* names[] = {"intset", "listpack", "hashtable"};
+    return names[members.index()];
+}
+
+auto SetValue::formatInteger(char (&digits)[24], int64_t value) -> std::string_view
+{
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), value);
+    return {digits, static_cast<size_t>(end - digits)};
+}
+
+void SetValue::convertToListpack()
+{
+    Listpack packed;
+    forEach([&](std::string_view member) { packed.pushBack(member); });
+    members = std::move(packed);
+}
+
+void SetValue::convertToTable()
+{
+    auto table = std::make_unique<DictSet>();
+    forEach([&](std::string_view member) { table->emplace(member); });
+    members = std::move(table);
+}
+
+// -------------------
+// List
+// -------------------
+
+void ListValue::reserveFor(size_t len)
+{
+    // Entry overhead is at most a few bytes; counting 2 is close enough for a threshold
+    if (items || packed.bytes() + len + 2 <= encodingLimits().listMaxListpackBytes) return;
+
+    const EncodingLimits& limits = encodingLimits();
+    items = std::make_unique<Quicklist>(std::move(packed), limits.listMaxListpackBytes, limits.listCompressDepth);
+    packed = Listpack();
+}
+
+void ListValue::pushFront(std::string_view value)
+{
+    reserveFor(value.size());
+    if (items)
+    {
+        items->pushFront(value);
+        return;
+    }
+    packed.pushFront(value);
+}
+
+void ListValue::pushBack(std::string_view value)
+{
+    reserveFor(value.size());
+    if (items)
+    {
+        items->pushBack(value);
+        return;
+    }
+    packed.pushBack(value);
+}
+
+auto ListValue::front() const -> std::string_view
+{
+    if (items) return items->front();
+    return packed.get(packed.begin());
+}
+
+auto ListValue::back() const -> std::string_view
+{
+    if (items) return items->back();
+    return packed.get(packed.last());
+}
+
+void ListValue::popFront()
+{
+    if (items)
+    {
+        items->popFront();
+        return;
+    }
+    packed.erase(packed.begin());
+}
+
+void ListValue::popBack()
+{
+    if (items)
+    {
+        items->popBack();
+        return;
+    }
+    packed.erase(packed.last());
+}
+
+// -------------------
+// Sorted set
+// -------------------
+
+auto ZSetValue::score(std::string_view member) const -> std::optional<double>
+{
+    if (sorted)
+    {
+        auto it = sorted->scores.find(member);
+        if (it == sorted->scores.end()) return std::nullopt;
+        return it->second;
+    }
+
+    size_t pos = packed.find(member, 2);
+    if (pos == packed.end()) return std::nullopt;
+    return unpackScore(packed.get(packed.next(pos)));
+}
+
+auto ZSetValue::add(std::string_view member, double score) -> bool
+{
+    const EncodingLimits& limits = encodingLimits();
+    if (!sorted && member.size() > limits.zsetMaxListpackValue) convert();
+
+    if (sorted)
+    {
+        auto [it, inserted] = sorted->scores.emplace(member, score);
+        if (!inserted)
+        {
+            if (it->second == score) return false;
+            sorted->tree.erase(it->second, member);
+            it->second = score;
+        }
+        sorted->tree.insert(score, member);
+        return inserted;
+    }
+
+    size_t pos = packed.find(member, 2);
+    bool inserted = pos == packed.end();
+    if (!inserted)
+    {
+        if (unpackScore(packed.get(packed.next(pos))) == score) return false;
+        packed.erase(pos, 2);
+    }
+    else if (size() >= limits.zsetMaxListpackEntries)
+    {
+        convert();
+        return add(member, score);
+    }
+
+    char bytes[sizeof(double)];
+    pos = packedPosition(score, member);
+    packed.insert(pos, packScore(score, bytes));
+    packed.insert(pos, member);
+    return inserted;
+}
+
+auto ZSetValue::remove(std::string_view member) -> bool
+{
+    if (sorted)
+    {
+        auto it = sorted->scores.find(member);
+        if (it == sorted->scores.end()) return false;
+        sorted->tree.erase(it->second, member);
+        sorted->scores.erase(it);
+        return true;
+    }
+
+    size_t pos = packed.find(member, 2);
+    if (pos == packed.end()) return false;
+    packed.erase(pos, 2);
+    return true;
+}
+
+auto ZSetValue::rank(std::string_view member) const -> std::optional<size_t>
+{
+    if (sorted)
+    {
+        auto it = sorted->scores.find(member);
+        if (it == sorted->scores.end()) return std::nullopt;
+        return sorted->tree.rank(it->second, member);
+    }
+
+    size_t pos = packed.find(member, 2);
+    if (pos == packed.end()) return std::nullopt;
+    size_t before = 0;
+    for (size_t at = packed.begin(); at != pos; at = packed.next(packed.next(at)))
+    {
+        ++before;
+    }
+    return before;
+}
+
+auto ZSetValue::lowerBound(double min, bool exclusive) const -> size_t
+{
+    if (sorted) return sorted->tree.lowerBound(min, exclusive);
+
+    size_t before = 0;
+    for (size_t pos = packed.begin(); pos != packed.end(); pos = packed.next(packed.next(pos)), ++before)
+    {
+        double score = unpackScore(packed.get(packed.next(pos)));
+        if (exclusive ? score > min : score >= min) break;
+    }
+    return before;
+}
+
+auto ZSetValue::packScore(double score, char (&bytes)[sizeof(double)]) -> std::string_view
+{
+    std::memcpy(bytes, &score, sizeof(double));
+    return {bytes, sizeof(double)};
+}
+
+auto ZSetValue::unpackScore(std::string_view bytes) -> double
+{
+    double score = 0;
+    std::memcpy(&score, bytes.data(), sizeof(double));
+    return score;
+}
+
+auto ZSetValue::packedPosition(double score, std::string_view member) const -> size_t
+{
+    size_t pos = packed.begin();
+    for (; pos != packed.end(); pos = packed.next(packed.next(pos)))
+    {
+        double at = unpackScore(packed.get(packed.next(pos)));
+        if (score < at || (score == at && member < packed.get(pos))) break;
+    }
+    return pos;
+}
+
+void ZSetValue::convert()
+{
+    auto converted = std::make_unique<Sorted>();
+    for (size_t pos = packed.begin(); pos != packed.end(); pos = packed.next(packed.next(pos)))
+    {
+        std::string_view member = packed.get(pos);
+        double score = unpackScore(packed.get(packed.next(pos)));
+        converted->scores.emplace(member, score);
+        converted->tree.insert(score, member);
+    }
+    sorted = std::move(converted);
+    packed = Listpack();
+}
@@ -0,0 +1,379 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "dict.h"
+#include "intset.h"
+#include "listpack.h"
+#include "quicklist.h"
+#include "score_tree.h"
+
+/*
+ * Collection values
+ * -----------------
+ *
+ * The values stored in the keyspace for hashes, sets and lists.  Each one
+ * starts out as a single Listpack (listpack.h) and converts itself, once and
+ * for good, to the general structure when it outgrows the limits in
+ * encodingLimits():
+ *
+ *     hash   listpack of field, value, field, value ...   ->  DictMap
+ *     set    intset (intset.h) or listpack of members     ->  DictSet
+ *     list   listpack of elements                         ->  Quicklist
+ *     zset   listpack of member, score, ... by score      ->  DictMap + ScoreTree
+ *
+ * A hash or set converts when it would exceed its entry count, or when a
+ * field, value or member is longer than the value limit.  A set stays an
+ * intset while every member is an integer; the first other member moves it
+ * to a listpack, or straight to a DictSet if it is already too big for one.  A list converts
+ * when its listpack would exceed the byte limit; that listpack becomes the
+ * first node of the quicklist (quicklist.h).  The general structure lives
+ * behind a pointer, so a small collection costs the listpack and one null
+ * pointer in its KeyEntry.  A sorted set converts on the same kind of limits
+ * as a hash; its general form indexes each member twice, by name for ZSCORE
+ * and by (score, member) for ranks and ranges (score_tree.h).
+ *
+ * Strings (StringValue) have two forms of their own: text that reads back as
+ * a 64-bit integer is kept as that integer, as Redis's "int" encoding does,
+ * and is formatted only when read as text.  Counters (INCR, HINCRBY) then add
+ * to a number instead of parsing and rewriting a string on every update.  A
+ * hashtable-encoded hash stores its values the same way; a listpack holds
+ * text only, so a small hash's counters are parsed in place.
+ *
+ * OBJECT ENCODING reports which form a key is in.
+ */
+
+// Conversion thresholds, named after the Redis settings they mirror; change them before storing data
+struct EncodingLimits
+{
+    size_t hashMaxListpackEntries = 128; // hash-max-listpack-entries
+    size_t hashMaxListpackValue = 64;    // hash-max-listpack-value
+    size_t setMaxIntsetEntries = 512;    // set-max-intset-entries
+    size_t setMaxListpackEntries = 128;  // set-max-listpack-entries
+    size_t setMaxListpackValue = 64;     // set-max-listpack-value
+    size_t listMaxListpackBytes = 8192;  // list-max-listpack-size -2, also the quicklist node size
+    size_t listCompressDepth = 0;        // list-compress-depth; 0 leaves every node raw
+    size_t zsetMaxListpackEntries = 128; // zset-max-listpack-entries
+    size_t zsetMaxListpackValue = 64;    // zset-max-listpack-value
+};
+
+auto encodingLimits() -> EncodingLimits&;
+
+// Room for any int64_t in decimal: an integer-encoded value is formatted into one when read as text
+using Digits = std::array<char, 24>;
+
+// Outcome of an INCRBY-style update
+enum class IncrResult
+{
+    Ok,
+    NotInteger, // the current value is not a 64-bit integer
+    Overflow,   // the sum is out of range; the value is left as it was
+};
+
+// -------------------
+// String
+// -------------------
+
+class StringValue
+{
+  public:
+    StringValue() = default;
+    explicit StringValue(std::string_view text) { assign(text); }
+    explicit StringValue(int64_t value) : repr(value) {}
+
+    // Text that reads back as an integer ("12", not "012" or "+12") is stored as that integer
+    void assign(std::string_view text);
+
+    // The value as text; an integer is formatted into digits, so the view lasts as long as both
+    [[nodiscard]] auto view(Digits& digits) const -> std::string_view;
+
+    // The integer, while the value is stored as one
+    [[nodiscard]] auto integer() const -> const int64_t* { return std::get_if<int64_t>(&repr); }
+
+    // Length of the text (STRLEN)
+    [[nodiscard]] auto size() const -> size_t;
+
+    // Add delta to the value read as an integer; result is the new value
+    auto incrBy(int64_t delta, int64_t& result) -> IncrResult;
+
+    // The value becomes text, even if the result would read back as an integer
+    void append(std::string_view suffix);
+
+    [[nodiscard]] auto encoding() const -> const char*;
+
+  private:
+    std::variant<std::string, int64_t> repr;
+};
+
+// -------------------
+// Hash
+// -------------------
+
+class HashValue
+{
+  public:
+    [[nodiscard]] auto size() const -> size_t { return table ? table->size() : packed.size() / 2; }
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    // Value of field, if present; valid until the hash is modified or digits is reused
+    [[nodiscard]] auto get(std::string_view field, Digits& digits) const -> std::optional<std::string_view>;
+    [[nodiscard]] auto contains(std::string_view field) const -> bool;
+
+    // True if field was added, false if an existing value was overwritten
+    auto set(std::string_view field, std::string_view value) -> bool;
+
+    auto erase(std::string_view field) -> bool;
+
+    // HINCRBY: add delta to field read as an integer, a missing field counting as 0; result is the
+    // new value
+    auto incrBy(std::string_view field, int64_t delta, int64_t& result) -> IncrResult;
+
+    // fn(field, value) for every pair
+    template <typename Fn> void forEach(Fn&& fn) const
+    {
+        if (table)
+        {
+            Digits digits;
+            for (const auto& [field, value] : *table)
+            {
+                fn(std::string_view(field), value.view(digits));
+            }
+            return;
+        }
+        for (size_t pos = packed.begin(); pos != packed.end(); pos = packed.next(packed.next(pos)))
+        {
+            fn(packed.get(pos), packed.get(packed.next(pos)));
+        }
+    }
+
+    // One SCAN step (Dict::scan): fn(field, value) for one bucket, or for every pair of a
+    // listpack at once.  Returns the next cursor, 0 when done.
+    template <typename Fn> auto scan(uint64_t cursor, Fn&& fn) const -> uint64_t
+    {
+        if (!table)
+        {
+            forEach(fn);
+            return 0;
+        }
+        Digits digits;
+        return table->scan(cursor, [&](const auto& pair)
+                           { fn(std::string_view(pair.first), pair.second.view(digits)); });
+    }
+
+    [[nodiscard]] auto encoding() const -> const char* { return table ? "hashtable" : "listpack"; }
+
+  private:
+    void convert();
+
+    Listpack packed;                             // field, value, ... while small
+    std::unique_ptr<DictMap<StringValue>> table; // after conversion
+};
+
+// -------------------
+// Set
+// -------------------
+
+class SetValue
+{
+  public:
+    [[nodiscard]] auto size() const -> size_t;
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    [[nodiscard]] auto contains(std::string_view member) const -> bool;
+
+    // True if member was not already present
+    auto add(std::string_view member) -> bool;
+
+    auto remove(std::string_view member) -> bool;
+
+    template <typename Fn> void forEach(Fn&& fn) const
+    {
+        if (const auto* ints = std::get_if<IntSet>(&members))
+        {
+            char digits[24];
+            ints->forEach([&](int64_t value) { fn(formatInteger(digits, value)); });
+        }
+        else if (const auto* packed = std::get_if<Listpack>(&members))
+        {
+            packed->forEach(fn);
+        }
+        else
+        {
+            for (const std::string& member : *std::get<Table>(members))
+            {
+                fn(std::string_view(member));
+            }
+        }
+    }
+
+    // forEach until fn returns false
+    template <typename Fn> void forEachWhile(Fn&& fn) const
+    {
+        if (const auto* table = std::get_if<Table>(&members))
+        {
+            for (const std::string& member : **table)
+            {
+                if (!fn(std::string_view(member))) return;
+            }
+            return;
+        }
+
+        // The compact forms are small, so the members after a stop are just passed over
+        bool going = true;
+        forEach([&](std::string_view member) { going = going && fn(member); });
+    }
+
+    // The intset, while the set is still in that encoding
+    [[nodiscard]] auto intSet() const -> const IntSet* { return std::get_if<IntSet>(&members); }
+
+    // One SCAN step (Dict::scan): fn(member) for one bucket, or for every member of an intset
+    // or listpack at once.  Returns the next cursor, 0 when done.
+    template <typename Fn> auto scan(uint64_t cursor, Fn&& fn) const -> uint64_t
+    {
+        if (const auto* table = std::get_if<Table>(&members))
+        {
+            return (*table)->scan(cursor, [&](const std::string& member) { fn(std::string_view(member)); });
+        }
+        forEach(fn);
+        return 0;
+    }
+
+    [[nodiscard]] auto encoding() const -> const char*;
+
+  private:
+    using Table = std::unique_ptr<DictSet>;
+
+    static auto formatInteger(char (&digits)[24], int64_t value) -> std::string_view;
+
+    void convertToListpack();
+    void convertToTable();
+
+    // Empty sets start as an intset; the first non-integer member moves them on
+    std::variant<IntSet, Listpack, Table> members;
+};
+
+// -------------------
+// List
+// -------------------
+
+class ListValue
+{
+  public:
+    [[nodiscard]] auto size() const -> size_t { return items ? items->size() : packed.size(); }
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    void pushFront(std::string_view value);
+    void pushBack(std::string_view value);
+
+    // Valid until the list is modified; the list must not be empty
+    [[nodiscard]] auto front() const -> std::string_view;
+    [[nodiscard]] auto back() const -> std::string_view;
+
+    void popFront();
+    void popBack();
+
+    // fn(element) for the elements at indices [start, stop], already clamped to the list
+    template <typename Fn> void forRange(size_t start, size_t stop, Fn&& fn) const
+    {
+        if (items)
+        {
+            items->forRange(start, stop, fn);
+            return;
+        }
+        size_t pos = packed.seek(static_cast<long long>(start));
+        for (size_t i = start; i <= stop; ++i, pos = packed.next(pos))
+        {
+            fn(packed.get(pos));
+        }
+    }
+
+    [[nodiscard]] auto encoding() const -> const char* { return items ? "quicklist" : "listpack"; }
+
+  private:
+    // Convert first if adding `len` bytes would outgrow the listpack
+    void reserveFor(size_t len);
+
+    Listpack packed;
+    std::unique_ptr<Quicklist> items;
+};
+
+// -------------------
+// Sorted set
+// -------------------
+
+class ZSetValue
+{
+  public:
+    [[nodiscard]] auto size() const -> size_t { return sorted ? sorted->tree.size() : packed.size() / 2; }
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    [[nodiscard]] auto score(std::string_view member) const -> std::optional<double>;
+
+    // True if member was added, false if an existing member's score was changed
+    auto add(std::string_view member, double score) -> bool;
+
+    auto remove(std::string_view member) -> bool;
+
+    // Position of member in ascending score order, if present
+    [[nodiscard]] auto rank(std::string_view member) const -> std::optional<size_t>;
+
+    // Rank of the first member scoring >= min (> min if exclusive); size() if there is none
+    [[nodiscard]] auto lowerBound(double min, bool exclusive) const -> size_t;
+
+    // fn(member, score) for the members at ranks [start, stop], already clamped to the set
+    template <typename Fn> void forRange(size_t start, size_t stop, Fn&& fn) const
+    {
+        if (sorted)
+        {
+            sorted->tree.forRange(start, stop, fn);
+            return;
+        }
+        size_t pos = packed.seek(static_cast<long long>(2 * start));
+        for (size_t i = start; i <= stop; ++i, pos = packed.next(packed.next(pos)))
+        {
+            fn(packed.get(pos), unpackScore(packed.get(packed.next(pos))));
+        }
+    }
+
+    // One SCAN step over the member dictionary (Dict::scan): fn(member, score) for one bucket,
+    // or for every member of a listpack at once.  Returns the next cursor, 0 when done.
+    template <typename Fn> auto scan(uint64_t cursor, Fn&& fn) const -> uint64_t
+    {
+        if (sorted)
+        {
+            return sorted->scores.scan(cursor, [&](const auto& pair) { fn(std::string_view(pair.first), pair.second); });
+        }
+        if (!empty()) forRange(0, size() - 1, fn);
+        return 0;
+    }
+
+    // Redis reports its general encoding as "skiplist"; clients compare against that name
+    [[nodiscard]] auto encoding() const -> const char* { return sorted ? "skiplist" : "listpack"; }
+
+  private:
+    struct Sorted
+    {
+        DictMap<double> scores;
+        ScoreTree tree;
+    };
+
+    // Scores are packed as the 8 bytes of the double, so reading one back is a copy, not a parse
+    static auto packScore(double score, char (&bytes)[sizeof(double)]) -> std::string_view;
+    static auto unpackScore(std::string_view bytes) -> double;
+
+    // Position of the first member ordered after (score, member)
+    [[nodiscard]] auto packedPosition(double score, std::string_view member) const -> size_t;
+
+    void convert();
+
+    Listpack packed;                // member, score, ... in score order while small
+    std::unique_ptr<Sorted> sorted; // after conversion
+};
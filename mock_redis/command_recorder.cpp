@@ -0,0 +1,252 @@
+#include "command_recorder.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+std::atomic<bool> detail::commandRecording{false};
+
+namespace
+{
+constexpr char logMagic[8] = {'M', 'R', 'C', 'M', 'D', 'L', 'O', 'G'};
+
+struct Recorder
+{
+    std::mutex mutex;
+    std::FILE* file = nullptr;
+    std::chrono::steady_clock::time_point origin;
+
+    ~Recorder()
+    {
+        if (file != nullptr) std::fclose(file);
+    }
+};
+
+auto recorder() -> Recorder&
+{
+    static Recorder instance;
+    return instance;
+}
+
+// The record being assembled on this thread; reused, so steady state allocates nothing
+thread_local std::string scratch;
+thread_local uint32_t scratchArgs = 0;
+thread_local bool scratchReady = false; // recording may start between capture and write
+
+template <typename T> void put(std::string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putArg(std::string_view arg)
+{
+    put(scratch, static_cast<uint32_t>(arg.size()));
+    scratch.append(arg);
+    ++scratchArgs;
+}
+
+// Header fields, filled in by writeCommandRecord once the reply is known
+struct RecordHeader
+{
+    uint64_t nanos;
+    uint16_t format;
+    uint8_t replyType;
+    uint8_t reserved;
+    uint32_t argc;
+};
+static_assert(sizeof(RecordHeader) == 16);
+
+void beginRecord()
+{
+    scratch.assign(sizeof(RecordHeader), '\0');
+    scratchArgs = 0;
+    scratchReady = true;
+}
+
+// Bounds-checked cursor over the loaded file
+struct Reader
+{
+    const char* pos;
+    const char* end;
+
+    template <typename T> auto get(T& value) -> bool
+    {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) return false;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    auto bytes(size_t len, const char*& out) -> bool
+    {
+        if (static_cast<size_t>(end - pos) < len) return false;
+        out = pos;
+        pos += len;
+        return true;
+    }
+};
+} // namespace
+
+auto startCommandRecording(const char* path) -> bool
+{
+    Recorder& rec = recorder();
+    std::lock_guard lock(rec.mutex);
+    if (rec.file != nullptr)
+    {
+        return false;
+    }
+
+    rec.file = std::fopen(path, "wb");
+    if (rec.file == nullptr)
+    {
+        return false;
+    }
+    std::setvbuf(rec.file, nullptr, _IOFBF, 1 << 20);
+
+    std::string header(logMagic, sizeof(logMagic));
+    put(header, commandLogVersion);
+    auto commands = CommandRegistry::all();
+    put(header, static_cast<uint16_t>(commands.size()));
+    for (const CommandInfo& info : commands)
+    {
+        put(header, static_cast<uint16_t>(std::strlen(info.format)));
+        header.append(info.format);
+    }
+    std::fwrite(header.data(), 1, header.size(), rec.file);
+
+    rec.origin = std::chrono::steady_clock::now();
+    detail::commandRecording.store(true, std::memory_order_release);
+    return true;
+}
+
+void stopCommandRecording()
+{
+    Recorder& rec = recorder();
+    std::lock_guard lock(rec.mutex);
+    detail::commandRecording.store(false, std::memory_order_release);
+    if (rec.file != nullptr)
+    {
+        std::fclose(rec.file);
+        rec.file = nullptr;
+    }
+}
+
+void captureCommandArgs(const CommandInfo& info, va_list ap)
+{
+    beginRecord();
+    forEachVaArg(info.format, ap, [](std::string_view arg) { putArg(arg); });
+}
+
+void captureCommandArgs(const char** argv, const size_t* argvlen, size_t argc)
+{
+    beginRecord();
+    for (size_t i = 0; i < argc; ++i)
+    {
+        putArg(std::string_view(argv[i], argvlen != nullptr ? argvlen[i] : std::strlen(argv[i])));
+    }
+}
+
+void writeCommandRecord(const CommandInfo& info, std::chrono::steady_clock::time_point start, int replyType)
+{
+    if (!scratchReady)
+    {
+        return;
+    }
+    scratchReady = false;
+
+    Recorder& rec = recorder();
+    std::lock_guard lock(rec.mutex);
+    if (rec.file == nullptr)
+    {
+        return; // stopped while the command ran
+    }
+
+    RecordHeader header{};
+    header.nanos = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(start - rec.origin).count());
+    header.format = static_cast<uint16_t>(&info - CommandRegistry::all().data());
+    header.replyType = static_cast<uint8_t>(replyType);
+    header.argc = scratchArgs;
+
+    std::memcpy(scratch.data(), &header, sizeof(header));
+    std::fwrite(scratch.data(), 1, scratch.size(), rec.file);
+}
+
+auto loadCommandLog(const char* path) -> std::optional<CommandLog>
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        return std::nullopt;
+    }
+
+    CommandLog log;
+    log.bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    Reader r{log.bytes.data(), log.bytes.data() + log.bytes.size()};
+    const char* magic = nullptr;
+    uint32_t version = 0;
+    uint16_t formatCount = 0;
+    if (!r.bytes(sizeof(logMagic), magic) || std::memcmp(magic, logMagic, sizeof(logMagic)) != 0 ||
+        !r.get(version) || version != commandLogVersion || !r.get(formatCount))
+    {
+        return std::nullopt;
+    }
+
+    std::vector<const CommandInfo*> infos;
+    for (uint16_t i = 0; i < formatCount; ++i)
+    {
+        uint16_t len = 0;
+        const char* text = nullptr;
+        if (!r.get(len) || !r.bytes(len, text))
+        {
+            return std::nullopt;
+        }
+        log.formats.emplace_back(text, len);
+        infos.push_back(CommandRegistry::find(log.formats.back().c_str()));
+    }
+
+    // Records; a truncated tail (a recording that was not stopped) is ignored
+    for (;;)
+    {
+        RecordHeader header{};
+        if (!r.get(header) || header.format >= formatCount)
+        {
+            break;
+        }
+
+        LoggedCommand cmd{};
+        cmd.info = infos[header.format];
+        cmd.format = header.format;
+        cmd.nanos = header.nanos;
+        cmd.replyType = header.replyType;
+        cmd.firstArg = static_cast<uint32_t>(log.argPtrs.size());
+        cmd.argc = header.argc;
+
+        bool complete = true;
+        for (uint32_t i = 0; i < header.argc && complete; ++i)
+        {
+            uint32_t len = 0;
+            const char* arg = nullptr;
+            complete = r.get(len) && r.bytes(len, arg);
+            log.argPtrs.push_back(arg);
+            log.argLens.push_back(len);
+        }
+        if (!complete)
+        {
+            log.argPtrs.resize(cmd.firstArg);
+            log.argLens.resize(cmd.firstArg);
+            break;
+        }
+
+        // A command whose arity changed since recording cannot be replayed safely
+        if (cmd.info != nullptr && !cmd.info->acceptsArity(cmd.argc))
+        {
+            cmd.info = nullptr;
+        }
+        log.commands.push_back(cmd);
+    }
+    return log;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mock_redis.h"
+
+/*
+ * Command recording
+ * -----------------
+ *
+ * While recording is on, every dispatched command (format string, argv,
+ * pipeline and redis::execute) is appended to a compact binary log: which
+ * command, its arguments as raw bytes, the reply type and when it started.
+ * The `replay` tool loads such a log and re-drives it against the command
+ * table, flat out or at the recorded pacing.
+ *
+ * Log layout (native endianness):
+ *
+ *     "MRCMDLOG" u32 version
+ *     u16 formatCount, then per format: u16 length, bytes
+ *     records until EOF:
+ *         u64 nanos since recording started, u16 format index,
+ *         u8 reply type, u8 reserved (0), u32 argc,
+ *         then per argument: u32 length, bytes
+ *
+ * The format strings are written up front so a log stays usable after the
+ * command table changes: replay looks each one up again by format.
+ *
+ * Recording off costs one relaxed load per command.  Recording on costs an
+ * argument copy into a thread-local buffer and one locked fwrite per command.
+ */
+
+inline constexpr uint32_t commandLogVersion = 1;
+
+// Start appending to `path` (truncated).  False if it cannot be opened or a recording is already running.
+bool startCommandRecording(const char* path);
+
+// Flush and close the current log, if any
+void stopCommandRecording();
+
+namespace detail
+{
+extern std::atomic<bool> commandRecording;
+}
+
+inline auto isCommandRecording() -> bool
+{
+    return detail::commandRecording.load(std::memory_order_relaxed);
+}
+
+// Capture the arguments of the command about to run on this thread
+void captureCommandArgs(const CommandInfo& info, va_list ap);
+void captureCommandArgs(const char** argv, const size_t* argvlen, size_t argc);
+
+// Write the captured command with its start time and reply type
+void writeCommandRecord(const CommandInfo& info, std::chrono::steady_clock::time_point start, int replyType);
+
+// -------------------
+// Reading a log back
+// -------------------
+
+struct LoggedCommand
+{
+    const CommandInfo* info; // nullptr if the format is not registered in this build
+    uint32_t format;         // index into CommandLog::formats
+    uint64_t nanos;
+    int replyType;
+    uint32_t firstArg; // index into CommandLog::argPtrs / argLens
+    uint32_t argc;
+};
+
+// A whole log in memory, with argument pointers resolved up front so
+// replaying it touches nothing but the handlers
+struct CommandLog
+{
+    std::string bytes;
+    std::vector<std::string> formats;
+    std::vector<LoggedCommand> commands;
+    std::vector<const char*> argPtrs;
+    std::vector<size_t> argLens;
+};
+
+// nullopt if the file is missing, not a command log, or truncated mid-header
+auto loadCommandLog(const char* path) -> std::optional<CommandLog>;
@@ -0,0 +1,189 @@
+#include "command_stats.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+#include "command_table.h"
+#include "reply_pool.h"
+
+namespace
+{
+// One thread's counters for one command.  Only the owning thread writes, so a
+// relaxed load/store pair is enough; the atomics just make concurrent reads legal.
+struct CommandCounters
+{
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> errors;
+    std::atomic<uint64_t> replyBytes;
+    std::atomic<uint64_t> totalNanos;
+    std::array<std::atomic<uint64_t>, latencyBucketCount> histogram;
+};
+
+void bump(std::atomic<uint64_t>& counter, uint64_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+struct StatsRegistry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<CommandCounters[]>> blocks; // one per thread that recorded anything
+};
+
+// Never destroyed: threads may still record while statics are torn down
+auto registry() -> StatsRegistry&
+{
+    static auto* instance = new StatsRegistry;
+    return *instance;
+}
+
+thread_local CommandCounters* localBlock = nullptr;
+
+auto threadBlock() -> CommandCounters*
+{
+    if (localBlock == nullptr)
+    {
+        auto block = std::make_unique<CommandCounters[]>(CommandRegistry::all().size());
+        localBlock = block.get();
+
+        StatsRegistry& reg = registry();
+        std::lock_guard lock(reg.mutex);
+        reg.blocks.push_back(std::move(block));
+    }
+    return localBlock;
+}
+} // namespace
+
+auto CommandStats::percentile(double fraction) const -> uint64_t
+{
+    auto target = static_cast<uint64_t>(fraction * static_cast<double>(calls));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < histogram.size(); ++bucket)
+    {
+        seen += histogram[bucket];
+        if (seen > 0 && seen >= target)
+        {
+            return latencyBucketFloor(bucket);
+        }
+    }
+    return 0;
+}
+
+auto beginCommandSample() -> CommandSample
+{
+    return CommandSample{std::chrono::steady_clock::now(), replyBytesAllocated()};
+}
+
+void recordCommand(const CommandInfo& info, const CommandSample& sample, bool error)
+{
+    auto elapsed = std::chrono::steady_clock::now() - sample.start;
+    auto nanos = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+
+    CommandCounters& c = threadBlock()[&info - CommandRegistry::all().data()];
+    bump(c.calls, 1);
+    bump(c.errors, error ? 1 : 0);
+    bump(c.replyBytes, replyBytesAllocated() - sample.replyBytes);
+    bump(c.totalNanos, nanos);
+    bump(c.histogram[latencyBucketOf(nanos)], 1);
+}
+
+auto commandStats() -> std::vector<CommandStats>
+{
+    auto commands = CommandRegistry::all();
+
+    // Variants of one command (SET and its binary form SETB, LATENCY with and without a command
+    // name) share a row under the name clients send, so internal tags never show up in the output
+    std::vector<CommandStats> stats;
+    std::vector<size_t> rowOf(commands.size());
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        std::string_view name = commandNameOf(commands[i].format);
+        auto it = std::find_if(stats.begin(), stats.end(), [&](const CommandStats& s) { return s.name == name; });
+        if (it != stats.end())
+        {
+            rowOf[i] = static_cast<size_t>(it - stats.begin());
+            continue;
+        }
+
+        rowOf[i] = stats.size();
+        stats.push_back(
+            CommandStats{name, commands[i].format, 0, 0, 0, 0, std::vector<uint64_t>(latencyBucketCount, 0)});
+    }
+
+    StatsRegistry& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (const auto& block : reg.blocks)
+    {
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            const CommandCounters& c = block[i];
+            CommandStats& s = stats[rowOf[i]];
+            s.calls += c.calls.load(std::memory_order_relaxed);
+            s.errors += c.errors.load(std::memory_order_relaxed);
+            s.replyBytes += c.replyBytes.load(std::memory_order_relaxed);
+            s.totalNanos += c.totalNanos.load(std::memory_order_relaxed);
+            for (size_t b = 0; b < latencyBucketCount; ++b)
+            {
+                s.histogram[b] += c.histogram[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+    return stats;
+}
+
+void resetCommandStats()
+{
+    StatsRegistry& reg = registry();
+    std::lock_guard lock(reg.mutex);
+    for (const auto& block : reg.blocks)
+    {
+        for (size_t i = 0; i < CommandRegistry::all().size(); ++i)
+        {
+            CommandCounters& c = block[i];
+            c.calls.store(0, std::memory_order_relaxed);
+            c.errors.store(0, std::memory_order_relaxed);
+            c.replyBytes.store(0, std::memory_order_relaxed);
+            c.totalNanos.store(0, std::memory_order_relaxed);
+            for (auto& bucket : c.histogram)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+auto formatCommandStats() -> std::string
+{
+    std::string out = "# Commandstats\r\n";
+    for (const CommandStats& s : commandStats())
+    {
+        if (s.calls == 0)
+        {
+            continue;
+        }
+
+        std::string name(s.name);
+        for (char& ch : name)
+        {
+            ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+        }
+
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "cmdstat_%s:calls=%llu,usec=%llu,usec_per_call=%.2f,rejected_calls=0,failed_calls=%llu,"
+                      "reply_bytes=%llu,p50_usec=%.3f,p99_usec=%.3f\r\n",
+                      name.c_str(), static_cast<unsigned long long>(s.calls),
+                      static_cast<unsigned long long>(s.totalNanos / 1000),
+                      static_cast<double>(s.totalNanos) / 1000.0 / static_cast<double>(s.calls),
+                      static_cast<unsigned long long>(s.errors), static_cast<unsigned long long>(s.replyBytes),
+                      static_cast<double>(s.percentile(0.50)) / 1000.0,
+                      static_cast<double>(s.percentile(0.99)) / 1000.0);
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mock_redis.h"
+
+/*
+ * Command statistics
+ * ------------------
+ *
+ * Every dispatch path (format string, argv, pipeline, redis::execute) records
+ * each call against its command table entry: calls, error replies, reply bytes
+ * allocated from the reply pool, and the latency in an HDR-style histogram.
+ *
+ * Recording is lock-free.  Each thread owns a block of counters (one row per
+ * registered command) that only it writes, with plain relaxed loads and
+ * stores; readers merge every thread's block.  Blocks outlive their threads,
+ * so nothing recorded is lost.
+ *
+ * The histogram is log-linear: values below 8 ns get their own bucket, above
+ * that each power of two is split into 8 sub-buckets, so any reported value is
+ * within 12.5% of the true one.  Values past 2^40 ns (about 18 minutes) land in
+ * the last bucket.
+ *
+ * Exposed through the INFO commandstats and LATENCY HISTOGRAM commands and
+ * through `commandStats()` below.
+ */
+
+inline constexpr size_t latencySubBucketBits = 3;
+inline constexpr size_t latencySubBuckets = size_t{1} << latencySubBucketBits;
+inline constexpr size_t latencyMaxBits = 40;
+inline constexpr size_t latencyBucketCount = (latencyMaxBits - latencySubBucketBits + 1) * latencySubBuckets;
+
+// Histogram bucket for a latency in nanoseconds
+constexpr auto latencyBucketOf(uint64_t nanos) -> size_t
+{
+    if (nanos < latencySubBuckets)
+    {
+        return static_cast<size_t>(nanos);
+    }
+
+    size_t msb = static_cast<size_t>(std::bit_width(nanos)) - 1;
+    if (msb >= latencyMaxBits)
+    {
+        return latencyBucketCount - 1;
+    }
+
+    size_t sub = static_cast<size_t>(nanos >> (msb - latencySubBucketBits)) & (latencySubBuckets - 1);
+    return (msb - latencySubBucketBits + 1) * latencySubBuckets + sub;
+}
+
+// Smallest latency, in nanoseconds, that falls into `bucket`
+constexpr auto latencyBucketFloor(size_t bucket) -> uint64_t
+{
+    if (bucket < latencySubBuckets)
+    {
+        return bucket;
+    }
+
+    size_t msb = bucket / latencySubBuckets + latencySubBucketBits - 1;
+    uint64_t sub = bucket % latencySubBuckets;
+    return (latencySubBuckets + sub) << (msb - latencySubBucketBits);
+}
+
+static_assert(latencyBucketOf(latencyBucketFloor(100)) == 100);
+
+// Merged statistics for one command
+struct CommandStats
+{
+    std::string_view name; // the command as clients send it, e.g. "SET"
+    const char* format;    // its first format string; every variant of the command (SET %b) shares the row
+    uint64_t calls = 0;
+    uint64_t errors = 0;
+    uint64_t replyBytes = 0;
+    uint64_t totalNanos = 0;
+    std::vector<uint64_t> histogram; // latencyBucketCount counts
+
+    // Latency (bucket floor, ns) at or below which `fraction` of the calls completed
+    [[nodiscard]] auto percentile(double fraction) const -> uint64_t;
+};
+
+// Taken just before a handler runs
+struct CommandSample
+{
+    std::chrono::steady_clock::time_point start;
+    size_t replyBytes;
+};
+
+auto beginCommandSample() -> CommandSample;
+
+// Record one completed call of `info`
+void recordCommand(const CommandInfo& info, const CommandSample& sample, bool error);
+
+// One row per command name, in RegisteredCommands order, merged across threads
+auto commandStats() -> std::vector<CommandStats>;
+
+// Zero every counter (callers should be quiescent)
+void resetCommandStats();
+
+// INFO commandstats body, in Redis's "cmdstat_<name>:calls=...,usec=..." layout
+auto formatCommandStats() -> std::string;
@@ -0,0 +1,273 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string_view>
+
+/*
+ * Compile-time command table
+ * --------------------------
+ *
+ * The dispatcher used to hash every incoming format string into a
+ * std::unordered_map<std::string, CommandInfo> that was filled at static
+ * initialization time.  All Tags are known at compile time, so the table is
+ * now built by the compiler instead:
+ *
+ *   - `CommandList<Tags...>` names every registered Tag (see mock_redis_commands.h).
+ *   - `makeCommandTable` searches for a seed that maps every `Tag::format`
+ *     to a distinct slot of a power-of-two table (a perfect hash).
+ *   - `CommandTable::find` hashes the runtime format once, probes exactly one
+ *     slot and confirms the match with a single strcmp.  No heap is touched.
+ *   - `ArgvTable` does the same for argv calls, keyed by (name, arity).
+ */
+
+template <typename... Tags> struct CommandList
+{
+    static constexpr std::size_t size = sizeof...(Tags);
+};
+
+// FNV-1a, seeded so the table builder can search for a collision-free variant.
+constexpr auto hashCommandFormat(std::string_view s, std::uint64_t seed) -> std::uint64_t
+{
+    std::uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (char c : s)
+    {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+// Same hash over a NUL-terminated string, so lookups don't need a strlen pass first.
+inline auto hashCommandFormat(const char* s, std::uint64_t seed) -> std::uint64_t
+{
+    std::uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (; *s != '\0'; ++s)
+    {
+        h ^= static_cast<unsigned char>(*s);
+        h *= 1099511628211ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+// Argv lookups are keyed by (command name, arity).  Command names are
+// case-insensitive, so the name is folded to upper case while hashing.
+constexpr auto hashCommandName(std::string_view name, std::size_t arity, std::uint64_t seed) -> std::uint64_t
+{
+    std::uint64_t h = 14695981039346656037ULL ^ (seed * 0x9E3779B97F4A7C15ULL);
+    for (char c : name)
+    {
+        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ULL;
+    }
+    h ^= arity;
+    h *= 1099511628211ULL;
+    return h ^ (h >> 29);
+}
+
+// "SET %s %s" -> "SET"
+constexpr auto commandNameOf(std::string_view format) -> std::string_view
+{
+    return format.substr(0, format.find(' '));
+}
+
+constexpr auto equalsIgnoreCase(std::string_view a, std::string_view b) -> bool
+{
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+    {
+        char x = a[i];
+        char y = b[i];
+        if (x >= 'a' && x <= 'z') x = static_cast<char>(x - 'a' + 'A');
+        if (y >= 'a' && y <= 'z') y = static_cast<char>(y - 'a' + 'A');
+        if (x != y) return false;
+    }
+    return true;
+}
+
+constexpr auto commandTableSlots(std::size_t count) -> std::size_t
+{
+    // Four slots per command keeps the seed search short.
+    std::size_t slots = 1;
+    while (slots < count * 4)
+        slots <<= 1;
+    return slots;
+}
+
+template <typename Entry, std::size_t Count> struct CommandTable
+{
+    static constexpr std::size_t slotCount = commandTableSlots(Count);
+    static constexpr std::uint16_t emptySlot = 0xFFFF;
+
+    std::uint64_t seed = 0;
+    std::array<Entry, Count> entries{};
+    std::array<std::uint16_t, slotCount> slots{};
+
+    [[nodiscard]] auto find(const char* format) const -> const Entry*
+    {
+        std::uint16_t const index = slots[hashCommandFormat(format, seed) & (slotCount - 1)];
+        if (index == emptySlot) return nullptr;
+
+        const Entry& entry = entries[index];
+        return std::strcmp(entry.format, format) == 0 ? &entry : nullptr;
+    }
+
+    [[nodiscard]] auto all() const -> std::span<const Entry> { return entries; }
+};
+
+// Searches for a seed under which hashOf(i, seed) lands every key i < count
+// in a distinct slot.  Reaching the throw in a constant expression is a
+// compile error: either two keys are identical or the seed range needs widening.
+template <std::size_t SlotCount, typename HashOf>
+constexpr auto findPerfectHashSeed(std::size_t count, HashOf hashOf) -> std::uint64_t
+{
+    for (std::uint64_t seed = 0; seed < 4096; ++seed)
+    {
+        std::array<bool, SlotCount> used{};
+
+        bool collision = false;
+        for (std::size_t i = 0; i < count && !collision; ++i)
+        {
+            auto slot = hashOf(i, seed) & (SlotCount - 1);
+            collision = used[slot];
+            used[slot] = true;
+        }
+
+        if (!collision)
+        {
+            return seed;
+        }
+    }
+
+    throw "no perfect hash seed found for the command table";
+}
+
+// Builds the table from an array of entries, each exposing a `format` member.
+template <typename Entry, std::size_t Count>
+constexpr auto makeCommandTable(const std::array<Entry, Count>& entries) -> CommandTable<Entry, Count>
+{
+    using Table = CommandTable<Entry, Count>;
+    static_assert(Count < Table::emptySlot, "Too many commands for a 16-bit slot index");
+
+    Table table{};
+    table.entries = entries;
+    table.seed = findPerfectHashSeed<Table::slotCount>(
+        Count,
+        [&](std::size_t i, std::uint64_t seed)
+        { return hashCommandFormat(std::string_view(entries[i].format), seed); });
+
+    table.slots.fill(Table::emptySlot);
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        table.slots[hashCommandFormat(std::string_view(entries[i].format), table.seed) & (Table::slotCount - 1)] =
+            static_cast<std::uint16_t>(i);
+    }
+    return table;
+}
+
+// -------------------
+// Argv table
+// -------------------
+//
+// hiredis argv calls (redisCommandArgv, redisAppendCommandArgv) carry the
+// command name and its arguments but no format string.  This second table maps
+// (name, arity) to an index into the format-keyed table.  Several formats can
+// share a name and arity ("SET %s %s" and "SET %s %b"); argv arguments always
+// carry a length, so the first one listed is used.
+//
+// A variadic command (CommandInfo::isVariadic) is keyed by its name and
+// `variadicArity` instead of a count; findArgv probes that key when the exact
+// (name, arity) pair misses, then checks the count with acceptsArity.
+
+inline constexpr std::size_t variadicArity = ~std::size_t{0};
+
+template <typename Entry> constexpr auto argvArityOf(const Entry& entry) -> std::size_t
+{
+    return entry.isVariadic() ? variadicArity : entry.argTypes.size();
+}
+
+struct ArgvCommand
+{
+    std::string_view name;
+    std::size_t arity = 0;
+    std::uint16_t entry = 0; // index into CommandTable::entries
+};
+
+template <std::size_t Count> struct ArgvTable
+{
+    static constexpr std::size_t slotCount = commandTableSlots(Count);
+    static constexpr std::uint16_t emptySlot = 0xFFFF;
+
+    std::uint64_t seed = 0;
+    std::array<ArgvCommand, Count> commands{};
+    std::array<std::uint16_t, slotCount> slots{};
+
+    // Returns the CommandTable entry index, or emptySlot if there is no match
+    [[nodiscard]] auto find(std::string_view name, std::size_t arity) const -> std::uint16_t
+    {
+        std::uint16_t const index = slots[hashCommandName(name, arity, seed) & (slotCount - 1)];
+        if (index == emptySlot) return emptySlot;
+
+        const ArgvCommand& cmd = commands[index];
+        return (cmd.arity == arity && equalsIgnoreCase(cmd.name, name)) ? cmd.entry : emptySlot;
+    }
+};
+
+// Number of distinct (name, arity) pairs among the entries
+template <typename Entry, std::size_t Count>
+constexpr auto countArgvCommands(const std::array<Entry, Count>& entries) -> std::size_t
+{
+    std::size_t unique = 0;
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        bool seen = false;
+        for (std::size_t j = 0; j < i && !seen; ++j)
+        {
+            seen = commandNameOf(entries[j].format) == commandNameOf(entries[i].format) &&
+                   argvArityOf(entries[j]) == argvArityOf(entries[i]);
+        }
+        unique += seen ? 0 : 1;
+    }
+    return unique;
+}
+
+template <std::size_t ArgvCount, typename Entry, std::size_t Count>
+constexpr auto makeArgvTable(const std::array<Entry, Count>& entries) -> ArgvTable<ArgvCount>
+{
+    using Table = ArgvTable<ArgvCount>;
+
+    Table table{};
+    std::size_t next = 0;
+    for (std::size_t i = 0; i < Count; ++i)
+    {
+        ArgvCommand cmd{commandNameOf(entries[i].format), argvArityOf(entries[i]), static_cast<std::uint16_t>(i)};
+
+        bool seen = false;
+        for (std::size_t j = 0; j < next && !seen; ++j)
+        {
+            seen = table.commands[j].name == cmd.name && table.commands[j].arity == cmd.arity;
+        }
+        if (!seen)
+        {
+            table.commands[next++] = cmd;
+        }
+    }
+
+    table.seed = findPerfectHashSeed<Table::slotCount>(
+        ArgvCount,
+        [&](std::size_t i, std::uint64_t seed)
+        { return hashCommandName(table.commands[i].name, table.commands[i].arity, seed); });
+
+    table.slots.fill(Table::emptySlot);
+    for (std::size_t i = 0; i < ArgvCount; ++i)
+    {
+        const ArgvCommand& cmd = table.commands[i];
+        table.slots[hashCommandName(cmd.name, cmd.arity, table.seed) & (Table::slotCount - 1)] =
+            static_cast<std::uint16_t>(i);
+    }
+    return table;
+}
@@ -0,0 +1,578 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Dict
+ * ----
+ *
+ * Open-addressing hash table keyed by std::string, used for the keyspace and
+ * for hash and set values in place of std::unordered_map (one heap node per
+ * element, and a rehash that moves every element inside one command).
+ *
+ *   - Slots live in one flat array next to an array of control bytes, one
+ *     per slot: empty, deleted (a tombstone), or the low 7 bits of the key's
+ *     hash.  A probe loads a group of 8 control bytes as one 64-bit word and
+ *     finds every candidate in the group with a few integer operations
+ *     (SWAR, so no SIMD intrinsics are needed), then compares only those
+ *     keys.  Probing walks whole groups, triangularly.
+ *   - Erase leaves a tombstone unless the slot's group still has an empty
+ *     byte, in which case no probe ever continued past it and the slot can
+ *     simply become empty again.
+ *   - Growth is incremental, like Redis's dict: at 7/8 load a table twice
+ *     the size is allocated (the same size if the table is mostly
+ *     tombstones) and becomes the insert target, while every later insert
+ *     or erase moves a few groups across from the old one.  Lookups check
+ *     both tables until the old one is drained and freed.  No single
+ *     operation pays for moving the whole table.
+ *
+ * Lookups never move elements, so pointers and iterators stay valid until
+ * the next insert or erase (which may move them as part of a rehash step).
+ * SCAN-style walks that span modifications use scan(), whose cursor stays
+ * meaningful across rehashes.
+ *
+ *     DictMap<std::string> fields;
+ *     auto [it, inserted] = fields.emplace(field, value); // value built only if new
+ *     if (!inserted) it->second.assign(value);
+ */
+
+// Element layout and key access for a Dict of key/value pairs
+template <typename V> struct MapPolicy
+{
+    using value_type = std::pair<std::string, V>;
+
+    static auto key(const value_type& v) -> std::string_view { return v.first; }
+
+    template <typename... Args> static void construct(value_type* p, std::string_view key, Args&&... args)
+    {
+        ::new (static_cast<void*>(p)) value_type(std::piecewise_construct, std::forward_as_tuple(key),
+                                                 std::forward_as_tuple(std::forward<Args>(args)...));
+    }
+};
+
+// Element layout and key access for a Dict of bare keys (a set)
+struct SetPolicy
+{
+    using value_type = std::string;
+
+    static auto key(const value_type& v) -> std::string_view { return v; }
+
+    static void construct(value_type* p, std::string_view key) { ::new (static_cast<void*>(p)) value_type(key); }
+};
+
+template <typename Policy> class Dict
+{
+  public:
+    using value_type = typename Policy::value_type;
+
+    // Groups moved from the old table per insert or erase while rehashing
+    static constexpr size_t rehashGroupsPerStep = 4;
+
+    template <bool Const> class Iterator
+    {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type = typename Policy::value_type;
+        using reference = std::conditional_t<Const, const value_type&, value_type&>;
+        using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+        using DictPtr = std::conditional_t<Const, const Dict*, Dict*>;
+
+        Iterator() = default;
+        Iterator(DictPtr dict, unsigned which, size_t index) : dict(dict), which(which), index(index) { settle(); }
+
+        // iterator -> const_iterator
+        template <bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other) : dict(other.dict), which(other.which), index(other.index)
+        {
+        }
+
+        auto operator*() const -> reference { return dict->tables[which].slots[index]; }
+        auto operator->() const -> pointer { return &dict->tables[which].slots[index]; }
+
+        auto operator++() -> Iterator&
+        {
+            ++index;
+            settle();
+            return *this;
+        }
+
+        auto operator++(int) -> Iterator
+        {
+            Iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        friend auto operator==(const Iterator& a, const Iterator& b) -> bool
+        {
+            return a.which == b.which && a.index == b.index;
+        }
+
+      private:
+        friend class Dict;
+        template <bool> friend class Iterator;
+
+        // Advance to the next full slot: the old table first, then the current one
+        void settle()
+        {
+            while (which < 2)
+            {
+                const Table& t = dict->tables[which];
+                while (index < t.capacity && !isFull(t.ctrl[index]))
+                {
+                    ++index;
+                }
+                if (index < t.capacity) return;
+                ++which;
+                index = 0;
+            }
+        }
+
+        DictPtr dict = nullptr;
+        unsigned which = 2; // tables index; 2 is end()
+        size_t index = 0;
+    };
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    Dict() = default;
+
+    Dict(const Dict& other)
+    {
+        for (const value_type& v : other)
+        {
+            insertCopy(v);
+        }
+    }
+
+    Dict(Dict&& other) noexcept
+        : tables{std::exchange(other.tables[0], Table{}), std::exchange(other.tables[1], Table{})},
+          rehashGroup(std::exchange(other.rehashGroup, 0))
+    {
+    }
+
+    auto operator=(Dict other) noexcept -> Dict&
+    {
+        std::swap(tables, other.tables);
+        std::swap(rehashGroup, other.rehashGroup);
+        return *this;
+    }
+
+    ~Dict()
+    {
+        release(tables[0]);
+        release(tables[1]);
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return tables[0].size + tables[1].size; }
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    // Slots in the current table (the rehash target while rehashing)
+    [[nodiscard]] auto capacity() const -> size_t { return tables[current].capacity; }
+    [[nodiscard]] auto rehashing() const -> bool { return tables[old].capacity != 0; }
+
+    auto begin() -> iterator { return iterator(this, 0, 0); }
+    auto end() -> iterator { return iterator(this, 2, 0); }
+    auto begin() const -> const_iterator { return const_iterator(this, 0, 0); }
+    auto end() const -> const_iterator { return const_iterator(this, 2, 0); }
+
+    auto find(std::string_view key) -> iterator
+    {
+        size_t hash = hashOf(key);
+        for (unsigned which : {current, old})
+        {
+            if (size_t idx = findIn(tables[which], key, hash); idx != npos) return at(which, idx);
+        }
+        return end();
+    }
+
+    auto find(std::string_view key) const -> const_iterator { return const_cast<Dict*>(this)->find(key); }
+
+    [[nodiscard]] auto contains(std::string_view key) const -> bool { return find(key) != end(); }
+
+    // Insert key (with the value built from args) unless it is present; one probe sequence either way
+    template <typename... Args> auto emplace(std::string_view key, Args&&... args) -> std::pair<iterator, bool>
+    {
+        rehashStep();
+
+        size_t hash = hashOf(key);
+        if (size_t idx = findIn(tables[old], key, hash); idx != npos)
+        {
+            return {at(old, idx), false};
+        }
+
+        auto [idx, found] = findOrPrepareInsert(tables[current], key, hash);
+        if (found)
+        {
+            return {at(current, idx), false};
+        }
+
+        if (idx == npos)
+        {
+            grow();
+            idx = findInsertSlot(tables[current], hash);
+        }
+        Table& t = tables[current];
+        Policy::construct(t.slots + idx, key, std::forward<Args>(args)...);
+        setFull(t, idx, hash);
+        return {at(current, idx), true};
+    }
+
+    void erase(iterator it)
+    {
+        Table& t = tables[it.which];
+        std::destroy_at(t.slots + it.index);
+        clearSlot(t, it.index);
+        rehashStep();
+    }
+
+    auto erase(std::string_view key) -> size_t
+    {
+        auto it = find(key);
+        if (it == end()) return 0;
+        erase(it);
+        return 1;
+    }
+
+    // Visit the elements of `groups` groups from `cursor`, a group index into
+    // the current table (and the same range of the old one while rehashing).
+    // Returns the cursor to continue from; 0 once the end has been reached.
+    // fn must not insert or erase.
+    template <typename Fn> auto sweep(size_t cursor, size_t groups, Fn&& fn) const -> size_t
+    {
+        size_t total = std::max(tables[old].capacity, tables[current].capacity) / groupWidth;
+        if (cursor >= total) cursor = 0;
+        size_t end = std::min(cursor + groups, total);
+        for (const Table& t : tables)
+        {
+            for (size_t idx = cursor * groupWidth; idx < std::min(end * groupWidth, t.capacity); ++idx)
+            {
+                if (isFull(t.ctrl[idx])) fn(t.slots[idx]);
+            }
+        }
+        return end == total ? 0 : end;
+    }
+
+    // One step of a SCAN, after Redis's dictScan: fn(element) for every element whose home
+    // group is `cursor` (masked to the table), and while rehashing for every group that home
+    // splits into in the larger table.  Returns the cursor to continue from; 0 once done.
+    //
+    // The cursor counts with its bits reversed, so a scan that spans inserts, erases and
+    // rehashes still visits every element present for all of it, at the cost of sometimes
+    // reporting one twice.  Elements are matched by home group, not by slot, because
+    // probing may have put one a few groups along.  fn must not insert or erase.
+    template <typename Fn> auto scan(uint64_t cursor, Fn&& fn) const -> uint64_t
+    {
+        if (empty()) return 0;
+
+        const Table* small = &tables[current];
+        const Table* large = small;
+        if (rehashing())
+        {
+            small = &tables[old];
+            if (small->capacity > large->capacity) std::swap(small, large);
+        }
+        uint64_t smallMask = small->capacity / groupWidth - 1;
+        uint64_t largeMask = large->capacity / groupWidth - 1;
+
+        scanHome(*small, cursor & smallMask, fn);
+        if (small != large)
+        {
+            // Every home in the larger table whose low bits are this one
+            uint64_t v = cursor;
+            do
+            {
+                scanHome(*large, v & largeMask, fn);
+                v = (((v | smallMask) + 1) & ~smallMask) | (v & smallMask);
+            } while ((v & (smallMask ^ largeMask)) != 0);
+        }
+
+        cursor |= ~smallMask;
+        return reverseBits(reverseBits(cursor) + 1);
+    }
+
+  private:
+    static constexpr size_t groupWidth = 8;
+    static constexpr size_t npos = ~size_t{0};
+    static constexpr unsigned old = 0;
+    static constexpr unsigned current = 1;
+
+    static constexpr int8_t ctrlEmpty = -128;  // 0b10000000
+    static constexpr int8_t ctrlDeleted = -2; // 0b11111110
+    // Full slots hold the hash's low 7 bits, 0b0xxxxxxx
+
+    static constexpr uint64_t lsbs = 0x0101010101010101ULL;
+    static constexpr uint64_t msbs = 0x8080808080808080ULL;
+
+    struct Table
+    {
+        int8_t* ctrl = nullptr;
+        value_type* slots = nullptr;
+        size_t capacity = 0; // a power of two, at least groupWidth
+        size_t size = 0;
+        size_t growthLeft = 0; // empty slots that may still be filled before growing
+    };
+
+    static auto isFull(int8_t c) -> bool { return c >= 0; }
+    static auto hashOf(std::string_view key) -> size_t { return std::hash<std::string_view>{}(key); }
+    static auto h2(size_t hash) -> int8_t { return static_cast<int8_t>(hash & 0x7F); }
+    static auto maxLoad(size_t capacity) -> size_t { return capacity - capacity / 8; }
+
+    // The 8 control bytes of a group, first slot in the lowest byte
+    static auto loadGroup(const int8_t* ctrl) -> uint64_t
+    {
+        uint64_t word;
+        std::memcpy(&word, ctrl, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big)
+        {
+            uint64_t swapped = 0;
+            for (int i = 0; i < 8; ++i)
+            {
+                swapped = (swapped << 8) | ((word >> (8 * i)) & 0xFF);
+            }
+            word = swapped;
+        }
+        return word;
+    }
+
+    // One high bit per matching byte.  matchH2 may report a false positive
+    // next to a true match; candidates are confirmed by comparing keys.
+    static auto matchH2(uint64_t group, int8_t h) -> uint64_t
+    {
+        uint64_t x = group ^ (lsbs * static_cast<uint8_t>(h));
+        return (x - lsbs) & ~x & msbs;
+    }
+    static auto matchEmpty(uint64_t group) -> uint64_t { return group & ~(group << 6) & msbs; }
+    static auto matchEmptyOrDeleted(uint64_t group) -> uint64_t { return group & ~(group << 7) & msbs; }
+
+    static auto firstMatch(uint64_t mask) -> size_t { return static_cast<size_t>(std::countr_zero(mask)) / 8; }
+
+    static auto reverseBits(uint64_t v) -> uint64_t
+    {
+        v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+        v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+        v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        v = ((v >> 8) & 0x00FF00FF00FF00FFULL) | ((v & 0x00FF00FF00FF00FFULL) << 8);
+        v = ((v >> 16) & 0x0000FFFF0000FFFFULL) | ((v & 0x0000FFFF0000FFFFULL) << 16);
+        return (v >> 32) | (v << 32);
+    }
+
+    // fn(element) for the elements of t whose probe sequence starts at group `home`.  They all
+    // lie on that sequence before the first group with an empty slot, where a lookup stops too.
+    template <typename Fn> static void scanHome(const Table& t, size_t home, Fn& fn)
+    {
+        if (t.size == 0) return;
+
+        size_t groupMask = t.capacity / groupWidth - 1;
+        size_t g = home;
+        for (size_t step = 1; step <= groupMask + 1; ++step)
+        {
+            for (size_t idx = g * groupWidth; idx < (g + 1) * groupWidth; ++idx)
+            {
+                if (isFull(t.ctrl[idx]) && ((hashOf(Policy::key(t.slots[idx])) >> 7) & groupMask) == home)
+                {
+                    fn(t.slots[idx]);
+                }
+            }
+            if (matchEmpty(loadGroup(t.ctrl + g * groupWidth)) != 0) return;
+            g = (g + step) & groupMask;
+        }
+    }
+
+    auto at(unsigned which, size_t idx) -> iterator
+    {
+        iterator it;
+        it.dict = this;
+        it.which = which;
+        it.index = idx;
+        return it;
+    }
+
+    static auto findIn(const Table& t, std::string_view key, size_t hash) -> size_t
+    {
+        if (t.size == 0) return npos;
+
+        size_t groupMask = t.capacity / groupWidth - 1;
+        size_t g = (hash >> 7) & groupMask;
+        for (size_t step = 1;; ++step)
+        {
+            uint64_t group = loadGroup(t.ctrl + g * groupWidth);
+            for (uint64_t m = matchH2(group, h2(hash)); m != 0; m &= m - 1)
+            {
+                size_t idx = g * groupWidth + firstMatch(m);
+                if (Policy::key(t.slots[idx]) == key) return idx;
+            }
+            if (matchEmpty(group) != 0) return npos;
+            g = (g + step) & groupMask;
+        }
+    }
+
+    // {slot, true} if key is present, else {first reusable slot on its probe path, false};
+    // the slot is npos when only a fresh empty slot remains and the table has no growth left
+    static auto findOrPrepareInsert(const Table& t, std::string_view key, size_t hash) -> std::pair<size_t, bool>
+    {
+        if (t.capacity == 0) return {npos, false};
+
+        size_t groupMask = t.capacity / groupWidth - 1;
+        size_t g = (hash >> 7) & groupMask;
+        size_t candidate = npos;
+        for (size_t step = 1;; ++step)
+        {
+            uint64_t group = loadGroup(t.ctrl + g * groupWidth);
+            for (uint64_t m = matchH2(group, h2(hash)); m != 0; m &= m - 1)
+            {
+                size_t idx = g * groupWidth + firstMatch(m);
+                if (Policy::key(t.slots[idx]) == key) return {idx, true};
+            }
+            if (uint64_t free = matchEmptyOrDeleted(group); free != 0 && candidate == npos)
+            {
+                candidate = g * groupWidth + firstMatch(free);
+            }
+            if (matchEmpty(group) != 0) break;
+            g = (g + step) & groupMask;
+        }
+
+        // Reusing a tombstone costs no growth; a fresh empty slot needs some
+        if (candidate != npos && t.ctrl[candidate] == ctrlEmpty && t.growthLeft == 0) candidate = npos;
+        return {candidate, false};
+    }
+
+    static auto findInsertSlot(const Table& t, size_t hash) -> size_t
+    {
+        size_t groupMask = t.capacity / groupWidth - 1;
+        size_t g = (hash >> 7) & groupMask;
+        for (size_t step = 1;; ++step)
+        {
+            if (uint64_t free = matchEmptyOrDeleted(loadGroup(t.ctrl + g * groupWidth)); free != 0)
+            {
+                return g * groupWidth + firstMatch(free);
+            }
+            g = (g + step) & groupMask;
+        }
+    }
+
+    static void setFull(Table& t, size_t idx, size_t hash)
+    {
+        if (t.ctrl[idx] == ctrlEmpty) --t.growthLeft;
+        t.ctrl[idx] = h2(hash);
+        ++t.size;
+    }
+
+    // Mark an already destroyed slot free
+    static void clearSlot(Table& t, size_t idx)
+    {
+        size_t groupStart = idx & ~(groupWidth - 1);
+        if (matchEmpty(loadGroup(t.ctrl + groupStart)) != 0)
+        {
+            t.ctrl[idx] = ctrlEmpty;
+            ++t.growthLeft;
+        }
+        else
+        {
+            t.ctrl[idx] = ctrlDeleted;
+        }
+        --t.size;
+    }
+
+    static auto allocate(size_t capacity) -> Table
+    {
+        Table t;
+        t.ctrl = new int8_t[capacity];
+        std::memset(t.ctrl, ctrlEmpty, capacity);
+        t.slots = std::allocator<value_type>().allocate(capacity);
+        t.capacity = capacity;
+        t.growthLeft = maxLoad(capacity);
+        return t;
+    }
+
+    static void release(Table& t)
+    {
+        for (size_t i = 0; i < t.capacity; ++i)
+        {
+            if (isFull(t.ctrl[i])) std::destroy_at(t.slots + i);
+        }
+        if (t.capacity != 0)
+        {
+            std::allocator<value_type>().deallocate(t.slots, t.capacity);
+            delete[] t.ctrl;
+        }
+        t = Table{};
+    }
+
+    // Start moving into a fresh table; only called once the previous rehash is done
+    void grow()
+    {
+        while (rehashing())
+        {
+            rehashStep();
+        }
+
+        Table& t = tables[current];
+        size_t capacity = groupWidth;
+        if (t.capacity != 0)
+        {
+            // Mostly tombstones: rebuild at the same size rather than doubling
+            capacity = t.size * 2 <= maxLoad(t.capacity) ? t.capacity : t.capacity * 2;
+        }
+
+        tables[old] = std::exchange(t, allocate(capacity));
+        rehashGroup = 0;
+        if (tables[old].size == 0) release(tables[old]);
+    }
+
+    void rehashStep()
+    {
+        if (!rehashing()) return;
+
+        Table& from = tables[old];
+        Table& to = tables[current];
+        size_t groups = from.capacity / groupWidth;
+        for (size_t n = 0; n < rehashGroupsPerStep && rehashGroup < groups; ++n, ++rehashGroup)
+        {
+            for (size_t idx = rehashGroup * groupWidth; idx < (rehashGroup + 1) * groupWidth; ++idx)
+            {
+                if (!isFull(from.ctrl[idx])) continue;
+
+                size_t hash = hashOf(Policy::key(from.slots[idx]));
+                size_t dest = findInsertSlot(to, hash);
+                ::new (static_cast<void*>(to.slots + dest)) value_type(std::move(from.slots[idx]));
+                setFull(to, dest, hash);
+                std::destroy_at(from.slots + idx);
+                // A tombstone, never empty: unmigrated keys may probe past this group
+                from.ctrl[idx] = ctrlDeleted;
+                --from.size;
+            }
+        }
+
+        if (rehashGroup == groups || from.size == 0) release(from);
+    }
+
+    void insertCopy(const value_type& v)
+    {
+        if constexpr (std::is_same_v<value_type, std::string>)
+            emplace(v);
+        else
+            emplace(v.first, v.second);
+    }
+
+    Table tables[2];         // [old] drains into [current] while rehashing
+    size_t rehashGroup = 0; // next group of the old table to migrate
+};
+
+template <typename V> using DictMap = Dict<MapPolicy<V>>;
+using DictSet = Dict<SetPolicy>;
@@ -0,0 +1,198 @@
+// hiredis_shim.cpp : In-process replacement for the hiredis client library.
+//
+// Link the mock_hiredis target instead of hiredis::hiredis and the usual
+// hiredis entry points run against the in-process command table: no sockets,
+// no RESP encoding, no server.  Only the synchronous API is provided,
+// including pipelining through redisAppendCommand* / redisGetReply.
+
+#include <cstdarg>
+#include <cstring>
+#include <deque>
+#include <new>
+#include <string>
+
+#include "command_table.h"
+#include "hiredis/hiredis.h"
+#include "mock_redis.h"
+#include "pipeline.h"
+
+namespace
+{
+// Per-connection state.  hiredis callers only ever see the redisContext, which
+// must stay the first member so the two pointers convert back and forth.
+struct MockContext
+{
+    redisContext base;
+
+    CommandPipeline pipeline;         // appended, not yet executed
+    std::deque<redisReply*> replies; // executed, not yet read
+
+    [[nodiscard]] auto hasPending() const -> bool { return !pipeline.empty() || !replies.empty(); }
+};
+
+auto toMock(redisContext* c) -> MockContext*
+{
+    return reinterpret_cast<MockContext*>(c);
+}
+
+// hiredis reports server-side errors as error replies, not as a null return
+auto unknownCommandReply(std::string_view name) -> redisReply*
+{
+    return createErrorReply(CommandRegistry::lookupError(name).c_str());
+}
+} // namespace
+
+extern "C"
+{
+    redisContext* redisConnect(const char* /*ip*/, int port)
+    {
+        auto* mock = new (std::nothrow) MockContext{};
+        if (mock == nullptr)
+        {
+            return nullptr;
+        }
+
+        redisContext* c = &mock->base;
+        c->fd = -1;
+        c->connection_type = REDIS_CONN_TCP;
+        c->tcp.port = port;
+        return c;
+    }
+
+    void redisFree(redisContext* c)
+    {
+        if (c == nullptr)
+        {
+            return;
+        }
+
+        for (redisReply* reply : toMock(c)->replies)
+        {
+            releaseRedisReply(reply);
+        }
+        delete toMock(c);
+    }
+
+    void* redisvCommand(redisContext* c, const char* format, va_list ap)
+    {
+        if (c == nullptr || format == nullptr)
+        {
+            return nullptr;
+        }
+
+        // Like hiredis, a blocking call behind a pipeline queues the command and
+        // returns the oldest unread reply
+        if (toMock(c)->hasPending())
+        {
+            void* reply = nullptr;
+            if (redisvAppendCommand(c, format, ap) != REDIS_OK) return nullptr;
+            return redisGetReply(c, &reply) == REDIS_OK ? reply : nullptr;
+        }
+
+        redisReply* reply = redisCommandFromVaList(format, ap);
+        return reply != nullptr ? reply : unknownCommandReply(commandNameOf(format));
+    }
+
+    void* redisCommand(redisContext* c, const char* format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        void* reply = redisvCommand(c, format, ap);
+        va_end(ap);
+        return reply;
+    }
+
+    void* redisCommandArgv(redisContext* c, int argc, const char** argv, const size_t* argvlen)
+    {
+        if (c == nullptr || argc < 1 || argv == nullptr)
+        {
+            return nullptr;
+        }
+
+        if (toMock(c)->hasPending())
+        {
+            void* reply = nullptr;
+            if (redisAppendCommandArgv(c, argc, argv, argvlen) != REDIS_OK) return nullptr;
+            return redisGetReply(c, &reply) == REDIS_OK ? reply : nullptr;
+        }
+
+        redisReply* reply = redisCommandFromArgv(argc, argv, argvlen);
+        if (reply != nullptr)
+        {
+            return reply;
+        }
+        return unknownCommandReply(std::string_view(argv[0], argvlen != nullptr ? argvlen[0] : strlen(argv[0])));
+    }
+
+    int redisvAppendCommand(redisContext* c, const char* format, va_list ap)
+    {
+        if (c == nullptr || format == nullptr)
+        {
+            return REDIS_ERR;
+        }
+
+        toMock(c)->pipeline.append(format, ap);
+        return REDIS_OK;
+    }
+
+    int redisAppendCommand(redisContext* c, const char* format, ...)
+    {
+        va_list ap;
+        va_start(ap, format);
+        int status = redisvAppendCommand(c, format, ap);
+        va_end(ap);
+        return status;
+    }
+
+    int redisAppendCommandArgv(redisContext* c, int argc, const char** argv, const size_t* argvlen)
+    {
+        if (c == nullptr || argc < 1 || argv == nullptr)
+        {
+            return REDIS_ERR;
+        }
+
+        toMock(c)->pipeline.appendArgv(argc, argv, argvlen);
+        return REDIS_OK;
+    }
+
+    // The first read after a run of appends executes the whole batch
+    int redisGetReply(redisContext* c, void** reply)
+    {
+        if (c == nullptr)
+        {
+            return REDIS_ERR;
+        }
+
+        MockContext* mock = toMock(c);
+        if (mock->replies.empty() && !mock->pipeline.empty())
+        {
+            mock->pipeline.execute(mock->replies);
+        }
+
+        if (mock->replies.empty())
+        {
+            // A real client would block on the socket here; there is nothing to wait for
+            c->err = REDIS_ERR_OTHER;
+            std::strncpy(c->errstr, "No pending replies", sizeof(c->errstr) - 1);
+            if (reply != nullptr) *reply = nullptr;
+            return REDIS_ERR;
+        }
+
+        redisReply* next = mock->replies.front();
+        mock->replies.pop_front();
+        if (reply != nullptr)
+        {
+            *reply = next;
+        }
+        else
+        {
+            releaseRedisReply(next);
+        }
+        return REDIS_OK;
+    }
+
+    void freeReplyObject(void* reply)
+    {
+        releaseRedisReply(static_cast<redisReply*>(reply));
+    }
+}
@@ -0,0 +1,165 @@
+#include "intset.h"
+
+#include <algorithm>
+#include <charconv>
+#include <limits>
+
+namespace
+{
+// Variant index of the narrowest array that can hold value
+auto widthIndex(int64_t value) -> size_t
+{
+    if (value >= std::numeric_limits<int16_t>::min() && value <= std::numeric_limits<int16_t>::max()) return 0;
+    if (value >= std::numeric_limits<int32_t>::min() && value <= std::numeric_limits<int32_t>::max()) return 1;
+    return 2;
+}
+
+template <typename T> auto containsSorted(const T* base, size_t n, T value) -> bool
+{
+    constexpr size_t block = 64 / sizeof(T);
+
+    // Every step keeps value, if present, inside [base, base + n)
+    while (n > block)
+    {
+        size_t half = n / 2;
+        base = base[half] <= value ? base + half : base;
+        n -= half;
+    }
+
+    // Bitwise or, not ||, so the loop has no early exit and vectorizes
+    bool found = false;
+    for (size_t i = 0; i < n; ++i)
+    {
+        found |= base[i] == value;
+    }
+    return found;
+}
+
+// Merge ascending values against the ascending array b, keeping each value whose presence in b is
+// `common`.  Writes never pass reads, so out may be values itself.
+template <typename T>
+auto retainSorted(const int64_t* values, size_t n, const T* b, size_t nb, bool common, int64_t* out) -> size_t
+{
+    constexpr size_t block = 64 / sizeof(T);
+
+    size_t kept = 0;
+    size_t j = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        int64_t value = values[i];
+
+        // Whole blocks below value are skipped on their last element alone
+        while (j + block <= nb && b[j + block - 1] < value)
+        {
+            j += block;
+        }
+
+        // Then one pass over the block value falls in, with no early exit so it vectorizes: how many
+        // of it are below value (b advances past those) and whether value is there
+        size_t len = std::min(block, nb - j);
+        size_t below = 0;
+        bool found = false;
+        for (size_t m = 0; m < len; ++m)
+        {
+            below += b[j + m] < value ? 1 : 0;
+            found |= b[j + m] == value;
+        }
+        j += below;
+
+        out[kept] = value;
+        kept += found == common ? 1 : 0;
+    }
+    return kept;
+}
+} // namespace
+
+auto IntSet::parse(std::string_view s, int64_t& value) -> bool
+{
+    if (s.empty() || s.size() > 20) return false;
+
+    // Reject forms that would not read back the same: leading zeros and "-0"
+    size_t digits = s[0] == '-' ? 1 : 0;
+    if (digits == s.size() || (s[digits] == '0' && s.size() > 1)) return false;
+
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && end == s.data() + s.size();
+}
+
+auto IntSet::contains(int64_t value) const -> bool
+{
+    if (widthIndex(value) > values.index()) return false;
+
+    return std::visit(
+        [value](const auto& vec)
+        {
+            using T = typename std::decay_t<decltype(vec)>::value_type;
+            return containsSorted(vec.data(), vec.size(), static_cast<T>(value));
+        },
+        values);
+}
+
+auto IntSet::add(int64_t value) -> bool
+{
+    // A value too wide for the array cannot already be in it
+    if (widthIndex(value) > values.index()) upgrade(widthIndex(value));
+
+    return std::visit(
+        [value](auto& vec)
+        {
+            using T = typename std::decay_t<decltype(vec)>::value_type;
+            auto it = std::lower_bound(vec.begin(), vec.end(), static_cast<T>(value));
+            if (it != vec.end() && *it == value) return false;
+            vec.insert(it, static_cast<T>(value));
+            return true;
+        },
+        values);
+}
+
+auto IntSet::remove(int64_t value) -> bool
+{
+    if (widthIndex(value) > values.index()) return false;
+
+    return std::visit(
+        [value](auto& vec)
+        {
+            using T = typename std::decay_t<decltype(vec)>::value_type;
+            auto it = std::lower_bound(vec.begin(), vec.end(), static_cast<T>(value));
+            if (it == vec.end() || *it != value) return false;
+            vec.erase(it);
+            return true;
+        },
+        values);
+}
+
+auto IntSet::retainCommon(int64_t* candidates, size_t n) const -> size_t
+{
+    return std::visit([&](const auto& vec)
+                      { return retainSorted(candidates, n, vec.data(), vec.size(), true, candidates); },
+                      values);
+}
+
+auto IntSet::retainMissing(int64_t* candidates, size_t n) const -> size_t
+{
+    return std::visit([&](const auto& vec)
+                      { return retainSorted(candidates, n, vec.data(), vec.size(), false, candidates); },
+                      values);
+}
+
+void IntSet::upgrade(size_t index)
+{
+    auto widen = [this](auto wider)
+    {
+        wider.reserve(size() + 1);
+        forEach([&](int64_t value) { wider.push_back(static_cast<typename decltype(wider)::value_type>(value)); });
+        values = std::move(wider);
+    };
+
+    if (index == 1)
+    {
+        widen(std::vector<int32_t>());
+    }
+    else
+    {
+        widen(std::vector<int64_t>());
+    }
+}
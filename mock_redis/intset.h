@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+/*
+ * IntSet
+ * ------
+ *
+ * A set of integers kept as one sorted array, after Redis's intset.  Sets
+ * whose members all parse as integers (user ids and the like) are stored
+ * this way (see collections.h): 2, 4 or 8 bytes a member instead of a
+ * std::string and a hash slot.
+ *
+ *   - The array starts 16 bits wide and is rewritten 32 or 64 bits wide the
+ *     first time a value does not fit.  It never narrows again.
+ *   - Membership is a branchless binary search (the compare feeds a
+ *     conditional move, not a branch) down to one 64-byte block, then a
+ *     compare of every value in the block, written so the compiler turns it
+ *     into vector compares.  No intrinsics, so it builds anywhere.
+ *   - Insertion and removal shift the tail of the array, which is fine at
+ *     the sizes intsets are used for (set-max-intset-entries).
+ *   - SINTER and SDIFF over intsets (mock_redis_set.cpp) merge sorted
+ *     arrays: each candidate skips whole 64-byte blocks of this set, then
+ *     is compared against one block at a time in the same vectorizable way
+ *     as a membership test.
+ *
+ * Only canonical decimal strings count as integers ("12", not "012" or
+ * "+12"), so a member reads back exactly as it was written.
+ */
+class IntSet
+{
+  public:
+    [[nodiscard]] auto size() const -> size_t
+    {
+        return std::visit([](const auto& vec) { return vec.size(); }, values);
+    }
+    [[nodiscard]] auto empty() const -> bool { return size() == 0; }
+
+    // Bytes per member: 2, 4 or 8
+    [[nodiscard]] auto width() const -> size_t { return size_t{2} << values.index(); }
+
+    [[nodiscard]] auto contains(int64_t value) const -> bool;
+
+    // True if value was not already present
+    auto add(int64_t value) -> bool;
+
+    auto remove(int64_t value) -> bool;
+
+    // Keep the candidates[0, n) that are also in this set (retainCommon) or are not (retainMissing),
+    // compacted to the front in order; candidates must be ascending.  Returns how many were kept.
+    auto retainCommon(int64_t* candidates, size_t n) const -> size_t;
+    auto retainMissing(int64_t* candidates, size_t n) const -> size_t;
+
+    // fn(int64_t) in ascending order
+    template <typename Fn> void forEach(Fn&& fn) const
+    {
+        std::visit(
+            [&](const auto& vec)
+            {
+                for (auto value : vec)
+                {
+                    fn(static_cast<int64_t>(value));
+                }
+            },
+            values);
+    }
+
+    // Parse a canonical decimal integer; false for anything else
+    static auto parse(std::string_view s, int64_t& value) -> bool;
+
+  private:
+    // Rewrite the array at the width with this variant index
+    void upgrade(size_t index);
+
+    std::variant<std::vector<int16_t>, std::vector<int32_t>, std::vector<int64_t>> values;
+};
@@ -0,0 +1,198 @@
+#include "keyspace.h"
+
+namespace
+{
+// Volatile keys examined per step of an active cycle, as in Redis
+constexpr size_t expireSampleKeys = 20;
+
+// An active cycle keeps going while more than 1 in this many examined keys had expired
+constexpr size_t acceptableStale = 10;
+
+// Expired keys found by one sweep step; collected first because erasing may move entries mid-sweep
+thread_local std::vector<std::string> staleKeys;
+
+// Assign a string value, reusing the existing string's buffer when there is one
+void assignString(KeyEntry& entry, std::string_view value)
+{
+    if (auto* str = std::get_if<StringValue>(&entry.value))
+    {
+        str->assign(value);
+    }
+    else
+    {
+        entry.value.emplace<StringValue>(value);
+    }
+}
+} // namespace
+
+auto Keyspace::isExpired(std::string_view key) const -> bool
+{
+    const Expiry* when = expiryOf(key);
+    return when != nullptr && commandNow() > *when;
+}
+
+auto Keyspace::find(std::string_view key) -> KeyEntry*
+{
+    auto it = dict.find(key);
+    if (it == dict.end())
+    {
+        return nullptr;
+    }
+
+    if (it->second.hasExpiry && isExpired(key))
+    {
+        expires.erase(key);
+        dict.erase(it);
+        ++expiredKeys;
+        return nullptr;
+    }
+    return &it->second;
+}
+
+// Insert or overwrite a value; the key is only copied when it is new
+void Keyspace::setString(std::string_view key, std::string_view value)
+{
+    auto [it, inserted] = dict.emplace(key);
+    assignString(it->second, value);
+    if (it->second.hasExpiry)
+    {
+        expires.erase(key);
+        it->second.hasExpiry = false;
+    }
+}
+
+void Keyspace::setString(std::string_view key, std::string_view value, Expiry when)
+{
+    auto [it, inserted] = dict.emplace(key);
+    assignString(it->second, value);
+    it->second.hasExpiry = true;
+
+    auto [expiry, added] = expires.emplace(key, when);
+    if (!added) expiry->second = when;
+}
+
+auto Keyspace::expire(std::string_view key, Expiry when) -> bool
+{
+    KeyEntry* entry = find(key);
+    if (entry == nullptr)
+    {
+        return false;
+    }
+
+    entry->hasExpiry = true;
+    auto [expiry, added] = expires.emplace(key, when);
+    if (!added) expiry->second = when;
+    return true;
+}
+
+auto Keyspace::expiryOf(std::string_view key) const -> const Expiry*
+{
+    auto it = expires.find(key);
+    return it != expires.end() ? &it->second : nullptr;
+}
+
+auto Keyspace::erase(std::string_view key) -> bool
+{
+    auto it = dict.find(key);
+    if (it == dict.end())
+    {
+        return false;
+    }
+
+    bool live = true;
+    if (it->second.hasExpiry)
+    {
+        live = !isExpired(key);
+        expires.erase(key);
+    }
+    dict.erase(it);
+    return live;
+}
+
+auto Keyspace::activeExpireCycle(std::chrono::microseconds budget) -> size_t
+{
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + budget;
+    refreshCommandClock(start); // hosts may call this outside any dispatch
+    auto now = commandNow();
+
+    std::vector<std::string>& stale = staleKeys;
+    size_t deleted = 0;
+    expireBacklog = false;
+    while (!expires.empty())
+    {
+        size_t examined = 0;
+        stale.clear();
+        do
+        {
+            expireCursor = expires.sweep(expireCursor, 1,
+                                         [&](const std::pair<std::string, Expiry>& e)
+                                         {
+                                             ++examined;
+                                             if (now > e.second) stale.push_back(e.first);
+                                         });
+        } while (examined < expireSampleKeys && expireCursor != 0);
+
+        for (const std::string& key : stale)
+        {
+            expires.erase(key);
+            dict.erase(key);
+        }
+        deleted += stale.size();
+
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            expireBacklog = !stale.empty();
+            break;
+        }
+        // Few stale keys in the sample: the rest of the dictionary is probably clean too
+        if (stale.size() * acceptableStale <= examined)
+        {
+            break;
+        }
+    }
+
+    expiredKeys += deleted;
+    return deleted;
+}
+
+void Keyspace::runExpireCycle()
+{
+    activeExpireCycle(expireCycleBudget);
+    nextExpireCycle = commandNow() + (expireBacklog ? expireBacklogInterval : expireCycleInterval);
+}
+
+auto keyspace() -> Keyspace&
+{
+    static Keyspace instance;
+    return instance;
+}
+
+auto commandMutex() -> std::mutex&
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+auto typeName(ValueType type) -> const char*
+{
+    switch (type)
+    {
+    case ValueType::String:
+        return "string";
+    case ValueType::List:
+        return "list";
+    case ValueType::Set:
+        return "set";
+    case ValueType::Hash:
+        return "hash";
+    case ValueType::ZSet:
+        return "zset";
+    }
+    return "none";
+}
+
+auto encodingName(const KeyEntry& entry) -> const char*
+{
+    return std::visit([](const auto& value) { return value.encoding(); }, entry.value);
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+
+#include "clock.h"
+#include "collections.h"
+#include "dict.h"
+#include "mock_redis.h"
+
+/*
+ * Keyspace
+ * --------
+ *
+ * Every key lives in one dictionary (dict.h), whatever its type.  An entry
+ * carries the value (the variant index is the type tag) and a flag saying
+ * whether the key has a TTL, so a command finds its key and checks its type
+ * with a single hash probe.
+ *
+ *   - A command on a key of another type gets WRONGTYPE
+ *     (createWrongTypeReply) instead of silently creating a second key.
+ *   - A collection whose last element is removed is deleted, so an existing
+ *     key is never an empty list, set or hash.
+ *   - Entries move when the dictionary rehashes, so a pointer from a lookup
+ *     is only good until the next insert or erase.
+ *
+ *     auto [list, wrongType] = keyspace().find<ListValue>(key);
+ *     if (wrongType) return createWrongTypeReply();
+ *     if (list == nullptr) return createNilReply();
+ *
+ * Expiry
+ * ------
+ *
+ * Expiry times live in a second dictionary holding only the volatile keys,
+ * so persistent keys carry no timestamp and their lookups never touch it.
+ * Keys are expired two ways, as in Redis:
+ *
+ *   - Lazily: a lookup that lands on an expired key deletes it and reports
+ *     it missing.
+ *   - Actively: activeExpireCycle walks the expires dictionary about 20
+ *     keys at a time from a persistent cursor and deletes what has expired.
+ *     It keeps going while more than 10% of the keys it looks at are stale,
+ *     and stops when its time budget runs out.  The dispatcher calls cron()
+ *     after every command, which runs a cycle every 100 ms, or every 10 ms
+ *     while the previous cycle ran out of time with stale keys left.
+ *
+ * Expiry times and "now" come from the per-command cached monotonic clock
+ * (clock.h), so tests can drive both kinds of expiry with virtual time.
+ *
+ * Commands run one at a time: every dispatcher holds commandMutex() for the
+ * whole command, as a single-threaded server would run them.  The keyspace
+ * itself is therefore unsynchronized, and the cycle runs on the dispatching
+ * thread between commands rather than on a thread of its own.  A host that
+ * goes idle with volatile keys outstanding can call activeExpireCycle
+ * itself, holding the mutex.  Blocking pops (blocking.h) release it while
+ * they wait.
+ */
+
+using Expiry = MonotonicTime; // on the command clock (clock.h)
+
+// In variant order
+enum class ValueType : unsigned char
+{
+    String,
+    List,
+    Set,
+    Hash,
+    ZSet,
+};
+
+struct KeyEntry
+{
+    std::variant<StringValue, ListValue, SetValue, HashValue, ZSetValue> value;
+    bool hasExpiry = false; // the key is in the expires dictionary
+
+    [[nodiscard]] auto type() const -> ValueType { return static_cast<ValueType>(value.index()); }
+};
+
+// Result of a typed lookup: `value` is null when the key is missing or holds another type
+template <typename T> struct TypedLookup
+{
+    T* value;
+    bool wrongType;
+};
+
+class Keyspace
+{
+  public:
+    // Longest one active expiry cycle may run from cron()
+    static constexpr std::chrono::microseconds expireCycleBudget{1000};
+    static constexpr std::chrono::milliseconds expireCycleInterval{100};
+    static constexpr std::chrono::milliseconds expireBacklogInterval{10};
+
+    // The live entry for key, or nullptr
+    auto find(std::string_view key) -> KeyEntry*;
+
+    template <typename T> auto find(std::string_view key) -> TypedLookup<T>
+    {
+        KeyEntry* entry = find(key);
+        T* value = entry != nullptr ? std::get_if<T>(&entry->value) : nullptr;
+        return {value, entry != nullptr && value == nullptr};
+    }
+
+    // The value stored at key, created empty (without expiry) if the key is missing
+    template <typename T> auto findOrCreate(std::string_view key) -> TypedLookup<T>
+    {
+        auto [it, inserted] = dict.emplace(key);
+        if (inserted)
+        {
+            it->second.value.template emplace<T>();
+        }
+        else if (it->second.hasExpiry && isExpired(key))
+        {
+            expires.erase(key);
+            it->second.value.template emplace<T>();
+            it->second.hasExpiry = false;
+            ++expiredKeys;
+        }
+
+        T* value = std::get_if<T>(&it->second.value);
+        return {value, value == nullptr};
+    }
+
+    // One SCAN step over the keyspace (Dict::scan): fn(key, entry) for the keys of one bucket,
+    // expired or not.  Returns the next cursor, 0 when done; fn must not insert or erase.
+    template <typename Fn> auto scan(uint64_t cursor, Fn&& fn) const -> uint64_t
+    {
+        return dict.scan(cursor, [&](const auto& slot) { fn(std::string_view(slot.first), slot.second); });
+    }
+
+    // SET semantics: replaces whatever the key held and drops any TTL
+    void setString(std::string_view key, std::string_view value);
+
+    // SETEX semantics: replaces whatever the key held and expires it at `when`
+    void setString(std::string_view key, std::string_view value, Expiry when);
+
+    // *STORE semantics (SINTERSTORE, ...): replaces whatever the key held with value and drops any TTL
+    template <typename T> void store(std::string_view key, T&& value)
+    {
+        auto [it, inserted] = dict.emplace(key);
+        it->second.value = std::forward<T>(value);
+        if (it->second.hasExpiry)
+        {
+            expires.erase(key);
+            it->second.hasExpiry = false;
+        }
+    }
+
+    // Give a live key a TTL; false if the key does not exist
+    auto expire(std::string_view key, Expiry when) -> bool;
+
+    // When key expires; nullptr if it has no TTL
+    [[nodiscard]] auto expiryOf(std::string_view key) const -> const Expiry*;
+
+    // True if a live key was removed
+    auto erase(std::string_view key) -> bool;
+
+    // Delete expired keys for at most `budget`; returns how many were deleted
+    auto activeExpireCycle(std::chrono::microseconds budget) -> size_t;
+
+    // Run an active expiry cycle if one is due; called by the dispatcher after each command
+    void cron()
+    {
+        if (!expires.empty() && commandNow() >= nextExpireCycle) runExpireCycle();
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return dict.size(); }
+    [[nodiscard]] auto volatileCount() const -> size_t { return expires.size(); }
+    [[nodiscard]] auto expiredCount() const -> uint64_t { return expiredKeys; }
+
+  private:
+    auto isExpired(std::string_view key) const -> bool;
+    void runExpireCycle();
+
+    DictMap<KeyEntry> dict;
+    DictMap<Expiry> expires; // volatile keys only
+
+    size_t expireCursor = 0; // where the next active cycle resumes in `expires`
+    bool expireBacklog = false;
+    MonotonicTime nextExpireCycle;
+    uint64_t expiredKeys = 0;
+};
+
+// The process-wide keyspace all data commands operate on
+auto keyspace() -> Keyspace&;
+
+// Held by the dispatchers around each command
+auto commandMutex() -> std::mutex&;
+
+// Name reported by TYPE
+auto typeName(ValueType type) -> const char*;
+
+// Name reported by OBJECT ENCODING
+auto encodingName(const KeyEntry& entry) -> const char*;
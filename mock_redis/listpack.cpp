@@ -0,0 +1,170 @@
+#include "listpack.h"
+
+namespace
+{
+auto varintSize(size_t v) -> size_t
+{
+    size_t n = 1;
+    while (v >= 0x80)
+    {
+        v >>= 7;
+        ++n;
+    }
+    return n;
+}
+
+// LEB128: low 7 bits first, high bit set on every byte but the last
+auto putVarint(char* out, size_t v) -> size_t
+{
+    size_t n = 0;
+    while (v >= 0x80)
+    {
+        out[n++] = static_cast<char>((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    out[n++] = static_cast<char>(v);
+    return n;
+}
+
+auto getVarint(const char* in, size_t& v) -> size_t
+{
+    v = 0;
+    size_t n = 0;
+    for (unsigned shift = 0;; shift += 7)
+    {
+        auto byte = static_cast<unsigned char>(in[n++]);
+        v |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return n;
+    }
+}
+
+// The same bytes in reverse order, so the value decodes from its last byte backwards
+auto putBackVarint(char* out, size_t v) -> size_t
+{
+    char tmp[10];
+    size_t n = putVarint(tmp, v);
+    for (size_t i = 0; i < n; ++i)
+    {
+        out[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+// `end` points one past the backlen
+auto getBackVarint(const char* end, size_t& v) -> size_t
+{
+    v = 0;
+    size_t n = 0;
+    for (unsigned shift = 0;; shift += 7)
+    {
+        auto byte = static_cast<unsigned char>(*(end - 1 - n++));
+        v |= static_cast<size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return n;
+    }
+}
+} // namespace
+
+auto Listpack::entrySize(size_t len) -> size_t
+{
+    size_t body = varintSize(len) + len;
+    return body + varintSize(body);
+}
+
+auto Listpack::get(size_t pos) const -> std::string_view
+{
+    size_t len = 0;
+    size_t header = getVarint(buf.data() + pos, len);
+    return {buf.data() + pos + header, len};
+}
+
+auto Listpack::next(size_t pos) const -> size_t
+{
+    size_t len = 0;
+    size_t header = getVarint(buf.data() + pos, len);
+    return pos + header + len + varintSize(header + len);
+}
+
+auto Listpack::prev(size_t pos) const -> size_t
+{
+    size_t body = 0;
+    size_t back = getBackVarint(buf.data() + pos, body);
+    return pos - back - body;
+}
+
+auto Listpack::seek(long long index) const -> size_t
+{
+    auto n = static_cast<long long>(count);
+    if (index < 0) index += n;
+    if (index < 0 || index >= n) return end();
+
+    // Walk from whichever end is nearer
+    if (index < n / 2)
+    {
+        size_t pos = begin();
+        for (long long i = 0; i < index; ++i)
+        {
+            pos = next(pos);
+        }
+        return pos;
+    }
+
+    size_t pos = last();
+    for (long long i = n - 1; i > index; --i)
+    {
+        pos = prev(pos);
+    }
+    return pos;
+}
+
+auto Listpack::find(std::string_view value, size_t stride, size_t from) const -> size_t
+{
+    size_t pos = seek(static_cast<long long>(from));
+    size_t skip = 0;
+    for (; pos != end(); pos = next(pos))
+    {
+        if (skip-- == 0)
+        {
+            if (get(pos) == value) return pos;
+            skip = stride - 1;
+        }
+    }
+    return end();
+}
+
+void Listpack::insert(size_t pos, std::string_view value)
+{
+    size_t size = entrySize(value.size());
+    buf.insert(pos, size, '\0');
+
+    char* out = buf.data() + pos;
+    size_t header = putVarint(out, value.size());
+    value.copy(out + header, value.size());
+    putBackVarint(out + header + value.size(), header + value.size());
+    ++count;
+}
+
+void Listpack::replace(size_t pos, std::string_view value)
+{
+    size_t oldSize = next(pos) - pos;
+    size_t newSize = entrySize(value.size());
+    if (oldSize != newSize)
+    {
+        buf.replace(pos, oldSize, newSize, '\0');
+    }
+
+    char* out = buf.data() + pos;
+    size_t header = putVarint(out, value.size());
+    value.copy(out + header, value.size());
+    putBackVarint(out + header + value.size(), header + value.size());
+}
+
+void Listpack::erase(size_t pos, size_t n)
+{
+    size_t stop = pos;
+    for (size_t i = 0; i < n && stop != end(); ++i)
+    {
+        stop = next(stop);
+        --count;
+    }
+    buf.erase(pos, stop - pos);
+}
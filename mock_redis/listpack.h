@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/*
+ * Listpack
+ * --------
+ *
+ * A sequence of strings packed back to back into one buffer, after Redis's
+ * listpack.  Small hashes, sets and lists are stored this way instead of as
+ * a hash table or vector (see collections.h): no per-element allocation, no
+ * bucket array, and a full read (HGETALL, SMEMBERS, LRANGE) is one linear
+ * scan over contiguous memory.
+ *
+ * Each entry is
+ *
+ *     [length, LEB128] [bytes] [backlen]
+ *
+ * where backlen is the size of the first two parts, stored as a reversed
+ * LEB128 so it can be decoded from its last byte.  That is what lets the
+ * listpack be walked from either end.  An entry of up to 127 bytes costs 2
+ * bytes of overhead.
+ *
+ * Entries are addressed by byte offset ("position").  Positions remain valid
+ * until the listpack is modified; end() is the position one past the last
+ * entry.  Insertion and removal move the bytes behind the affected entry, so
+ * they are linear, which is fine at the sizes listpacks are used for.
+ */
+class Listpack
+{
+  public:
+    [[nodiscard]] auto size() const -> size_t { return count; }
+    [[nodiscard]] auto empty() const -> bool { return count == 0; }
+    [[nodiscard]] auto bytes() const -> size_t { return buf.size(); }
+
+    [[nodiscard]] auto begin() const -> size_t { return 0; }
+    [[nodiscard]] auto end() const -> size_t { return buf.size(); }
+    [[nodiscard]] auto last() const -> size_t { return buf.empty() ? end() : prev(end()); }
+
+    [[nodiscard]] auto get(size_t pos) const -> std::string_view;
+    [[nodiscard]] auto next(size_t pos) const -> size_t;
+    [[nodiscard]] auto prev(size_t pos) const -> size_t;
+
+    // Position of entry `index` (negative counts from the back), or end()
+    [[nodiscard]] auto seek(long long index) const -> size_t;
+
+    // First entry equal to value, checking every `stride`-th entry from `from`; end() if none
+    [[nodiscard]] auto find(std::string_view value, size_t stride = 1, size_t from = 0) const -> size_t;
+
+    void pushBack(std::string_view value) { insert(end(), value); }
+    void pushFront(std::string_view value) { insert(begin(), value); }
+    void insert(size_t pos, std::string_view value);
+
+    // Overwrite the entry at pos
+    void replace(size_t pos, std::string_view value);
+
+    // Remove `n` entries starting at pos
+    void erase(size_t pos, size_t n = 1);
+
+    // The encoded buffer, and a listpack rebuilt from one (used by quicklist compression)
+    [[nodiscard]] auto raw() const -> const std::string& { return buf; }
+    static auto fromRaw(std::string raw, size_t count) -> Listpack
+    {
+        Listpack lp;
+        lp.buf = std::move(raw);
+        lp.count = static_cast<uint32_t>(count);
+        return lp;
+    }
+
+    template <typename Fn> void forEach(Fn&& fn) const
+    {
+        for (size_t pos = begin(); pos != end(); pos = next(pos))
+        {
+            fn(get(pos));
+        }
+    }
+
+  private:
+    // Encoded size of an entry holding `len` bytes
+    static auto entrySize(size_t len) -> size_t;
+
+    std::string buf;
+    uint32_t count = 0;
+};
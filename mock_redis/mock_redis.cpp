@@ -2,12 +2,13 @@
 //
 #include "mock_redis.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
-#include <iostream>
 #include <string>
 #include <tuple>
 #include <unordered_map>
@@ -15,7 +16,15 @@
 #include <utility>
 #include <vector>
 
+#include "blocking.h"
+#include "clock.h"
+#include "command_recorder.h"
+#include "command_stats.h"
 #include "hiredis/hiredis.h"
+#include "keyspace.h"
+#include "mock_redis_commands.h"
+#include "reply_pool.h"
+#include "trace.h"
 
 // Function to return the string representation of a Redis reply type
 std::string getRedisReplyType(int replyType)
@@ -45,146 +54,234 @@ std::string getRedisReplyType(int replyType)
 
 bool isAuth = false;
 
-// -------------------
-// Parse va_list according to ArgTypes
-// -------------------
-
-// NOLINTBEGIN
-
-std::vector<ArgValue> parseVaList(va_list ap, const std::vector<ArgType>& argTypes)
-{
-    std::vector<ArgValue> result;
-    for (ArgType type : argTypes)
-    {
-        switch (type)
-        {
-        case ArgType::String:
-        {
-            const char* s = va_arg(ap, const char*);
-            result.emplace_back(std::string(s));
-            break;
-        }
-        case ArgType::Int:
-        {
-            int i = va_arg(ap, int);
-            result.emplace_back(i);
-            break;
-        }
-        case ArgType::Binary:
-        {
-            const char* ptr = va_arg(ap, const char*);
-            int len = va_arg(ap, int); // get the binary length
-            result.emplace_back(BinaryValue(ptr, len));
-            break;
-        }
-        }
-    }
-    return result;
-}
-
-// NOLINTEND
-
-#include <hiredis/hiredis.h>
-#include <iostream>
-
+// Dumps a reply to the trace sink, one record per line
 void printResult(redisReply* reply)
 {
     if (reply == nullptr)
     {
-        std::cout << "-ERR No reply\n";
+        traceWrite(TraceLevel::Debug, "-ERR No reply");
         return;
     }
 
+    auto line = [](std::string_view prefix, std::string_view text)
+    {
+        std::string out(prefix);
+        out += text;
+        traceWrite(TraceLevel::Debug, out);
+    };
+
     switch (reply->type)
     {
     case REDIS_REPLY_STATUS:
-    case REDIS_REPLY_STRING: std::cout << reply->str << "\n"; break;
+    case REDIS_REPLY_STRING: line("", std::string_view(reply->str, reply->len)); break;
 
-    case REDIS_REPLY_ERROR: std::cout << "-ERR " << reply->str << "\n"; break;
+    case REDIS_REPLY_ERROR: line("-ERR ", std::string_view(reply->str, reply->len)); break;
 
     case REDIS_REPLY_NIL:
-        std::cout << "$-1\n"; // Redis-style NIL
+        line("$-1", ""); // Redis-style NIL
         break;
 
     case REDIS_REPLY_ARRAY:
-        std::cout << "*" << reply->elements << "\n";
+        line("*", std::to_string(reply->elements));
         for (size_t i = 0; i < reply->elements; ++i)
         {
             redisReply* elem = reply->element[i];
             if (elem->type == REDIS_REPLY_STRING || elem->type == REDIS_REPLY_STATUS)
             {
-                std::cout << "$" << elem->len << "\n" << elem->str << "\n";
+                line("$", std::to_string(elem->len));
+                line("", std::string_view(elem->str, elem->len));
             }
             else if (elem->type == REDIS_REPLY_INTEGER)
             {
-                std::cout << ":" << elem->integer << "\n";
+                line(":", std::to_string(elem->integer));
             }
             else if (elem->type == REDIS_REPLY_NIL)
             {
-                std::cout << "$-1\n";
+                line("$-1", "");
             }
             else
             {
-                std::cout << "-ERR Unsupported array element type\n";
+                line("-ERR Unsupported array element type", "");
             }
         }
         break;
 
-    case REDIS_REPLY_INTEGER: std::cout << ":" << reply->integer << "\n"; break;
+    case REDIS_REPLY_INTEGER: line(":", std::to_string(reply->integer)); break;
+
+    default: line("-ERR Unknown reply type: ", std::to_string(reply->type)); break;
+    }
+}
+
+// -------------------
+// Command table
+// -------------------
+
+template <typename... Tags> static constexpr auto makeCommandEntries(CommandList<Tags...> /*unused*/)
+{
+    return std::array<CommandInfo, sizeof...(Tags)>{makeCommandEntry<Tags>()...};
+}
+
+static constexpr auto commandEntries = makeCommandEntries(RegisteredCommands{});
+static constexpr auto commandTable = makeCommandTable(commandEntries);
+static constexpr auto argvTable = makeArgvTable<countArgvCommands(commandEntries)>(commandEntries);
+
+auto CommandRegistry::find(const char* format) -> const CommandInfo*
+{
+    return commandTable.find(format);
+}
+
+auto CommandRegistry::findArgv(std::string_view name, size_t arity) -> const CommandInfo*
+{
+    constexpr auto emptySlot = decltype(argvTable)::emptySlot;
+
+    auto index = argvTable.find(name, arity);
+    if (index != emptySlot) return &commandTable.entries[index];
 
-    default: std::cout << "-ERR Unknown reply type: " << reply->type << "\n"; break;
+    index = argvTable.find(name, variadicArity);
+    if (index == emptySlot || !commandTable.entries[index].acceptsArity(arity)) return nullptr;
+    return &commandTable.entries[index];
+}
+
+auto CommandRegistry::all() -> std::span<const CommandInfo>
+{
+    return commandTable.all();
+}
+
+auto CommandRegistry::lookupError(std::string_view name) -> std::string
+{
+    for (const CommandInfo& info : all())
+    {
+        if (equalsIgnoreCase(commandNameOf(info.format), name))
+        {
+            // Redis names the command in lower case here ("ERR wrong number of arguments for 'get' command")
+            std::string lower(name);
+            std::transform(lower.begin(), lower.end(), lower.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return "ERR wrong number of arguments for '" + lower + "' command";
+        }
     }
+    return "ERR unknown command '" + std::string(name) + "'";
 }
 
 // -------------------
 // Command dispatcher
 // -------------------
 
+void FormatArgv::assign(const char* format, va_list ap, bool withName)
+{
+    argv.clear();
+    argvlen.clear();
+    bytes.clear();
+
+    auto push = [this](std::string_view arg)
+    {
+        bytes.append(arg);
+        argvlen.push_back(arg.size());
+    };
+    if (withName)
+    {
+        push(commandNameOf(format));
+    }
+    forEachVaArg(format, ap, push);
+
+    // Pointers are taken only now that `bytes` has stopped growing
+    const char* next = bytes.data();
+    for (size_t len : argvlen)
+    {
+        argv.push_back(next);
+        next += len;
+    }
+}
+
+auto formatArgvScratch() -> FormatArgv&
+{
+    thread_local FormatArgv scratch;
+    return scratch;
+}
+
 auto redisCommandFromVaList(const char* name, va_list ap) -> redisReply*
 {
-    auto& registry = CommandRegistry::get();
-    if (!registry.contains(name))
+    const CommandInfo* cmdInfo = CommandRegistry::find(name);
+    if (cmdInfo == nullptr)
+    {
+        // Not registered verbatim: a variadic arity, a literal argument, ...; resolve it by name like an argv call
+        FormatArgv& args = formatArgvScratch();
+        args.assign(name, ap, true);
+        return redisCommandFromArgv(static_cast<int>(args.size()), args.argv.data(), args.argvlen.data());
+    }
+
+    std::lock_guard lock(commandMutex());
+
+    // Call the command's handler function with the original va_list
+    CommandSample sample = beginCommandSample();
+    refreshCommandClock(sample.start);
+    if (isCommandRecording()) captureCommandArgs(*cmdInfo, ap);
+    redisReply* reply = cmdInfo->handler(ap);
+    recordCommand(*cmdInfo, sample, reply->type == REDIS_REPLY_ERROR);
+    if (isCommandRecording()) writeCommandRecord(*cmdInfo, sample.start, reply->type);
+    keyspace().cron();
+    blockedClients().cron();
+    return reply;
+}
+
+auto redisCommandFromArgv(int argc, const char** argv, const size_t* argvlen) -> redisReply*
+{
+    if (argc < 1)
     {
-        std::cout << "-ERR unknown command '" << name << "'\n";
         return nullptr;
     }
 
-    auto& cmdInfo = registry.at(name);
-    /*
-    // Debugging the arguments passed to the command
-    std::cout << name << " ";
-    for (ArgType const t : cmdInfo.argTypes)
+    std::string_view name(argv[0], argvlen != nullptr ? argvlen[0] : strlen(argv[0]));
+    const CommandInfo* cmdInfo = CommandRegistry::findArgv(name, static_cast<size_t>(argc - 1));
+    if (cmdInfo == nullptr)
     {
-        std::cout << " ";
-        switch (t)
-        {
-        case ArgType::String:
-        {
-            const char* s = va_arg(ap, const char*);
-            std::cout << "'" << s << "'";
-            break;
-        }
-        case ArgType::Int:
-        {
-            int i = va_arg(ap, int);
-            std::cout << i;
-            break;
-        }
-        case ArgType::Binary:
-        {
-            const void* data = va_arg(ap, const void*);
-            size_t length = va_arg(ap, size_t); // Assuming length is passed after the binary data
-            std::cout << "[binary data, length: " << length << "]";
-            break;
-        }
-        default: std::cout << "?";
-        }
+        MOCK_REDIS_TRACE(TraceLevel::Info, "-ERR unknown command '%.*s' with %d arguments", static_cast<int>(name.size()),
+                         name.data(), argc - 1);
+        return nullptr;
     }
-    */
-    // Call the command's handler function with the original va_list
-    redisReply* result = cmdInfo.handler(ap);
 
-    return result;
+    return dispatchCommand(*cmdInfo, argv + 1, argvlen != nullptr ? argvlen + 1 : nullptr,
+                           static_cast<size_t>(argc - 1));
+}
+
+auto dispatchCommand(const CommandInfo& info, const char** args, const size_t* argslen, size_t argc) -> redisReply*
+{
+    std::lock_guard lock(commandMutex());
+    CommandSample sample = beginCommandSample();
+    refreshCommandClock(sample.start);
+    if (isCommandRecording()) captureCommandArgs(args, argslen, argc);
+    redisReply* reply = info.argvHandler(args, argslen, argc);
+    recordCommand(info, sample, reply->type == REDIS_REPLY_ERROR);
+    if (isCommandRecording()) writeCommandRecord(info, sample.start, reply->type);
+    keyspace().cron();
+    blockedClients().cron();
+    return reply;
+}
+
+auto redis::execute(int argc, const char** argv, const size_t* argvlen) -> Reply
+{
+    if (argc < 1)
+    {
+        return error("ERR wrong number of arguments");
+    }
+
+    std::string_view name(argv[0], argvlen != nullptr ? argvlen[0] : strlen(argv[0]));
+    const CommandInfo* cmdInfo = CommandRegistry::findArgv(name, static_cast<size_t>(argc - 1));
+    if (cmdInfo == nullptr)
+    {
+        return error(CommandRegistry::lookupError(name));
+    }
+
+    std::lock_guard lock(commandMutex());
+    CommandSample sample = beginCommandSample();
+    refreshCommandClock(sample.start);
+    if (isCommandRecording()) captureCommandArgs(argv + 1, argvlen != nullptr ? argvlen + 1 : nullptr, argc - 1);
+    Reply reply = cmdInfo->replyHandler(argv + 1, argvlen != nullptr ? argvlen + 1 : nullptr, argc - 1);
+    recordCommand(*cmdInfo, sample, reply.type == Type::Error);
+    if (isCommandRecording()) writeCommandRecord(*cmdInfo, sample.start, static_cast<int>(reply.type));
+    keyspace().cron();
+    blockedClients().cron();
+    return reply;
 }
 
 auto redisCommandM(const char* name, ...) -> redisReply*
@@ -195,96 +292,73 @@ auto redisCommandM(const char* name, ...) -> redisReply*
     auto* r = redisCommandFromVaList(name, args);
     va_end(args);
     return r;
-
-    // auto& registry = CommandRegistry::get();
-    // if (!registry.contains(name))
-    //{
-    //     std::cout << "-ERR unknown command '" << name << "'\n";
-    //     return nullptr;
-    // }
-
-    // auto& cmdInfo = registry.at(name);
-    // redisReply* result = cmdInfo.handler(ap);
-    // va_end(ap);
-    // return result;
 }
 
-// Modified create function returning unique_ptr
+// Replies come from the thread-local pools in reply_pool.cpp
 auto createRedisReply() -> redisReply*
 {
-    auto* reply = (redisReply*)calloc(1, sizeof(redisReply));
-    std::cerr << "create " << reply << "\n";
+    auto* reply = allocPooledReply();
+    MOCK_REDIS_TRACE(TraceLevel::Verbose, "create %p", static_cast<void*>(reply));
     return reply;
 }
 
-// Modified create function returning unique_ptr
-static auto createRedisReplyPtr() -> RedisReplyPtr
-{
-    auto* rawReply = (redisReply*)calloc(1, sizeof(redisReply));
-    std::cerr << "create " << rawReply << "\n";
-
-    return RedisReplyPtr(rawReply, &freeReplyObject);
-}
-
 auto createStatusReply(const char* status) -> redisReply*
 {
     auto* reply = createRedisReply();
     reply->type = REDIS_REPLY_STATUS;
-#ifdef _WIN32
-    reply->str = _strdup(status); // heap-allocated copy
-#else
-    reply->str = strdup(status); // heap-allocated copy
-#endif
-    reply->len = strlen(status);
+    assignReplyString(reply, status);
     return reply;
 }
 
 auto createOkStatusReply() -> redisReply*
 {
-    return createStatusReply("+OK");
+    return sharedReply(SharedReply::Ok);
+}
+
+auto createPongReply() -> redisReply*
+{
+    return sharedReply(SharedReply::Pong);
 }
 
 auto createErrorReply(const char* error) -> redisReply*
 {
     auto* reply = createRedisReply();
     reply->type = REDIS_REPLY_ERROR;
-#ifdef _WIN32
-    reply->str = _strdup(error); // heap-allocated copy
-#else
-    reply->str = strdup(error); // heap-allocated copy
-#endif
-
-    reply->len = strlen(error);
+    assignReplyString(reply, error);
     return reply;
 }
 
 auto createAuthErrorReply() -> redisReply*
 {
-    return createErrorReply("-NOAUTH Authentication required");
+    return sharedReply(SharedReply::NoAuth);
+}
+
+auto createWrongTypeReply() -> redisReply*
+{
+    return sharedReply(SharedReply::WrongType);
 }
 
 auto createNilReply() -> redisReply*
 {
-    auto* reply = createRedisReply();
-    reply->type = REDIS_REPLY_NIL;
-    return reply;
+    return sharedReply(SharedReply::Nil);
 }
 
-auto createStringReply(const std::string& s) -> redisReply*
+auto createStringReply(std::string_view s) -> redisReply*
 {
     auto* reply = createRedisReply();
     reply->type = REDIS_REPLY_STRING;
-#ifdef _WIN32
-    reply->str = _strdup(s.c_str());
-#else
-    reply->str = strdup(s.c_str());
-#endif
-    reply->len = s.size();
+    // Binary-safe copy: %b payloads may contain embedded NULs
+    assignReplyString(reply, s);
     return reply;
 }
 
-auto createIntegerReply(int value) -> redisReply*
+auto createIntegerReply(long long value) -> redisReply*
 {
+    if (redisReply* shared = sharedIntegerReply(value))
+    {
+        return shared;
+    }
+
     redisReply* reply = createRedisReply();
     reply->type = REDIS_REPLY_INTEGER;
     reply->integer = value;
@@ -292,9 +366,19 @@ auto createIntegerReply(int value) -> redisReply*
 }
 auto createArrayReply(size_t count) -> redisReply*
 {
+    if (count == 0)
+    {
+        return sharedReply(SharedReply::EmptyArray);
+    }
+
     auto* reply = createRedisReply();
     reply->type = REDIS_REPLY_ARRAY;
-    reply->len = count;
-    reply->element = (redisReply**)calloc(count, sizeof(redisReply*));
+    allocReplyElements(reply, count);
     return reply;
 }
+
+// Returns the whole tree built above to the reply pools
+void releaseRedisReply(redisReply* reply)
+{
+    releaseReplyTree(reply);
+}
@@ -3,21 +3,30 @@
 
 #pragma once
 
+#include <array>
+#include <charconv>
 #include <chrono>
 #include <cstdarg>
+#include <cstddef>
+#include <cstring>
 #include <functional>
 #include <hiredis/hiredis.h>
 #include <iostream>
 #include <memory>
 #include <set>
+#include <span>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
-#include <variant>
 #include <vector>
 
+#include "redis_reply.h"
+#include "reply_pool.h"
+#include "trace.h"
+
 extern bool isAuth;
 // -------------------
 // Types and Enums
@@ -29,134 +38,298 @@ struct BinaryValue
 
     BinaryValue(const char* ptr, size_t len) : data(ptr, len) {}
 };
+
+// Non-owning %b payload.  Points into the caller's buffer and is only valid
+// for the duration of the handler call; copy it when it has to be stored.
+struct BinaryView
+{
+    const char* ptr;
+    size_t len;
+
+    [[nodiscard]] auto view() const -> std::string_view { return {ptr, len}; }
+    [[nodiscard]] auto bytes() const -> std::span<const std::byte> { return std::as_bytes(std::span(ptr, len)); }
+};
+
+// The trailing arguments of a variadic command (MGET key [key ...]): every
+// argument from the pack's position to the end of the command, at least one.
+// Non-owning like BinaryView, and only allowed as the last ArgTypes entry.
+struct ArgPack
+{
+    const char* const* argv;
+    const size_t* argvlen; // null when the arguments are NUL-terminated
+    size_t count;
+
+    [[nodiscard]] auto size() const -> size_t { return count; }
+    [[nodiscard]] auto operator[](size_t i) const -> std::string_view
+    {
+        return {argv[i], argvlen != nullptr ? argvlen[i] : std::strlen(argv[i])};
+    }
+};
+
 enum class ArgType
 {
     String,
     Int,
     Binary,
+    StringView,
+    BinaryView,
+    Pack,
 };
-using ArgValue = std::variant<std::string, int, BinaryValue>;
 
-inline redisReply* mock(const char* arg1)
+// Transparent hashing so stores keyed by std::string can be probed with a
+// std::string_view without materializing a temporary key.
+struct StringHash
 {
-    return nullptr;
-}
+    using is_transparent = void;
 
-inline redisReply* mock(const char* format, const char* arg1)
-{
-    return nullptr;
-}
+    auto operator()(std::string_view s) const noexcept -> size_t { return std::hash<std::string_view>{}(s); }
+};
 
-inline redisReply* mock(const char* format, const char* arg1, const char* areg2)
-{
-    return nullptr;
-}
+template <typename V> using StringMap = std::unordered_map<std::string, V, StringHash, std::equal_to<>>;
+using StringSet = std::unordered_set<std::string, StringHash, std::equal_to<>>;
 
-inline redisReply* mock(const char* format, const char* arg1, int arg2, const char* arg3)
-{
-    return nullptr;
-}
+// -------------------
+// Dispatch entry points (mock_redis.cpp)
+// -------------------
 
-inline redisReply* mock(const char* format, const char* arg1, const char* arg2, const char* arg3)
-{
-    return nullptr;
-}
+// Format-string dispatch, e.g. redisCommandM("SET %s %s", key, value)
+redisReply* redisCommandFromVaList(const char* format, va_list ap);
+redisReply* redisCommandM(const char* format, ...);
 
-// Variadic mock redisCommand wrapper
-template <typename... Args> inline redisReply* redisCommandT(void* context, const char* format, Args&&... args)
-{
-    std::ostringstream oss;
-    oss << "[MOCK redisCommand called]\n";
+// Argv dispatch: argv[0] is the command name, argvlen may be null for
+// NUL-terminated arguments.  No format string is parsed.
+redisReply* redisCommandFromArgv(int argc, const char** argv, const size_t* argvlen);
 
-    // Log all arguments
-    (void)std::initializer_list<int>{(oss << "Arg: " << args << "\n", 0)...};
-    std::cout << oss.str();
+struct CommandInfo;
 
-    redisReply* reply = nullptr;
+// Runs one already resolved command the way every dispatcher does: under commandMutex(), on a
+// refreshed command clock, counted in the stats and recorded, then the expiry and blocked-client
+// cron.  `args` excludes the command name.
+redisReply* dispatchCommand(const CommandInfo& info, const char** args, const size_t* argslen, size_t argc);
 
-    if constexpr (sizeof...(args) == 1)
-    {
-        reply = mock(const_cast<char*>(format), std::forward<Args>(args)...);
-    }
-    else if constexpr (sizeof...(args) == 2)
-    {
-        reply = mock(const_cast<char*>(format), std::forward<Args>(args)...);
-    }
-    else
+// Frees a reply tree built by the create*Reply helpers (freeReplyObject in the hiredis shim)
+void releaseRedisReply(redisReply* reply);
+
+namespace redis
+{
+// In-process C++ dispatch: same lookup as redisCommandFromArgv, but the result
+// comes back as a Reply value.  The read commands (GET, MGET, STRLEN, HGET,
+// HMGET, HEXISTS, HGETALL, HKEYS, HVALS, HLEN, SMEMBERS, LRANGE, LLEN), INFO,
+// LATENCY and LISTSUB build the Reply directly (through emit<ValueReplyForm>
+// where they have one) and no redisReply tree; every other command still
+// builds its pooled tree, which is copied into a Reply and freed.  Unknown
+// commands yield an error reply.
+Reply execute(int argc, const char** argv, const size_t* argvlen);
+
+// execute("SET", "key", "value")
+template <typename... Args> Reply execute(std::string_view name, const Args&... args)
+{
+    const std::string_view parts[] = {name, std::string_view(args)...};
+    std::array<const char*, 1 + sizeof...(Args)> argv;
+    std::array<size_t, 1 + sizeof...(Args)> argvlen;
+    for (size_t i = 0; i < argv.size(); ++i)
     {
-        reply = mock(const_cast<char*>(format), std::forward<Args>(args)...);
+        argv[i] = parts[i].data();
+        argvlen[i] = parts[i].size();
     }
-
-    return reply;
+    return execute(static_cast<int>(argv.size()), argv.data(), argvlen.data());
 }
+} // namespace redis
 
-// auto redisCommand(const char* name, ...) -> redisReply*;
-
-static std::string argTypeName(ArgType t)
+// Variadic redisCommand wrapper for call sites that hold a context but want the in-process store
+template <typename... Args> inline redisReply* redisCommandT(void* /*context*/, const char* format, Args&&... args)
 {
-    return (t == ArgType::String) ? "string" : "int";
+    return redisCommandM(format, std::forward<Args>(args)...);
 }
 
+// auto redisCommand(const char* name, ...) -> redisReply*;
+
 template <typename Tag> struct Command;
 
 // Result can be nothing, a single string, or a list of strings
 using CommandResult = redisReply*; // Now we are returning redisReply directly
 
+// Handlers return either a raw CommandResult or a value-typed redis::Reply.
+// Each dispatch path converts only when it needs the other form.
+inline auto toRawReply(redisReply* reply) -> redisReply*
+{
+    return reply;
+}
+
+inline auto toRawReply(const redis::Reply& reply) -> redisReply*
+{
+    return redis::ToRedisReply(reply).release();
+}
+
+inline auto toReplyValue(redisReply* reply) -> redis::Reply
+{
+    redis::Reply value = redis::FromRedisReply(reply);
+    releaseRedisReply(reply);
+    return value;
+}
+
+inline auto toReplyValue(redis::Reply&& reply) -> redis::Reply
+{
+    return std::move(reply);
+}
+
 // -------------------
 // CommandInfo and command table
 // -------------------
 
-using HandlerFunc = std::function<redisReply*(va_list)>;
+using HandlerFunc = redisReply* (*)(va_list);
+using ArgvHandlerFunc = redisReply* (*)(const char** argv, const size_t* argvlen, size_t argc);
+using ReplyHandlerFunc = redis::Reply (*)(const char** argv, const size_t* argvlen, size_t argc);
 
 struct CommandInfo
 {
-    std::vector<ArgType> argTypes;
+    const char* tag; // Tag::tag, an internal name only: INFO commandstats keys on commandNameOf(format)
+    const char* format;
+    std::span<const ArgType> argTypes;
     HandlerFunc handler;
+    ArgvHandlerFunc argvHandler;   // arguments only, the command name is not included
+    ReplyHandlerFunc replyHandler; // argv in, redis::Reply out (redis::execute)
+
+    // Variadic commands end in an ArgPack and take any argument count from argTypes.size() up
+    [[nodiscard]] constexpr auto isVariadic() const -> bool
+    {
+        return !argTypes.empty() && argTypes.back() == ArgType::Pack;
+    }
+    [[nodiscard]] constexpr auto acceptsArity(size_t arity) const -> bool
+    {
+        return isVariadic() ? arity >= argTypes.size() : arity == argTypes.size();
+    }
 };
-// Forward declare makeCommandEntry before CommandRegistrar uses it
-template <typename Tag> static auto makeCommandEntry() -> CommandInfo;
-// Global command registry singleton
+
+// Global command registry.  The table itself is generated at compile time from
+// RegisteredCommands (mock_redis_commands.h); see command_table.h.
 struct CommandRegistry
 {
-    // Returns the singleton command registry map
-    static std::unordered_map<std::string, CommandInfo>& get()
-    {
-        static std::unordered_map<std::string, CommandInfo> instance;
-        return instance;
-    }
+    // Single-probe lookup by format string, nullptr if the format is not registered
+    static auto find(const char* format) -> const CommandInfo*;
+
+    // Lookup for argv calls by case-insensitive command name and argument count; a
+    // variadic command matches any count it accepts
+    static auto findArgv(std::string_view name, size_t arity) -> const CommandInfo*;
+
+    // All registered commands, in RegisteredCommands order
+    static auto all() -> std::span<const CommandInfo>;
+
+    // The error text for a command name that findArgv did not match: "wrong number of arguments"
+    // when the name is registered with another arity, "unknown command" when it is not registered
+    static auto lookupError(std::string_view name) -> std::string;
 };
 
-// CommandRegistrar helper template
-template <typename Tag> struct CommandRegistrar
+// Visit a format command's arguments in order as raw bytes (%d in decimal), for
+// callers that must keep them past the call: pipelining, command recording and
+// variadic commands.  Tokens other than %s, %b and %d are literal arguments
+// ("OBJECT ENCODING %s").  `ap` itself is left untouched.
+template <typename Sink> void forEachVaArg(const char* format, va_list ap, Sink&& sink)
 {
-    CommandRegistrar()
+    va_list copy;
+    va_copy(copy, ap);
+
+    std::string_view rest(format);
+    rest.remove_prefix(std::min(rest.find(' '), rest.size())); // the command name
+    while (!rest.empty())
     {
-        // Register the command into the global registry by format string
-        CommandRegistry::get()[Tag::format] = makeCommandEntry<Tag>();
+        if (rest.front() == ' ')
+        {
+            rest.remove_prefix(1);
+            continue;
+        }
+        std::string_view token = rest.substr(0, rest.find(' '));
+        rest.remove_prefix(token.size());
+
+        if (token == "%s")
+        {
+            sink(std::string_view(va_arg(copy, const char*)));
+        }
+        else if (token == "%d")
+        {
+            char digits[16];
+            auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), va_arg(copy, int));
+            sink(std::string_view(digits, end - digits));
+        }
+        else if (token == "%b")
+        {
+            const char* ptr = va_arg(copy, const char*);
+            size_t len = va_arg(copy, size_t);
+            sink(std::string_view(ptr, len));
+        }
+        else
+        {
+            sink(token);
+        }
     }
-};
+    va_end(copy);
+}
 
-template <typename Tag> struct AutoRegister
+// A format command turned into an argv array, for variadic commands and for
+// formats that are not registered verbatim ("MGET %s %s %s").  The argument
+// bytes are copied into `bytes` (a %d is only ever rendered into a temporary),
+// and argv points into it.
+struct FormatArgv
 {
-    static inline CommandRegistrar<Tag> registrar{};
+    std::vector<const char*> argv;
+    std::vector<size_t> argvlen;
+    std::string bytes;
+
+    // withName puts the command name in argv[0]
+    void assign(const char* format, va_list ap, bool withName);
+    [[nodiscard]] auto size() const -> size_t { return argv.size(); }
 };
 
+// The calling thread's reusable FormatArgv; dispatch never nests, so one is enough
+auto formatArgvScratch() -> FormatArgv&;
+
 // TODO: Reference additional headers your program requires here.
 redisReply* createRedisReply();
 
 // Alias for unique_ptr with custom deleter
 using RedisReplyPtr = std::unique_ptr<redisReply, decltype(&freeReplyObject)>;
 
+// The OK, PONG, NOAUTH, WRONGTYPE, nil, empty-array and small-integer results are shared,
+// preallocated replies (see reply_pool.h): free them as usual, never modify them
 redisReply* createStatusReply(const char* status);
 redisReply* createOkStatusReply();
+redisReply* createPongReply();
 redisReply* createErrorReply(const char* error);
 redisReply* createAuthErrorReply();
+redisReply* createWrongTypeReply();
 redisReply* createNilReply();
-redisReply* createStringReply(const std::string& s);
-redisReply* createIntegerReply(int value);
+redisReply* createStringReply(std::string_view s);
+redisReply* createIntegerReply(long long value);
 redisReply* createArrayReply(size_t count);
 
-std::vector<ArgValue> parseVaList(va_list ap, const std::vector<ArgType>& argTypes);
+// The two forms a read command can build its reply in from one body, `emit<Form>` (see
+// "Reply types" below).  RawReplyForm builds the pooled tree the C API hands out; ValueReplyForm
+// builds the redis::Reply that redis::execute returns.  Both take views and copy each byte once.
+struct RawReplyForm
+{
+    using Result = redisReply*;
+    using ArrayBuilder = ArrayReplyBuilder;
+
+    static auto noAuth() -> Result { return createAuthErrorReply(); }
+    static auto wrongType() -> Result { return createWrongTypeReply(); }
+    static auto nil() -> Result { return createNilReply(); }
+    static auto bulk(std::string_view s) -> Result { return createStringReply(s); }
+    static auto emptyArray() -> Result { return createArrayReply(0); }
+};
+
+struct ValueReplyForm
+{
+    using Result = redis::Reply;
+    using ArrayBuilder = redis::ArrayBuilder;
+
+    static auto noAuth() -> Result { return redis::noAuth(); }
+    static auto wrongType() -> Result { return redis::wrongType(); }
+    static auto nil() -> Result { return redis::nil(); }
+    static auto bulk(std::string_view s) -> Result { return redis::bulk(std::string(s)); }
+    static auto emptyArray() -> Result { return redis::array({}); }
+};
+
+// Dump a reply to the trace sink at TraceLevel::Debug (trace.h)
 void printResult(redisReply* reply);
 
 /*
@@ -172,16 +345,44 @@ void printResult(redisReply* reply);
  *   - A static `call` method implementing the command's logic.
  *
  * The framework automatically:
- *   - Deduces argument types (strings or ints) from the Tag's ArgTypes tuple.
- *   - Parses variadic C-style arguments (`va_list`) to typed C++ arguments.
+ *   - Deduces argument types (strings, ints or binary payloads) from the Tag's ArgTypes tuple.
+ *   - Reads variadic C-style arguments (`va_list`) straight into typed C++
+ *     arguments, with no intermediate vector, variant or std::function.
  *   - Calls the Tag's `call` method with typed arguments.
  *   - Wraps and returns the Redis reply (`redisReply*`).
  *
+ * Reply types:
+ *   `call` may return a raw `redisReply*` (CommandResult) or a value-typed
+ *   `redis::Reply` (redis_reply.h).  A Reply is turned into a redisReply tree
+ *   only on the hiredis-compatible paths; `redis::execute` hands it back as is.
+ *   Conversely a raw reply is copied into a Reply (and freed) for
+ *   `redis::execute`, so either choice works on every path.
+ *
+ *   A read command that hands out stored bytes (GET, HGETALL, LRANGE, ...)
+ *   avoids both conversions by writing its body once as
+ *   `template <typename Form> static auto emit(...) -> typename Form::Result`
+ *   over RawReplyForm / ValueReplyForm, with `call` returning
+ *   `emit<RawReplyForm>`.  The C API paths use `call` and build the pooled
+ *   tree (one ArrayReplyBuilder block for an array) straight from the stored
+ *   views; `redis::execute` calls `emit<ValueReplyForm>` and builds only the
+ *   Reply.
+ *
  * Key Types:
- *   - `ArgType` enum: distinguishes between string and int arguments.
- *   - `ArgValue`: variant holding either a `std::string` or an `int`.
- *   - `CommandInfo`: holds argument types and a handler callable.
- *   - `HandlerFunc`: a std::function taking `va_list` and returning `redisReply*`.
+ *   - `ArgType` enum: distinguishes between string, int and binary arguments.
+ *     `std::string_view` and `BinaryView` are non-owning and copy nothing;
+ *     `std::string` and `BinaryValue` take an owning copy.
+ *   - `ArgPack`, as the last argument, makes a command variadic: it holds every
+ *     remaining argument (MGET key [key ...]).  The registered format shows
+ *     one arity ("MGET %s"); calls with any other argument count are parsed
+ *     into argv (FormatArgv) and found by name, like redisCommandArgv calls.
+ *   - `CommandInfo`: holds the format, argument types and a handler pointer.
+ *   - `HandlerFunc`: a plain function pointer taking `va_list` and returning `redisReply*`.
+ *
+ * Registration:
+ *   Tags are declared in their data type's header (mock_redis_string.h, ...)
+ *   and listed in `RegisteredCommands` (mock_redis_commands.h).  The command
+ *   table is a perfect hash over those formats built at compile time, so there
+ *   is no static-initialization-order registration step.
  *
  * Usage Example:
  * --------------
@@ -212,47 +413,200 @@ template <typename T> static constexpr auto deduceArgType() -> ArgType
         return ArgType::Int;
     else if constexpr (std::is_same_v<T, BinaryValue>)
         return ArgType::Binary;
+    else if constexpr (std::is_same_v<T, std::string_view>)
+        return ArgType::StringView;
+    else if constexpr (std::is_same_v<T, BinaryView>)
+        return ArgType::BinaryView;
+    else if constexpr (std::is_same_v<T, ArgPack>)
+        return ArgType::Pack;
     else
         static_assert(sizeof(T) == 0, "Unsupported ArgType");
 }
 
-// Turn a tuple type into a vector<ArgType>
-template <typename Tuple> static auto getArgTypes() -> std::vector<ArgType>
+// Turn a tuple type into a constexpr array of ArgType
+template <typename Tuple>
+inline constexpr auto argTypesOf = []<std::size_t... I>(std::index_sequence<I...>)
+{ return std::array<ArgType, sizeof...(I)>{deduceArgType<std::tuple_element_t<I, Tuple>>()...}; }(
+    std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+
+// Read one argument of type T from the va_list, in hiredis format order
+template <typename T> static auto readArg(va_list* ap) -> T
 {
-    constexpr size_t N = std::tuple_size_v<Tuple>;
-    std::vector<ArgType> types;
-    types.reserve(N);
+    if constexpr (std::is_same_v<T, std::string>)
+    {
+        return std::string(va_arg(*ap, const char*));
+    }
+    else if constexpr (std::is_same_v<T, int>)
+    {
+        return va_arg(*ap, int);
+    }
+    else if constexpr (std::is_same_v<T, BinaryValue>)
+    {
+        // %b takes a pointer followed by a size_t length
+        const char* ptr = va_arg(*ap, const char*);
+        size_t len = va_arg(*ap, size_t);
+        return BinaryValue(ptr, len);
+    }
+    else if constexpr (std::is_same_v<T, std::string_view>)
+    {
+        return std::string_view(va_arg(*ap, const char*));
+    }
+    else if constexpr (std::is_same_v<T, BinaryView>)
+    {
+        const char* ptr = va_arg(*ap, const char*);
+        size_t len = va_arg(*ap, size_t);
+        return BinaryView{ptr, len};
+    }
+}
+
+template <typename Tag> static auto invokeCommandArgv(const char** argv, const size_t* argvlen, size_t argc)
+    -> redisReply*;
 
-    [&]<std::size_t... I>(std::index_sequence<I...>)
-    { (types.push_back(deduceArgType<std::tuple_element_t<I, Tuple>>()), ...); }(std::make_index_sequence<N>{});
+template <typename Tuple>
+inline constexpr bool endsInArgPack = !argTypesOf<Tuple>.empty() && argTypesOf<Tuple>.back() == ArgType::Pack;
 
-    return types;
+// Handler stored in the command table for each Tag
+template <typename Tag> static auto invokeCommand(va_list ap) -> redisReply*
+{
+    using Tuple = typename Tag::ArgTypes;
+
+    // A pack's length is only known from the format, so variadic commands go through argv
+    if constexpr (endsInArgPack<Tuple>)
+    {
+        FormatArgv& args = formatArgvScratch();
+        args.assign(Tag::format, ap, false);
+        return invokeCommandArgv<Tag>(args.argv.data(), args.argvlen.data(), args.size());
+    }
+
+    else
+    {
+        va_list args;
+        va_copy(args, ap);
+
+        redisReply* reply = [&]<std::size_t... I>(std::index_sequence<I...>)
+        {
+            // A braced initializer evaluates left to right, so the reads follow the format
+            Tuple tup{readArg<std::tuple_element_t<I, Tuple>>(&args)...};
+            return toRawReply(std::apply(Tag::call, tup));
+        }(std::make_index_sequence<std::tuple_size_v<Tuple>>{});
+
+        va_end(args);
+
+        if constexpr (traceEnabled(TraceLevel::Debug)) printResult(reply);
+        return reply;
+    }
 }
 
-// Unpack a parsed ArgValue vector into a tuple
-template <typename Tuple> static auto unpackArgs(const std::vector<ArgValue>& args) -> Tuple
+// Convert one argv argument to type T.  Integers must span the whole argument;
+// on a parse failure `ok` is cleared and the handler is not called.
+template <typename T> static auto argvArg(std::string_view arg, bool& ok) -> T
 {
+    if constexpr (std::is_same_v<T, std::string_view>)
+    {
+        return arg;
+    }
+    else if constexpr (std::is_same_v<T, std::string>)
+    {
+        return std::string(arg);
+    }
+    else if constexpr (std::is_same_v<T, int>)
+    {
+        int value = 0;
+        auto [ptr, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), value);
+        ok = ok && ec == std::errc{} && ptr == arg.data() + arg.size();
+        return value;
+    }
+    else if constexpr (std::is_same_v<T, BinaryView>)
+    {
+        return BinaryView{arg.data(), arg.size()};
+    }
+    else if constexpr (std::is_same_v<T, BinaryValue>)
+    {
+        return BinaryValue(arg.data(), arg.size());
+    }
+}
+
+inline constexpr const char* argvIntegerError = "ERR value is not an integer or out of range";
+
+// Argument `i` of an argv call as type T; an ArgPack takes argument i and everything after it
+template <typename T>
+static auto argvElement(const char** argv, const size_t* argvlen, size_t argc, size_t i, bool& ok) -> T
+{
+    if constexpr (std::is_same_v<T, ArgPack>)
+    {
+        return ArgPack{argv + i, argvlen != nullptr ? argvlen + i : nullptr, argc - i};
+    }
+    else
+    {
+        return argvArg<T>(std::string_view(argv[i], argvlen != nullptr ? argvlen[i] : std::strlen(argv[i])), ok);
+    }
+}
+
+// Convert the whole argv into the Tag's argument tuple; argc has already been checked against the Tag
+template <typename Tag> static auto argvTuple(const char** argv, const size_t* argvlen, size_t argc, bool& ok)
+{
+    using Tuple = typename Tag::ArgTypes;
+
     return [&]<std::size_t... I>(std::index_sequence<I...>)
     {
-        return std::make_tuple(std::get<std::tuple_element_t<I, Tuple>>(args[I])...);
+        return Tuple{argvElement<std::tuple_element_t<I, Tuple>>(argv, argvlen, argc, I, ok)...};
     }(std::make_index_sequence<std::tuple_size_v<Tuple>>{});
 }
 
-// Core generator
-template <typename Tag> static auto makeCommandEntry() -> CommandInfo
+// Argv handler stored in the command table for each Tag
+template <typename Tag> static auto invokeCommandArgv(const char** argv, const size_t* argvlen, size_t argc)
+    -> redisReply*
 {
-    using Tuple = typename Tag::ArgTypes;
-    auto types = getArgTypes<Tuple>();
+    bool ok = true;
+    auto tup = argvTuple<Tag>(argv, argvlen, argc, ok);
+    if (!ok)
+    {
+        return createErrorReply(argvIntegerError);
+    }
 
-    HandlerFunc handler = [types](va_list ap) -> redisReply*
+    redisReply* reply = toRawReply(std::apply(Tag::call, tup));
+    if constexpr (traceEnabled(TraceLevel::Debug)) printResult(reply);
+    return reply;
+}
+
+// redis::execute handler stored in the command table for each Tag
+template <typename Tag>
+static auto invokeCommandReply(const char** argv, const size_t* argvlen, size_t argc) -> redis::Reply
+{
+    bool ok = true;
+    auto tup = argvTuple<Tag>(argv, argvlen, argc, ok);
+    if (!ok)
     {
-        std::vector<ArgValue> args = parseVaList(ap, types);
-        Tuple tup = unpackArgs<Tuple>(args);
+        return redis::error(argvIntegerError);
+    }
 
-        redisReply* reply = std::apply(Tag::call, tup);
-        printResult(reply);
-        return reply;
-    };
+    if constexpr (requires { &Tag::template emit<ValueReplyForm>; })
+    {
+        return std::apply(&Tag::template emit<ValueReplyForm>, tup);
+    }
+    else
+    {
+        return toReplyValue(std::apply(Tag::call, tup));
+    }
+}
 
-    return CommandInfo{types, handler};
+constexpr auto argPackIsLast(std::span<const ArgType> types) -> bool
+{
+    for (size_t i = 0; i + 1 < types.size(); ++i)
+    {
+        if (types[i] == ArgType::Pack) return false;
+    }
+    return true;
+}
+
+// Core generator
+template <typename Tag> static constexpr auto makeCommandEntry() -> CommandInfo
+{
+    static_assert(argPackIsLast(argTypesOf<typename Tag::ArgTypes>), "An ArgPack must be the last argument");
+    return CommandInfo{Tag::tag,
+                       Tag::format,
+                       argTypesOf<typename Tag::ArgTypes>,
+                       &invokeCommand<Tag>,
+                       &invokeCommandArgv<Tag>,
+                       &invokeCommandReply<Tag>};
 }
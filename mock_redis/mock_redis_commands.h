@@ -0,0 +1,96 @@
+#pragma once
+
+#include "command_table.h"
+#include "mock_redis_hash.h"
+#include "mock_redis_keys.h"
+#include "mock_redis_list.h"
+#include "mock_redis_misc.h"
+#include "mock_redis_set.h"
+#include "mock_redis_string.h"
+#include "mock_redis_zset.h"
+
+// Every command the dispatcher knows about.  A new Tag is registered by
+// declaring it in its data type's header and adding it here; the perfect-hash
+// table in mock_redis.cpp is rebuilt from this list at compile time.
+using RegisteredCommands = CommandList<
+    // connection / pub-sub
+    AuthCmd,
+    PingCmd,
+    PublishCmd,
+    SubscribeCmd,
+    UnsubscribeCmd,
+    ListSubCmd,
+    // introspection
+    InfoCmd,
+    LatencyCmd,
+    LatencyForCmd,
+    // keys, any type
+    ExistsCmd,
+    ExpireCmd,
+    TTLCmd,
+    DelCmd,
+    TypeCmd,
+    ObjectCmd,
+    ScanCmd,
+    // strings
+    SetBinaryCmd,
+    SetExBinaryCmd,
+    GetCmd,
+    SetCmd,
+    SetExCmd,
+    MSetCmd,
+    MGetCmd,
+    IncrCmd,
+    DecrCmd,
+    IncrByCmd,
+    DecrByCmd,
+    IncrByFloatCmd,
+    AppendCmd,
+    StrLenCmd,
+    GetSetCmd,
+    // lists
+    LPushCmd,
+    RPushCmd,
+    LPopCmd,
+    RPopCmd,
+    LRangeCmd,
+    LLenCmd,
+    BLPopCmd,
+    BRPopCmd,
+    BLMoveCmd,
+    // sets
+    SAddTag,
+    SMembersTag,
+    SRemTag,
+    SScanTag,
+    SInterTag,
+    SInterStoreTag,
+    SInterCardTag,
+    SUnionTag,
+    SUnionStoreTag,
+    SDiffTag,
+    SDiffStoreTag,
+    // hashes
+    HSetTag,
+    HGetTag,
+    HMGetTag,
+    HDelTag,
+    HExistsTag,
+    HGetAllTag,
+    HKeysTag,
+    HValsTag,
+    HLenTag,
+    HIncrByTag,
+    HScanTag,
+    // sorted sets
+    ZAddCmd,
+    ZIncrByCmd,
+    ZRemCmd,
+    ZScoreCmd,
+    ZCardCmd,
+    ZRankCmd,
+    ZRangeCmd,
+    ZRangeOptsCmd,
+    ZRangeByScoreCmd,
+    ZRangeByScoreOptsCmd,
+    ZScanCmd>;
@@ -1,204 +1,252 @@
 // Hash Commands Implementation
-#include "mock_redis.h"
+#include "mock_redis_hash.h"
+#include "keyspace.h"
+#include "scan.h"
 
-static std::unordered_map<std::string, std::unordered_map<std::string, std::string>> hashDb;
+#include <optional>
+#include <vector>
 
-
-struct HSetTag: AutoRegister<HSetTag>
+CommandResult HSetTag::call(std::string_view key, ArgPack pairs)
 {
-    static constexpr const char* tag = "HSET";
-    static constexpr const char* format = "HSET %s %s %s";
-    using ArgTypes = std::tuple<std::string, std::string, std::string>;
-
-    static CommandResult call(const std::string& key, const std::string& field, const std::string& value)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    if (!isAuth) return createAuthErrorReply();
+    if (pairs.size() % 2 != 0) return createErrorReply("ERR wrong number of arguments for 'hset' command");
 
-        auto& fieldMap = hashDb[key];
-        bool isNewField = fieldMap.find(field) == fieldMap.end();
-        fieldMap[field] = value;
+    auto [hash, wrongType] = keyspace().findOrCreate<HashValue>(key);
+    if (wrongType) return createWrongTypeReply();
 
-        return createIntegerReply(isNewField ? 1 : 0);
+    int newFields = 0;
+    for (size_t i = 0; i < pairs.size(); i += 2)
+    {
+        newFields += hash->set(pairs[i], pairs[i + 1]) ? 1 : 0;
     }
-};
+    return createIntegerReply(newFields);
+}
 
-struct HGetTag: AutoRegister<HGetTag>
+template <typename Form> auto HGetTag::emit(std::string_view key, std::string_view field) -> typename Form::Result
 {
-    static constexpr const char* tag = "HGET";
-    static constexpr const char* format = "HGET %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>;
+    if (!isAuth) return Form::noAuth();
 
-    static CommandResult call(const std::string& key, const std::string& field)
-    {
-        if (!isAuth) return createAuthErrorReply();
-
-        if (!hashDb.contains(key)) return createNilReply();
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return Form::wrongType();
+    if (hash == nullptr) return Form::nil();
 
-        auto& fieldMap = hashDb.at(key);
-        if (!fieldMap.contains(field)) return createNilReply();
+    Digits digits;
+    auto value = hash->get(field, digits);
+    if (!value) return Form::nil();
 
-        return createStringReply(fieldMap.at(field));
-    }
-};
+    return Form::bulk(*value);
+}
+template redis::Reply HGetTag::emit<ValueReplyForm>(std::string_view, std::string_view);
 
-struct HDelTag : AutoRegister<HDelTag>
+CommandResult HGetTag::call(std::string_view key, std::string_view field)
 {
-    static constexpr const char* tag = "HDEL";
-    static constexpr const char* format = "HDEL %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>;
+    return emit<RawReplyForm>(key, field);
+}
 
-    static CommandResult call(const std::string& key, const std::string& field)
-    {
-        if (!isAuth) return createAuthErrorReply();
+CommandResult HDelTag::call(std::string_view key, ArgPack fields)
+{
+    if (!isAuth) return createAuthErrorReply();
 
-        if (!hashDb.contains(key)) return createIntegerReply(0);
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (hash == nullptr) return createIntegerReply(0);
 
-        auto& fieldMap = hashDb.at(key);
-        size_t removed = fieldMap.erase(field);
+    int removed = 0;
+    for (size_t i = 0; i < fields.size(); ++i)
+    {
+        removed += hash->erase(fields[i]) ? 1 : 0;
+    }
+    if (hash->empty()) keyspace().erase(key);
 
-        if (fieldMap.empty()) hashDb.erase(key);
+    return createIntegerReply(removed);
+}
 
-        return createIntegerReply(static_cast<int>(removed));
+template <typename Form> auto HMGetTag::emit(std::string_view key, ArgPack fields) -> typename Form::Result
+{
+    if (!isAuth) return Form::noAuth();
+
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return Form::wrongType();
+
+    // Each field is looked up once; the views stay valid because nothing writes to the hash meanwhile,
+    // and every field has its own digits for an integer-encoded value
+    thread_local std::vector<std::optional<std::string_view>> values;
+    thread_local std::vector<Digits> digits;
+    values.clear();
+    digits.resize(fields.size());
+    typename Form::ArrayBuilder builder;
+    for (size_t i = 0; i < fields.size(); ++i)
+    {
+        values.push_back(hash != nullptr ? hash->get(fields[i], digits[i]) : std::nullopt);
+        if (values.back())
+        {
+            builder.measure(values.back()->size());
+        }
+        else
+        {
+            builder.measureNil();
+        }
     }
-};
+    builder.start();
+    for (const auto& value : values)
+    {
+        if (value)
+        {
+            builder.append(*value);
+        }
+        else
+        {
+            builder.appendNil();
+        }
+    }
+    return builder.finish();
+}
+template redis::Reply HMGetTag::emit<ValueReplyForm>(std::string_view, ArgPack);
 
-struct HExistsTag:AutoRegister<HExistsTag>
+CommandResult HMGetTag::call(std::string_view key, ArgPack fields)
 {
-    static constexpr const char* tag = "HEXISTS";
-    static constexpr const char* format = "HEXISTS %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>;
+    return emit<RawReplyForm>(key, fields);
+}
 
-    static CommandResult call(const std::string& key, const std::string& field)
-    {
-        if (!isAuth) return createAuthErrorReply();
+redis::Reply HExistsTag::call(std::string_view key, std::string_view field)
+{
+    if (!isAuth) return redis::noAuth();
 
-        if (!hashDb.contains(key)) return createIntegerReply(0);
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return redis::wrongType();
+    if (hash == nullptr) return redis::integer(0);
 
-        auto& fieldMap = hashDb.at(key);
-        return createIntegerReply(fieldMap.contains(field) ? 1 : 0);
-    }
-};
+    return redis::integer(hash->contains(field) ? 1 : 0);
+}
 
-struct HGetAllTag : AutoRegister<HGetAllTag>
+template <typename Form> auto HGetAllTag::emit(std::string_view key) -> typename Form::Result
 {
-    static constexpr const char* tag = "HGETALL";
-    static constexpr const char* format = "HGETALL %s";
-    using ArgTypes = std::tuple<std::string>;
+    if (!isAuth) return Form::noAuth();
 
-    static CommandResult call(const std::string& key)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return Form::wrongType();
+    if (hash == nullptr) return Form::nil();
 
-        if (!hashDb.contains(key)) return createNilReply();
+    typename Form::ArrayBuilder builder;
+    hash->forEach(
+        [&](std::string_view field, std::string_view val)
+        {
+            builder.measure(field.size());
+            builder.measure(val.size());
+        });
+    builder.start();
+    hash->forEach(
+        [&](std::string_view field, std::string_view val)
+        {
+            builder.append(field);
+            builder.append(val);
+        });
+    return builder.finish();
+}
+template redis::Reply HGetAllTag::emit<ValueReplyForm>(std::string_view);
+
+CommandResult HGetAllTag::call(std::string_view key)
+{
+    return emit<RawReplyForm>(key);
+}
 
-        auto& fieldMap = hashDb.at(key);
-        if (fieldMap.empty()) return createNilReply();
+template <typename Form> auto HKeysTag::emit(std::string_view key) -> typename Form::Result
+{
+    if (!isAuth) return Form::noAuth();
 
-        redisReply* reply = createArrayReply(fieldMap.size() * 2);
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return Form::wrongType();
+    if (hash == nullptr) return Form::nil();
 
-        size_t idx = 0;
-        for (const auto& [field, val] : fieldMap)
-        {
-            reply->element[idx++] = createStringReply(field);
-            reply->element[idx++] = createStringReply(val);
-        }
-        return reply;
-    }
-};
+    typename Form::ArrayBuilder builder;
+    hash->forEach([&](std::string_view field, std::string_view) { builder.measure(field.size()); });
+    builder.start();
+    hash->forEach([&](std::string_view field, std::string_view) { builder.append(field); });
+    return builder.finish();
+}
+template redis::Reply HKeysTag::emit<ValueReplyForm>(std::string_view);
 
-struct HKeysTag: AutoRegister<HSetTag>
+CommandResult HKeysTag::call(std::string_view key)
 {
-    static constexpr const char* tag = "HKEYS";
-    static constexpr const char* format = "HKEYS %s";
-    using ArgTypes = std::tuple<std::string>;
+    return emit<RawReplyForm>(key);
+}
 
-    static CommandResult call(const std::string& key)
-    {
-        if (!isAuth) return createAuthErrorReply();
-
-        if (!hashDb.contains(key)) return createNilReply();
+template <typename Form> auto HValsTag::emit(std::string_view key) -> typename Form::Result
+{
+    if (!isAuth) return Form::noAuth();
 
-        auto& fieldMap = hashDb.at(key);
-        if (fieldMap.empty()) return createNilReply();
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return Form::wrongType();
+    if (hash == nullptr) return Form::nil();
 
-        redisReply* reply = createArrayReply(fieldMap.size());
-        size_t idx = 0;
-        for (const auto& [field, _] : fieldMap)
-        {
-            reply->element[idx++] = createStringReply(field);
-        }
-        return reply;
-    }
-};
+    typename Form::ArrayBuilder builder;
+    hash->forEach([&](std::string_view, std::string_view val) { builder.measure(val.size()); });
+    builder.start();
+    hash->forEach([&](std::string_view, std::string_view val) { builder.append(val); });
+    return builder.finish();
+}
+template redis::Reply HValsTag::emit<ValueReplyForm>(std::string_view);
 
-struct HValsTag: AutoRegister<HValsTag>
+CommandResult HValsTag::call(std::string_view key)
 {
-    static constexpr const char* tag = "HVALS";
-    static constexpr const char* format = "HVALS %s";
-    using ArgTypes = std::tuple<std::string>;
+    return emit<RawReplyForm>(key);
+}
 
-    static CommandResult call(const std::string& key)
-    {
-        if (!isAuth) return createAuthErrorReply();
+redis::Reply HLenTag::call(std::string_view key)
+{
+    if (!isAuth) return redis::noAuth();
 
-        if (!hashDb.contains(key)) return createNilReply();
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return redis::wrongType();
+    if (hash == nullptr) return redis::integer(0);
 
-        auto& fieldMap = hashDb.at(key);
-        if (fieldMap.empty()) return createNilReply();
+    return redis::integer(static_cast<long long>(hash->size()));
+}
 
-        redisReply* reply = createArrayReply(fieldMap.size());
-        size_t idx = 0;
-        for (const auto& [_, val] : fieldMap)
-        {
-            reply->element[idx++] = createStringReply(val);
-        }
-        return reply;
-    }
-};
-
-struct HLenTag:AutoRegister<HLenTag>
+CommandResult HIncrByTag::call(std::string_view key, std::string_view field, std::string_view increment)
 {
-    static constexpr const char* tag = "HLEN";
-    static constexpr const char* format = "HLEN %s";
-    using ArgTypes = std::tuple<std::string>;
+    if (!isAuth) return createAuthErrorReply();
 
-    static CommandResult call(const std::string& key)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    int64_t delta = 0;
+    if (!IntSet::parse(increment, delta)) return createErrorReply(argvIntegerError);
 
-        if (!hashDb.contains(key)) return createIntegerReply(0);
+    auto [hash, wrongType] = keyspace().findOrCreate<HashValue>(key);
+    if (wrongType) return createWrongTypeReply();
 
-        return createIntegerReply(static_cast<int>(hashDb.at(key).size()));
+    // No text is parsed or built for a field already stored as an integer (collections.h)
+    int64_t result = 0;
+    switch (hash->incrBy(field, delta, result))
+    {
+    case IncrResult::Ok:
+        return createIntegerReply(result);
+    case IncrResult::NotInteger:
+        return createErrorReply("ERR hash value is not an integer");
+    case IncrResult::Overflow:
+        break;
     }
-};
+    return createErrorReply("ERR increment or decrement would overflow");
+}
 
-struct HIncrByTag: AutoRegister<HIncrByTag>
+CommandResult HScanTag::call(std::string_view key, ArgPack args)
 {
-    static constexpr const char* tag = "HINCRBY";
-    static constexpr const char* format = "HINCRBY %s %s %d";
-    using ArgTypes = std::tuple<std::string, std::string, int>;
+    if (!isAuth) return createAuthErrorReply();
 
-    static CommandResult call(const std::string& key, const std::string& field, int increment)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    ScanArgs scan;
+    if (const char* error = parseScanArgs(args, false, scan)) return createErrorReply(error);
 
-        auto& fieldMap = hashDb[key];
+    auto [hash, wrongType] = keyspace().find<HashValue>(key);
+    if (wrongType) return createWrongTypeReply();
 
-        int current = 0;
-        if (fieldMap.contains(field))
-        {
-            try
-            {
-                current = std::stoi(fieldMap[field]);
-            }
-            catch (...)
-            {
-                return createErrorReply("ERR hash value is not an integer");
-            }
-        }
+    ScanBatch& batch = scanBatch();
+    batch.clear();
+    if (hash == nullptr) return scanReply(0, batch);
 
-        int newVal = current + increment;
-        fieldMap[field] = std::to_string(newVal);
-        return createIntegerReply(newVal);
-    }
-};
+    auto visit = [&](std::string_view field, std::string_view value)
+    {
+        if (!scan.pattern.empty() && !globMatch(scan.pattern, field)) return;
+        batch.add(field);
+        batch.add(value);
+    };
+    uint64_t cursor = scanSteps(scan, batch, 2, [&](uint64_t at) { return hash->scan(at, visit); });
+    return scanReply(cursor, batch);
+}
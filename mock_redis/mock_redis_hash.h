@@ -0,0 +1,112 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// Hash commands (mock_redis_hash.cpp)
+// -------------------
+
+struct HSetTag
+{
+    static constexpr const char* tag = "HSET";
+    static constexpr const char* format = "HSET %s %s %s"; // key, field value [field value ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack pairs);
+};
+
+struct HGetTag
+{
+    static constexpr const char* tag = "HGET";
+    static constexpr const char* format = "HGET %s %s";
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    template <typename Form> static auto emit(std::string_view key, std::string_view field) -> typename Form::Result;
+    static CommandResult call(std::string_view key, std::string_view field);
+};
+
+struct HDelTag
+{
+    static constexpr const char* tag = "HDEL";
+    static constexpr const char* format = "HDEL %s %s"; // key, field [field ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack fields);
+};
+
+struct HMGetTag
+{
+    static constexpr const char* tag = "HMGET";
+    static constexpr const char* format = "HMGET %s %s"; // key, field [field ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    template <typename Form> static auto emit(std::string_view key, ArgPack fields) -> typename Form::Result;
+    static CommandResult call(std::string_view key, ArgPack fields);
+};
+
+struct HExistsTag
+{
+    static constexpr const char* tag = "HEXISTS";
+    static constexpr const char* format = "HEXISTS %s %s";
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static redis::Reply call(std::string_view key, std::string_view field);
+};
+
+struct HGetAllTag
+{
+    static constexpr const char* tag = "HGETALL";
+    static constexpr const char* format = "HGETALL %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    template <typename Form> static auto emit(std::string_view key) -> typename Form::Result;
+    static CommandResult call(std::string_view key);
+};
+
+struct HKeysTag
+{
+    static constexpr const char* tag = "HKEYS";
+    static constexpr const char* format = "HKEYS %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    template <typename Form> static auto emit(std::string_view key) -> typename Form::Result;
+    static CommandResult call(std::string_view key);
+};
+
+struct HValsTag
+{
+    static constexpr const char* tag = "HVALS";
+    static constexpr const char* format = "HVALS %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    template <typename Form> static auto emit(std::string_view key) -> typename Form::Result;
+    static CommandResult call(std::string_view key);
+};
+
+struct HLenTag
+{
+    static constexpr const char* tag = "HLEN";
+    static constexpr const char* format = "HLEN %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static redis::Reply call(std::string_view key);
+};
+
+// The increment is read as text so it can span 64 bits, like INCRBY's; "HINCRBY %s %s %d" calls are parsed into argv
+struct HIncrByTag
+{
+    static constexpr const char* tag = "HINCRBY";
+    static constexpr const char* format = "HINCRBY %s %s %s"; // key, field, increment
+    using ArgTypes = std::tuple<std::string_view, std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view field, std::string_view increment);
+};
+
+struct HScanTag
+{
+    static constexpr const char* tag = "HSCAN";
+    static constexpr const char* format = "HSCAN %s %s"; // key, cursor [MATCH pattern] [COUNT count]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack args);
+};
@@ -0,0 +1,156 @@
+#include "mock_redis_keys.h"
+#include "command_table.h"
+#include "keyspace.h"
+#include "scan.h"
+
+#include <algorithm>
+
+// -------------------
+// Exists Command
+// -------------------
+
+CommandResult ExistsCmd::call(std::string_view key)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    return createIntegerReply(keyspace().find(key) != nullptr ? 1 : 0);
+}
+
+// -------------------
+// Expire Command
+// -------------------
+
+CommandResult ExpireCmd::call(std::string_view key, int seconds)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    auto when = commandNow() + std::chrono::seconds(seconds);
+    // 0: not found or already expired, 1: updated
+    return createIntegerReply(keyspace().expire(key, when) ? 1 : 0);
+}
+
+// -------------------
+// TTL Command
+// -------------------
+
+CommandResult TTLCmd::call(std::string_view key)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    KeyEntry* entry = keyspace().find(key);
+    if (entry == nullptr)
+    {
+        return createIntegerReply(-2); // Key not found
+    }
+
+    const Expiry* when = entry->hasExpiry ? keyspace().expiryOf(key) : nullptr;
+    if (when == nullptr)
+    {
+        return createIntegerReply(-1); // No expiration
+    }
+
+    // find() has already expired the key if its time is up, so it is live here; seconds are
+    // rounded to nearest as in Redis, so a key with under half a second left reads 0
+    long long remainingMs = std::chrono::duration_cast<std::chrono::milliseconds>(*when - commandNow()).count();
+    return createIntegerReply((std::max(remainingMs, 0LL) + 500) / 1000);
+}
+
+// -------------------
+// Del Command
+// -------------------
+
+CommandResult DelCmd::call(ArgPack keys)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    int removed = 0;
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        removed += keyspace().erase(keys[i]) ? 1 : 0;
+    }
+    return createIntegerReply(removed);
+}
+
+// -------------------
+// Type Command
+// -------------------
+
+CommandResult TypeCmd::call(std::string_view key)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    KeyEntry* entry = keyspace().find(key);
+    return createStatusReply(entry != nullptr ? typeName(entry->type()) : "none");
+}
+
+// -------------------
+// Object Command
+// -------------------
+
+CommandResult ObjectCmd::call(std::string_view subcommand, std::string_view key)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    if (!equalsIgnoreCase(subcommand, "ENCODING"))
+    {
+        return createErrorReply("ERR unknown subcommand, only OBJECT ENCODING is supported");
+    }
+
+    KeyEntry* entry = keyspace().find(key);
+    if (entry == nullptr)
+    {
+        return createNilReply();
+    }
+    return createStringReply(encodingName(*entry));
+}
+
+// -------------------
+// Scan Command
+// -------------------
+
+CommandResult ScanCmd::call(ArgPack args)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    ScanArgs scan;
+    if (const char* error = parseScanArgs(args, true, scan))
+    {
+        return createErrorReply(error);
+    }
+
+    ScanBatch& batch = scanBatch();
+    batch.clear();
+    Keyspace& ks = keyspace();
+    auto visit = [&](std::string_view key, const KeyEntry& entry)
+    {
+        if (!scan.type.empty() && !equalsIgnoreCase(scan.type, typeName(entry.type()))) return;
+        if (!scan.pattern.empty() && !globMatch(scan.pattern, key)) return;
+        batch.add(key);
+    };
+    uint64_t cursor = scanSteps(scan, batch, 1, [&](uint64_t at) { return ks.scan(at, visit); });
+
+    // Expired keys are skipped, and deleted, only once the walk has stopped touching the table
+    batch.keepIf([&](std::string_view key) { return ks.find(key) != nullptr; });
+    return scanReply(cursor, batch);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// Generic key commands (mock_redis_keys.cpp), valid for every value type
+// -------------------
+
+struct ExistsCmd
+{
+    static constexpr const char* tag = "EXISTS";
+    static constexpr const char* format = "EXISTS %s"; // key
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+struct ExpireCmd
+{
+    static constexpr const char* tag = "EXPIRE";
+    static constexpr const char* format = "EXPIRE %s %d"; // key, seconds
+    using ArgTypes = std::tuple<std::string_view, int>;
+
+    static CommandResult call(std::string_view key, int seconds);
+};
+
+struct TTLCmd
+{
+    static constexpr const char* tag = "TTL";
+    static constexpr const char* format = "TTL %s"; // single string argument
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+struct DelCmd
+{
+    static constexpr const char* tag = "DEL";
+    static constexpr const char* format = "DEL %s"; // key [key ...]
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static CommandResult call(ArgPack keys);
+};
+
+struct TypeCmd
+{
+    static constexpr const char* tag = "TYPE";
+    static constexpr const char* format = "TYPE %s"; // key
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+// OBJECT ENCODING key: how the value is stored (listpack, hashtable, ...)
+struct ObjectCmd
+{
+    static constexpr const char* tag = "OBJECT";
+    static constexpr const char* format = "OBJECT %s %s"; // subcommand, key
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view subcommand, std::string_view key);
+};
+
+struct ScanCmd
+{
+    static constexpr const char* tag = "SCAN";
+    static constexpr const char* format = "SCAN %s"; // cursor [MATCH pattern] [COUNT count] [TYPE type]
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static CommandResult call(ArgPack args);
+};
@@ -1,203 +1,388 @@
-#include "mock_redis.h"
+#include "mock_redis_list.h"
+#include "blocking.h"
+#include "command_table.h"
+#include "keyspace.h"
+#include "reply_pool.h"
 
-static std::unordered_map<std::string,
-                          std::pair<std::vector<std::string>, std::chrono::time_point<std::chrono::system_clock>>>
-    listDb;
+#include <charconv>
+#include <chrono>
+#include <cmath>
 
+namespace
+{
+// Longest timeout a blocking pop accepts; the deadline must fit the command clock's nanoseconds
+constexpr double maxTimeoutSeconds = 1e9;
+
+auto serveBlocked(std::string_view key, std::string_view value) -> bool;
 
-static bool isExpired(const std::chrono::time_point<std::chrono::system_clock>& expiryTime)
+// Push value onto key and return the new length, or -1 if key holds another type.  A push onto a
+// missing list goes straight to the oldest client blocked on the key, if any, and is never stored.
+auto pushList(std::string_view key, std::string_view value, ListEnd end) -> long long
 {
-    return std::chrono::system_clock::now() > expiryTime;
+    auto [list, wrongType] = keyspace().find<ListValue>(key);
+    if (wrongType) return -1;
+
+    if (list == nullptr)
+    {
+        if (serveBlocked(key, value)) return 1;
+        list = keyspace().findOrCreate<ListValue>(key).value;
+    }
+
+    if (end == ListEnd::Left)
+    {
+        list->pushFront(value);
+    }
+    else
+    {
+        list->pushBack(value);
+    }
+    return static_cast<long long>(list->size());
 }
 
-// ---------
-//  LPUSH CMD
-// ---------
-struct LPushCmd
+// Push every value, in order, and return the length before any waiter is served, or -1 if key holds another type
+auto pushValues(std::string_view key, ArgPack values, ListEnd end) -> long long
 {
-    static constexpr const char* tag = "LPUSH";
-    static constexpr const char* format = "LPUSH %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>;
+    if (values.size() == 1) return pushList(key, values[0], end);
+
+    auto [list, wrongType] = keyspace().findOrCreate<ListValue>(key);
+    if (wrongType) return -1;
 
-    static CommandResult call(const std::string& key, const std::string& val)
+    for (size_t i = 0; i < values.size(); ++i)
     {
-        if (!isAuth) return createAuthErrorReply();
+        if (end == ListEnd::Left)
+        {
+            list->pushFront(values[i]);
+        }
+        else
+        {
+            list->pushBack(values[i]);
+        }
+    }
+    auto len = static_cast<long long>(list->size());
 
-        auto& [list, expiry] = listDb[key];
-        if (expiry == std::chrono::time_point<std::chrono::system_clock>{})
-            expiry = std::chrono::time_point<std::chrono::system_clock>::max();
+    // Looked up again each round: a BLMOVE's push into its destination may rehash the keyspace
+    for (;;)
+    {
+        list = keyspace().find<ListValue>(key).value;
+        BlockedPop* waiter = list != nullptr ? blockedClients().next(key) : nullptr;
+        if (waiter == nullptr) break;
 
-        list.insert(list.begin(), val);
-        return createIntegerReply(static_cast<int>(list.size()));
-    }
+        if (waiter->isMove() && keyspace().find<ListValue>(waiter->destination).wrongType)
+        {
+            BlockedClients::finish(*waiter, BlockedPop::State::WrongType);
+            continue;
+        }
 
-    static inline CommandRegistrar<LPushCmd> registrar{};
-};
+        std::string value(waiter->from == ListEnd::Left ? list->front() : list->back());
+        if (waiter->from == ListEnd::Left)
+        {
+            list->popFront();
+        }
+        else
+        {
+            list->popBack();
+        }
+        if (list->empty()) keyspace().erase(key);
 
-// ---------
-//  RPUSH CMD
-// ---------
-struct RPushCmd
-{
-    static constexpr const char* tag = "RPUSH";
-    static constexpr const char* format = "RPUSH %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>;
+        if (waiter->isMove()) pushList(waiter->destination, value, waiter->to);
+        BlockedClients::finish(*waiter, BlockedPop::State::Served, value);
+    }
+    return len;
+}
 
-    static CommandResult call(const std::string& key, const std::string& val)
+// Hand value to the oldest waiter on key; a BLMOVE waiter's move into its destination happens here
+auto serveBlocked(std::string_view key, std::string_view value) -> bool
+{
+    while (BlockedPop* waiter = blockedClients().next(key))
     {
-        if (!isAuth) return createAuthErrorReply();
+        if (waiter->isMove() && pushList(waiter->destination, value, waiter->to) < 0)
+        {
+            BlockedClients::finish(*waiter, BlockedPop::State::WrongType);
+            continue;
+        }
+        BlockedClients::finish(*waiter, BlockedPop::State::Served, value);
+        return true;
+    }
+    return false;
+}
 
-        auto& [list, expiry] = listDb[key];
-        if (expiry == std::chrono::time_point<std::chrono::system_clock>{})
-            expiry = std::chrono::time_point<std::chrono::system_clock>::max();
+auto parseListEnd(std::string_view s, ListEnd& end) -> bool
+{
+    if (equalsIgnoreCase(s, "LEFT"))
+    {
+        end = ListEnd::Left;
+        return true;
+    }
+    if (equalsIgnoreCase(s, "RIGHT"))
+    {
+        end = ListEnd::Right;
+        return true;
+    }
+    return false;
+}
 
-        list.push_back(val);
-        return createIntegerReply(static_cast<int>(list.size()));
+// A blocking pop's timeout in seconds, 0 meaning forever: a non-negative decimal.  Null if it is valid,
+// else the error to reply with.
+auto parseTimeout(std::string_view text, double& seconds) -> const char*
+{
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+    if (text.empty() || ec != std::errc() || end != text.data() + text.size() || !std::isfinite(seconds))
+    {
+        return "ERR timeout is not a float or out of range";
     }
+    if (seconds < 0) return "ERR timeout is negative";
+    if (seconds > maxTimeoutSeconds) return "ERR timeout is out of range";
+    return nullptr;
+}
 
-    static inline CommandRegistrar<RPushCmd> registrar{};
-};
+// The deadline `seconds` from now on the command clock
+void setTimeout(BlockedPop& waiter, double seconds)
+{
+    waiter.forever = seconds == 0;
+    waiter.deadline =
+        commandNow() + std::chrono::duration_cast<MonotonicTime::duration>(std::chrono::duration<double>(seconds));
+}
 
-// ---------
-//  LPOP CMD
-// ---------
-struct LPopCmd
+// [key, value], the BLPOP/BRPOP reply
+auto keyValueReply(std::string_view key, std::string_view value) -> CommandResult
 {
-    static constexpr const char* tag = "LPOP";
-    static constexpr const char* format = "LPOP %s";
-    using ArgTypes = std::tuple<std::string>;
+    ArrayReplyBuilder builder;
+    builder.measure(key.size());
+    builder.measure(value.size());
+    builder.start();
+    builder.append(key);
+    builder.append(value);
+    return builder.finish();
+}
 
-    static CommandResult call(const std::string& key)
+auto blockingPop(ArgPack args, ListEnd from) -> CommandResult
+{
+    if (!isAuth) return createAuthErrorReply();
+    if (args.size() < 2)
     {
-        if (!isAuth) return createAuthErrorReply();
+        return createErrorReply(from == ListEnd::Left ? "ERR wrong number of arguments for 'blpop' command"
+                                                      : "ERR wrong number of arguments for 'brpop' command");
+    }
 
-        if (!listDb.contains(key)) return createNilReply();
+    double timeout = 0;
+    if (const char* error = parseTimeout(args[args.size() - 1], timeout)) return createErrorReply(error);
+
+    // The first key, in command order, that holds a list is popped at once
+    BlockedPop waiter;
+    for (size_t i = 0; i + 1 < args.size(); ++i)
+    {
+        std::string_view key = args[i];
+        auto [list, wrongType] = keyspace().find<ListValue>(key);
+        if (wrongType) return createWrongTypeReply();
 
-        auto& [list, expiry] = listDb.at(key);
-        if (isExpired(expiry))
+        if (list != nullptr)
         {
-            listDb.erase(key);
-            return createNilReply();
+            redisReply* reply = keyValueReply(key, from == ListEnd::Left ? list->front() : list->back());
+            if (from == ListEnd::Left)
+            {
+                list->popFront();
+            }
+            else
+            {
+                list->popBack();
+            }
+            if (list->empty()) keyspace().erase(key);
+            return reply;
         }
+        waiter.keys.push_back(key);
+    }
 
-        if (list.empty()) return createNilReply();
+    waiter.from = from;
+    setTimeout(waiter, timeout);
+    blockedClients().block(waiter);
+    if (waiter.state != BlockedPop::State::Served) return createNilReply();
+    return keyValueReply(waiter.keys[waiter.servedKey], waiter.value);
+}
+} // namespace
 
-        std::string front = list.front();
-        list.erase(list.begin());
+// ---------
+//  LPUSH CMD
+// ---------
+CommandResult LPushCmd::call(std::string_view key, ArgPack values)
+{
+    if (!isAuth) return createAuthErrorReply();
 
-        return createStringReply(front);
-    }
+    long long len = pushValues(key, values, ListEnd::Left);
+    if (len < 0) return createWrongTypeReply();
 
-    static inline CommandRegistrar<LPopCmd> registrar{};
-};
+    return createIntegerReply(len);
+}
 
 // ---------
-//  RPOP CMD
+//  RPUSH CMD
 // ---------
-struct RPopCmd
+CommandResult RPushCmd::call(std::string_view key, ArgPack values)
 {
-    static constexpr const char* tag = "RPOP";
-    static constexpr const char* format = "RPOP %s";
-    using ArgTypes = std::tuple<std::string>;
+    if (!isAuth) return createAuthErrorReply();
 
-    static CommandResult call(const std::string& key)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    long long len = pushValues(key, values, ListEnd::Right);
+    if (len < 0) return createWrongTypeReply();
 
-        if (!listDb.contains(key)) return createNilReply();
+    return createIntegerReply(len);
+}
 
-        auto& [list, expiry] = listDb.at(key);
-        if (isExpired(expiry))
-        {
-            listDb.erase(key);
-            return createNilReply();
-        }
+// ---------
+//  LPOP CMD
+// ---------
+CommandResult LPopCmd::call(std::string_view key)
+{
+    if (!isAuth) return createAuthErrorReply();
 
-        if (list.empty()) return createNilReply();
+    auto [list, wrongType] = keyspace().find<ListValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (list == nullptr) return createNilReply();
 
-        std::string back = list.back();
-        list.pop_back();
+    redisReply* reply = createStringReply(list->front());
+    list->popFront();
+    if (list->empty()) keyspace().erase(key);
 
-        return createStringReply(back);
-    }
+    return reply;
+}
+
+// ---------
+//  RPOP CMD
+// ---------
+CommandResult RPopCmd::call(std::string_view key)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    auto [list, wrongType] = keyspace().find<ListValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (list == nullptr) return createNilReply();
 
-    static inline CommandRegistrar<RPopCmd> registrar{};
-};
+    redisReply* reply = createStringReply(list->back());
+    list->popBack();
+    if (list->empty()) keyspace().erase(key);
+
+    return reply;
+}
 
 // ---------
 //  LRANGE CMD
 // ---------
-struct LRangeCmd
+template <typename Form> auto LRangeCmd::emit(std::string_view key, int start, int stop) -> typename Form::Result
 {
-    static constexpr const char* tag = "LRANGE";
-    static constexpr const char* format = "LRANGE %s %d %d";
-    using ArgTypes = std::tuple<std::string, int, int>;
+    if (!isAuth) return Form::noAuth();
 
-    static CommandResult call(const std::string& key, int start, int stop)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    auto [list, wrongType] = keyspace().find<ListValue>(key);
+    if (wrongType) return Form::wrongType();
+    if (list == nullptr) return Form::emptyArray();
 
-        if (!listDb.contains(key)) return createArrayReply(0);
+    int len = static_cast<int>(list->size());
 
-        auto& [list, expiry] = listDb.at(key);
-        if (isExpired(expiry))
-        {
-            listDb.erase(key);
-            return createArrayReply(0);
-        }
+    // Normalize negative indices
+    if (start < 0) start = len + start;
+    if (stop < 0) stop = len + stop;
 
-        int len = static_cast<int>(list.size());
+    if (start < 0) start = 0;
+    if (stop >= len) stop = len - 1;
 
-        // Normalize negative indices
-        if (start < 0) start = len + start;
-        if (stop < 0) stop = len + stop;
+    if (start > stop || start >= len) return Form::emptyArray();
 
-        if (start < 0) start = 0;
-        if (stop >= len) stop = len - 1;
+    auto first = static_cast<size_t>(start);
+    auto last = static_cast<size_t>(stop);
 
-        if (start > stop || start >= len) return createArrayReply(0);
+    typename Form::ArrayBuilder builder;
+    list->forRange(first, last, [&](std::string_view item) { builder.measure(item.size()); });
+    builder.start();
+    list->forRange(first, last, [&](std::string_view item) { builder.append(item); });
+    return builder.finish();
+}
+template redis::Reply LRangeCmd::emit<ValueReplyForm>(std::string_view, int, int);
 
-        int count = stop - start + 1;
-        redisReply* reply = createArrayReply(count);
+CommandResult LRangeCmd::call(std::string_view key, int start, int stop)
+{
+    return emit<RawReplyForm>(key, start, stop);
+}
 
-        for (int i = 0; i < count; ++i)
-        {
-            const std::string& elem = list[start + i];
-            reply->element[i] = createStringReply(elem);
-        }
+// ---------
+//  LLEN CMD
+// ---------
+redis::Reply LLenCmd::call(std::string_view key)
+{
+    if (!isAuth) return redis::noAuth();
 
-        return reply;
-    }
+    auto [list, wrongType] = keyspace().find<ListValue>(key);
+    if (wrongType) return redis::wrongType();
+    if (list == nullptr) return redis::integer(0);
 
-    static inline CommandRegistrar<LRangeCmd> registrar{};
-};
+    return redis::integer(static_cast<long long>(list->size()));
+}
 
 // ---------
-//  LLEN CMD
+//  BLPOP CMD
 // ---------
-struct LLenCmd
+CommandResult BLPopCmd::call(ArgPack args)
 {
-    static constexpr const char* tag = "LLEN";
-    static constexpr const char* format = "LLEN %s";
-    using ArgTypes = std::tuple<std::string>;
-    
-    static CommandResult call(const std::string& key)
-    {
-        if (!isAuth) return createAuthErrorReply();
+    return blockingPop(args, ListEnd::Left);
+}
 
-        if (!listDb.contains(key)) return createIntegerReply(0);
+// ---------
+//  BRPOP CMD
+// ---------
+CommandResult BRPopCmd::call(ArgPack args)
+{
+    return blockingPop(args, ListEnd::Right);
+}
+
+// ---------
+//  BLMOVE CMD
+// ---------
+CommandResult BLMoveCmd::call(std::string_view source, std::string_view destination, std::string_view whereFrom,
+                              std::string_view whereTo, std::string_view timeout)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    ListEnd from{};
+    ListEnd to{};
+    if (!parseListEnd(whereFrom, from) || !parseListEnd(whereTo, to)) return createErrorReply("ERR syntax error");
+    double seconds = 0;
+    if (const char* error = parseTimeout(timeout, seconds)) return createErrorReply(error);
+
+    if (keyspace().find<ListValue>(destination).wrongType) return createWrongTypeReply();
 
-        auto& [list, expiry] = listDb.at(key);
-        if (isExpired(expiry))
+    auto [list, wrongType] = keyspace().find<ListValue>(source);
+    if (wrongType) return createWrongTypeReply();
+
+    if (list != nullptr)
+    {
+        // Copied: the pop frees the element, and the push may rehash the keyspace
+        std::string value(from == ListEnd::Left ? list->front() : list->back());
+        if (from == ListEnd::Left)
+        {
+            list->popFront();
+        }
+        else
         {
-            listDb.erase(key);
-            return createIntegerReply(0);
+            list->popBack();
         }
+        if (list->empty()) keyspace().erase(source);
 
-        return createIntegerReply(static_cast<int>(list.size()));
+        pushList(destination, value, to);
+        return createStringReply(value);
     }
 
+    BlockedPop waiter;
+    waiter.from = from;
+    waiter.destination = destination;
+    waiter.to = to;
+    waiter.keys.push_back(source);
+    setTimeout(waiter, seconds);
+    blockedClients().block(waiter);
 
-    
-    CommandRegistrar<LLenCmd> registrar{};
-};
+    switch (waiter.state)
+    {
+    case BlockedPop::State::Served:
+        return createStringReply(waiter.value);
+    case BlockedPop::State::WrongType:
+        return createWrongTypeReply();
+    default:
+        return createNilReply();
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// List commands (mock_redis_list.cpp)
+// -------------------
+
+struct LPushCmd
+{
+    static constexpr const char* tag = "LPUSH";
+    static constexpr const char* format = "LPUSH %s %s"; // key, element [element ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack values);
+};
+
+struct RPushCmd
+{
+    static constexpr const char* tag = "RPUSH";
+    static constexpr const char* format = "RPUSH %s %s"; // key, element [element ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack values);
+};
+
+struct LPopCmd
+{
+    static constexpr const char* tag = "LPOP";
+    static constexpr const char* format = "LPOP %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+struct RPopCmd
+{
+    static constexpr const char* tag = "RPOP";
+    static constexpr const char* format = "RPOP %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+struct LRangeCmd
+{
+    static constexpr const char* tag = "LRANGE";
+    static constexpr const char* format = "LRANGE %s %d %d";
+    using ArgTypes = std::tuple<std::string_view, int, int>;
+
+    template <typename Form> static auto emit(std::string_view key, int start, int stop) -> typename Form::Result;
+    static CommandResult call(std::string_view key, int start, int stop);
+};
+
+struct LLenCmd
+{
+    static constexpr const char* tag = "LLEN";
+    static constexpr const char* format = "LLEN %s";
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static redis::Reply call(std::string_view key);
+};
+
+// -------------------
+// Blocking pops: wait up to `timeout` seconds (0 = forever, fractions allowed) for a push onto an
+// empty list.  The timeout is read as text, so "BLPOP %s %d" calls are parsed into argv.
+// -------------------
+
+// BLPOP key [key ...] timeout: pops from the first non-empty key, or waits on all of them
+struct BLPopCmd
+{
+    static constexpr const char* tag = "BLPOP";
+    static constexpr const char* format = "BLPOP %s %s"; // key [key ...], timeout
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static CommandResult call(ArgPack args);
+};
+
+struct BRPopCmd
+{
+    static constexpr const char* tag = "BRPOP";
+    static constexpr const char* format = "BRPOP %s %s"; // key [key ...], timeout
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static CommandResult call(ArgPack args);
+};
+
+struct BLMoveCmd
+{
+    static constexpr const char* tag = "BLMOVE";
+    static constexpr const char* format = "BLMOVE %s %s %s %s %s"; // source, destination, LEFT|RIGHT, LEFT|RIGHT, timeout
+    using ArgTypes =
+        std::tuple<std::string_view, std::string_view, std::string_view, std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view source, std::string_view destination, std::string_view whereFrom,
+                              std::string_view whereTo, std::string_view timeout);
+};
@@ -1,58 +1,44 @@
 
-#include "mock_redis.h"
+#include "mock_redis_misc.h"
+
+#include "command_stats.h"
+#include "command_table.h"
+#include "keyspace.h"
 
 // -------------------
 // Auth Command
 // -------------------
 
+#include <cctype>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
 // Global map of channel to subscriber identifiers (simplified)
-static std::unordered_map<std::string, std::unordered_set<std::string>> channelSubscribers;
+static StringMap<StringSet> channelSubscribers;
 
-struct AuthCmd : AutoRegister<AuthCmd>
+CommandResult AuthCmd::call(std::string_view password)
 {
-    static constexpr const char* tag = "AUTH";
-    static constexpr const char* format = "AUTH %s"; // %s will be replaced by the password
-    using ArgTypes = std::tuple<std::string>;        // password
-
-    CommandResult operator() (const std::string& password)
-    { 
-      return AuthCmd::call(password);
-    }
-
-    static CommandResult call(const std::string& password)
+    if (password == "hunter2")
     {
-        if (password == "hunter2")
-        {
-            isAuth = true;
-            return createOkStatusReply();
-        }
-        isAuth = false;
-        return createErrorReply("-ERR invalid password");
+        isAuth = true;
+        return createOkStatusReply();
     }
-};
+    isAuth = false;
+    return createErrorReply("-ERR invalid password");
+}
 
 // -------------------
 // Ping Command
 // -------------------
-struct PingCmd : AutoRegister<AuthCmd>
+CommandResult PingCmd::call()
 {
-    static constexpr const char* tag = "PING";
-    static constexpr const char* format = "PING"; // No arguments, just "PING"
-    using ArgTypes = std::tuple<>;                // No arguments for PING
-
-    static CommandResult call()
+    if (!isAuth)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
-        return createStringReply("+PONG");
+        return createAuthErrorReply();
     }
-};
+    return createPongReply();
+}
 
 
 
@@ -60,42 +46,33 @@ struct PingCmd : AutoRegister<AuthCmd>
 //  PUBLISH CMD
 // ---------
 
-struct PublishCmd
+CommandResult PublishCmd::call(std::string_view channel, std::string_view message)
 {
-    static constexpr const char* tag = "PUBLISH";
-    static constexpr const char* format = "PUBLISH %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>; // channel, message
-
-    static CommandResult call(const std::string& channel, const std::string& message)
+    if (!isAuth)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
-
-        // Find subscribers to the channel
-        auto it = channelSubscribers.find(channel);
-        if (it == channelSubscribers.end())
-        {
-            // No subscribers
-            return createIntegerReply(0);
-        }
+        return createAuthErrorReply();
+    }
 
-        const auto& subscribers = it->second;
+    // Find subscribers to the channel
+    auto it = channelSubscribers.find(channel);
+    if (it == channelSubscribers.end())
+    {
+        // No subscribers
+        return createIntegerReply(0);
+    }
 
-        // For this mock, we just count subscribers.
-        // In a real Redis, you'd deliver messages to connected clients here.
-        int deliveredCount = static_cast<int>(subscribers.size());
+    const auto& subscribers = it->second;
 
-        // Log publishing (optional)
-        std::cout << "[Publish] Channel: " << channel << ", Message: " << message << ", Subscribers: " << deliveredCount
-                  << std::endl;
+    // For this mock, we just count subscribers.
+    // In a real Redis, you'd deliver messages to connected clients here.
+    int deliveredCount = static_cast<int>(subscribers.size());
 
-        return createIntegerReply(deliveredCount);
-    }
+    MOCK_REDIS_TRACE(TraceLevel::Info, "[Publish] Channel: %.*s, Message: %.*s, Subscribers: %d",
+                     static_cast<int>(channel.size()), channel.data(), static_cast<int>(message.size()), message.data(),
+                     deliveredCount);
 
-    static inline CommandRegistrar<PublishCmd> registrar{};
-};
+    return createIntegerReply(deliveredCount);
+}
 
 
 
@@ -103,98 +80,161 @@ struct PublishCmd
 //  SUBSCRIBE CMD
 // ---------
 
-struct SubscribeCmd
+CommandResult SubscribeCmd::call(std::string_view channel, std::string_view subscriberId)
 {
-    static constexpr const char* tag = "SUBSCRIBE";
-    static constexpr const char* format = "SUBSCRIBE %s %s"; // channel subscriberId
-    using ArgTypes = std::tuple<std::string, std::string>;   // channel, subscriber ID
-
-    static CommandResult call(const std::string& channel, const std::string& subscriberId)
+    if (!isAuth)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
-
-        channelSubscribers[channel].insert(subscriberId);
+        return createAuthErrorReply();
+    }
 
-        // In real Redis, SUBSCRIBE returns messages about subscription; here just OK
-        return createOkStatusReply();
+    auto it = channelSubscribers.find(channel);
+    if (it == channelSubscribers.end())
+    {
+        it = channelSubscribers.emplace(std::string(channel), StringSet{}).first;
+    }
+    if (!it->second.contains(subscriberId))
+    {
+        it->second.emplace(subscriberId);
     }
 
-    static inline CommandRegistrar<SubscribeCmd> registrar{};
-};
+    // In real Redis, SUBSCRIBE returns messages about subscription; here just OK
+    return createOkStatusReply();
+}
 
 
 // ---------
 //  UNSUBSCRIBE CMD
 // ---------
 
-struct UnsubscribeCmd
+CommandResult UnsubscribeCmd::call(std::string_view channel, std::string_view subscriberId)
 {
-    static constexpr const char* tag = "UNSUBSCRIBE";
-    static constexpr const char* format = "UNSUBSCRIBE %s %s"; // channel subscriberId
-    using ArgTypes = std::tuple<std::string, std::string>;     // channel, subscriber ID
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
 
-    static CommandResult call(const std::string& channel, const std::string& subscriberId)
+    auto it = channelSubscribers.find(channel);
+    if (it != channelSubscribers.end())
     {
-        if (!isAuth)
+        auto subscriberIt = it->second.find(subscriberId);
+        if (subscriberIt != it->second.end())
         {
-            return createAuthErrorReply();
+            it->second.erase(subscriberIt);
         }
-
-        auto it = channelSubscribers.find(channel);
-        if (it != channelSubscribers.end())
+        if (it->second.empty())
         {
-            it->second.erase(subscriberId);
-            if (it->second.empty())
-            {
-                channelSubscribers.erase(it);
-            }
+            channelSubscribers.erase(it);
         }
-
-        return createOkStatusReply();
     }
 
-    static inline CommandRegistrar<UnsubscribeCmd> registrar{};
-};
+    return createOkStatusReply();
+}
 
 
 // ---------
 //  LISTSUB CMD
 // ---------
 
-struct ListSubCmd
+redis::Reply ListSubCmd::call(std::string_view channel)
+{
+    if (!isAuth)
+    {
+        return redis::error("-NOAUTH Authentication required");
+    }
+
+    redis::Array subscribers;
+    auto it = channelSubscribers.find(channel);
+    if (it != channelSubscribers.end())
+    {
+        subscribers.data.reserve(it->second.size());
+        for (const auto& sub : it->second)
+        {
+            subscribers.data.push_back(redis::bulk(sub));
+        }
+    }
+
+    return redis::Reply(redis::Type::Array, std::move(subscribers));
+}
+
+// ---------
+//  INFO / LATENCY CMDS
+// ---------
+
+redis::Reply InfoCmd::call(std::string_view section)
 {
-    static constexpr const char* tag = "LISTSUB";
-    static constexpr const char* format = "LISTSUB %s"; // channel
-    using ArgTypes = std::tuple<std::string>;           // channel
+    if (!isAuth)
+    {
+        return redis::error("-NOAUTH Authentication required");
+    }
+
+    // Like Redis, an unknown section is just empty
+    if (equalsIgnoreCase(section, "commandstats"))
+    {
+        return redis::bulk(formatCommandStats());
+    }
+    if (equalsIgnoreCase(section, "stats"))
+    {
+        return redis::bulk("# Stats\r\nexpired_keys:" + std::to_string(keyspace().expiredCount()) + "\r\n");
+    }
+    if (equalsIgnoreCase(section, "keyspace"))
+    {
+        return redis::bulk("# Keyspace\r\ndb0:keys=" + std::to_string(keyspace().size()) +
+                           ",expires=" + std::to_string(keyspace().volatileCount()) + "\r\n");
+    }
+    return redis::bulk(std::string());
+}
 
-    static CommandResult call(const std::string& channel)
+// {command: {calls, histogram_nsec: {bucket floor: cumulative calls}}}, skipping
+// commands that have not been called and empty buckets; commands are named in lower case, as in Redis
+static redis::Reply latencyHistogram(std::string_view only)
+{
+    redis::Map commands;
+    for (const CommandStats& s : commandStats())
     {
-        if (!isAuth)
+        if (s.calls == 0 || (!only.empty() && !equalsIgnoreCase(only, s.name)))
         {
-            return createAuthErrorReply();
+            continue;
         }
 
-        auto it = channelSubscribers.find(channel);
-        if (it == channelSubscribers.end())
+        redis::Map buckets;
+        long long cumulative = 0;
+        for (size_t b = 0; b < s.histogram.size(); ++b)
         {
-            // No subscribers, return empty array
-            return createArrayReply(0);
+            if (s.histogram[b] == 0) continue;
+            cumulative += static_cast<long long>(s.histogram[b]);
+            buckets.data.emplace(redis::integer(static_cast<long long>(latencyBucketFloor(b))),
+                                 redis::integer(cumulative));
         }
 
-        const auto& subs = it->second;
-        redisReply* reply = createArrayReply(subs.size());
+        redis::Map entry;
+        entry.data.emplace(redis::bulk("calls"), redis::integer(static_cast<long long>(s.calls)));
+        entry.data.emplace(redis::bulk("histogram_nsec"), redis::Reply(redis::Type::Map, std::move(buckets)));
 
-        for (size_t i = 0; i < subs.size(); ++i)
+        std::string name(s.name);
+        for (char& ch : name)
         {
-            // NOTE: redisReply->element is an array of pointers
-            reply->element[i] = createStringReply(*std::next(subs.begin(), i));
+            ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
         }
+        commands.data.emplace(redis::bulk(std::move(name)), redis::Reply(redis::Type::Map, std::move(entry)));
+    }
+    return redis::Reply(redis::Type::Map, std::move(commands));
+}
+
+redis::Reply LatencyCmd::call(std::string_view subcommand)
+{
+    return LatencyForCmd::call(subcommand, {});
+}
 
-        return reply;
+redis::Reply LatencyForCmd::call(std::string_view subcommand, std::string_view command)
+{
+    if (!isAuth)
+    {
+        return redis::error("-NOAUTH Authentication required");
     }
 
-    static inline CommandRegistrar<ListSubCmd> registrar{};
-};
\ No newline at end of file
+    if (!equalsIgnoreCase(subcommand, "HISTOGRAM"))
+    {
+        return redis::error("ERR unknown subcommand '" + std::string(subcommand) + "'");
+    }
+    return latencyHistogram(command);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// Connection and pub/sub commands (mock_redis_misc.cpp)
+// -------------------
+
+struct AuthCmd
+{
+    static constexpr const char* tag = "AUTH";
+    static constexpr const char* format = "AUTH %s"; // %s will be replaced by the password
+    using ArgTypes = std::tuple<std::string_view>;   // password
+
+    CommandResult operator()(std::string_view password) { return AuthCmd::call(password); }
+
+    static CommandResult call(std::string_view password);
+};
+
+struct PingCmd
+{
+    static constexpr const char* tag = "PING";
+    static constexpr const char* format = "PING"; // No arguments, just "PING"
+    using ArgTypes = std::tuple<>;                // No arguments for PING
+
+    static CommandResult call();
+};
+
+struct PublishCmd
+{
+    static constexpr const char* tag = "PUBLISH";
+    static constexpr const char* format = "PUBLISH %s %s";
+    using ArgTypes = std::tuple<std::string_view, std::string_view>; // channel, message
+
+    static CommandResult call(std::string_view channel, std::string_view message);
+};
+
+struct SubscribeCmd
+{
+    static constexpr const char* tag = "SUBSCRIBE";
+    static constexpr const char* format = "SUBSCRIBE %s %s";         // channel subscriberId
+    using ArgTypes = std::tuple<std::string_view, std::string_view>; // channel, subscriber ID
+
+    static CommandResult call(std::string_view channel, std::string_view subscriberId);
+};
+
+struct UnsubscribeCmd
+{
+    static constexpr const char* tag = "UNSUBSCRIBE";
+    static constexpr const char* format = "UNSUBSCRIBE %s %s";       // channel subscriberId
+    using ArgTypes = std::tuple<std::string_view, std::string_view>; // channel, subscriber ID
+
+    static CommandResult call(std::string_view channel, std::string_view subscriberId);
+};
+
+struct ListSubCmd
+{
+    static constexpr const char* tag = "LISTSUB";
+    static constexpr const char* format = "LISTSUB %s"; // channel
+    using ArgTypes = std::tuple<std::string_view>;      // channel
+
+    static redis::Reply call(std::string_view channel); // value-typed: converted only for the C API
+};
+
+// -------------------
+// Introspection commands (command_stats.h)
+// -------------------
+
+struct InfoCmd
+{
+    static constexpr const char* tag = "INFO";
+    static constexpr const char* format = "INFO %s"; // section: commandstats, stats or keyspace
+    using ArgTypes = std::tuple<std::string_view>;   // section
+
+    static redis::Reply call(std::string_view section);
+};
+
+struct LatencyCmd
+{
+    static constexpr const char* tag = "LATENCY";
+    static constexpr const char* format = "LATENCY %s"; // HISTOGRAM: every command that has been called
+    using ArgTypes = std::tuple<std::string_view>;      // subcommand
+
+    static redis::Reply call(std::string_view subcommand);
+};
+
+struct LatencyForCmd
+{
+    static constexpr const char* tag = "LATENCY";
+    static constexpr const char* format = "LATENCY %s %s";           // HISTOGRAM command
+    using ArgTypes = std::tuple<std::string_view, std::string_view>; // subcommand, command name
+
+    static redis::Reply call(std::string_view subcommand, std::string_view command);
+};
@@ -1,118 +1,437 @@
 
-#include "mock_redis.h"
+#include "mock_redis_set.h"
+#include "command_table.h"
+#include "keyspace.h"
+#include "reply_pool.h"
+#include "scan.h"
 
-#include <cstring>
-static std::unordered_map<std::string, std::unordered_set<std::string>> setDb;
+#include <algorithm>
+#include <charconv>
+#include <vector>
 
-// -------------------
-// SADD Command
-// -------------------
-struct SAddTag : AutoRegister<SAddTag>
+namespace
 {
-    static constexpr const char* tag = "SADD";
-    static constexpr const char* format = "SADD %s %s"; // %s for key and member
-    using ArgTypes = std::tuple<std::string, std::string>;
+// The sets at keys, for reading; nullptr for a missing key.  False if a key holds another type.
+auto findSets(ArgPack keys, std::vector<const SetValue*>& sets) -> bool
+{
+    // A lookup can expire a key, and that erase can move entries, so every key is looked up once to
+    // settle expiry before any pointer is kept; the second round then erases nothing
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        if (keyspace().find<SetValue>(keys[i]).wrongType) return false;
+    }
 
-    static redisReply* call(const std::string& key, const std::string& member)
+    sets.clear();
+    for (size_t i = 0; i < keys.size(); ++i)
     {
-        auto* reply = createRedisReply();
+        sets.push_back(keyspace().find<SetValue>(keys[i]).value);
+    }
+    return true;
+}
+
+auto allIntSets(const std::vector<const SetValue*>& sets) -> bool
+{
+    return std::all_of(sets.begin(), sets.end(), [](const SetValue* set) { return set->intSet() != nullptr; });
+}
+
+// Intersection or difference of intsets by sorted merge: the first set's values, narrowed by each
+// of the others in turn, passed to emit until it returns false
+template <typename Emit> void retainIntegers(const std::vector<const SetValue*>& sets, bool common, Emit&& emit)
+{
+    thread_local std::vector<int64_t> values;
+    values.clear();
+    sets[0]->intSet()->forEach([&](int64_t value) { values.push_back(value); });
 
-        if (!isAuth)
+    size_t n = values.size();
+    for (size_t i = 1; i < sets.size() && n > 0; ++i)
+    {
+        const IntSet* other = sets[i]->intSet();
+        n = common ? other->retainCommon(values.data(), n) : other->retainMissing(values.data(), n);
+    }
+
+    char digits[24];
+    for (size_t i = 0; i < n; ++i)
+    {
+        auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), values[i]);
+        if (!emit(std::string_view(digits, static_cast<size_t>(end - digits)))) return;
+    }
+}
+
+// SINTER: each member of the smallest set is probed against the others, smallest first, so most
+// candidates are rejected by the first probe and the largest sets are rarely consulted
+template <typename Emit> void intersect(std::vector<const SetValue*>& sets, Emit&& emit)
+{
+    // A missing key is an empty set
+    if (std::find(sets.begin(), sets.end(), nullptr) != sets.end()) return;
+
+    std::sort(sets.begin(), sets.end(), [](const SetValue* a, const SetValue* b) { return a->size() < b->size(); });
+    if (allIntSets(sets)) return retainIntegers(sets, true, emit);
+
+    sets[0]->forEachWhile(
+        [&](std::string_view member)
         {
-            reply->type = REDIS_REPLY_ERROR;
-            reply->str = (char*)"-NOAUTH Authentication required";
-            reply->len = strlen(reply->str);
-            return reply;
-        }
+            for (size_t i = 1; i < sets.size(); ++i)
+            {
+                if (sets[i] != sets[0] && !sets[i]->contains(member)) return true;
+            }
+            return emit(member);
+        });
+}
+
+// SDIFF: the members of the first set found in none of the others
+template <typename Emit> void difference(std::vector<const SetValue*>& sets, Emit&& emit)
+{
+    const SetValue* first = sets[0];
+    if (first == nullptr) return;
+
+    sets.erase(std::remove(sets.begin() + 1, sets.end(), nullptr), sets.end());
+    if (std::find(sets.begin() + 1, sets.end(), first) != sets.end()) return; // X - X is empty
+
+    // Largest first: the likeliest to hold a member, which ends its probes
+    std::sort(sets.begin() + 1, sets.end(), [](const SetValue* a, const SetValue* b) { return a->size() > b->size(); });
+    if (allIntSets(sets)) return retainIntegers(sets, false, emit);
+
+    first->forEachWhile(
+        [&](std::string_view member)
+        {
+            for (size_t i = 1; i < sets.size(); ++i)
+            {
+                if (sets[i]->contains(member)) return true;
+            }
+            return emit(member);
+        });
+}
 
-        bool inserted = setDb[key].insert(member).second;
-        reply->type = REDIS_REPLY_INTEGER;
-        reply->integer = inserted ? 1 : 0;
-        return reply;
+void unite(const std::vector<const SetValue*>& sets, SetValue& result)
+{
+    for (const SetValue* set : sets)
+    {
+        if (set != nullptr) set->forEach([&](std::string_view member) { result.add(member); });
     }
+}
+
+enum class SetOp
+{
+    Inter,
+    Union,
+    Diff,
 };
 
+template <typename Emit> void combine(SetOp op, std::vector<const SetValue*>& sets, Emit&& emit)
+{
+    if (op == SetOp::Inter)
+    {
+        intersect(sets, emit);
+    }
+    else
+    {
+        difference(sets, emit);
+    }
+}
 
+auto setOpReply(SetOp op, ArgPack keys) -> redisReply*
+{
+    thread_local std::vector<const SetValue*> sets;
+    if (!findSets(keys, sets)) return createWrongTypeReply();
+
+    ArrayReplyBuilder builder;
+    if (op == SetOp::Union)
+    {
+        SetValue result;
+        unite(sets, result);
+        result.forEach([&](std::string_view member) { builder.measure(member.size()); });
+        builder.start();
+        result.forEach([&](std::string_view member) { builder.append(member); });
+        return builder.finish();
+    }
+
+    // Members are copied out as they are found: an intset's are formatted into a scratch buffer
+    ScanBatch& batch = scanBatch();
+    batch.clear();
+    combine(op, sets,
+            [&](std::string_view member)
+            {
+                batch.add(member);
+                return true;
+            });
+
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        builder.measure(batch[i].size());
+    }
+    builder.start();
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        builder.append(batch[i]);
+    }
+    return builder.finish();
+}
+
+// The result goes straight into a new set, with no reply built; it replaces the destination only
+// once every input has been read, since the destination may be one of them
+auto setOpStore(SetOp op, std::string_view destination, ArgPack keys) -> redisReply*
+{
+    thread_local std::vector<const SetValue*> sets;
+    if (!findSets(keys, sets)) return createWrongTypeReply();
+
+    SetValue result;
+    if (op == SetOp::Union)
+    {
+        unite(sets, result);
+    }
+    else
+    {
+        combine(op, sets,
+                [&](std::string_view member)
+                {
+                    result.add(member);
+                    return true;
+                });
+    }
+
+    size_t size = result.size();
+    if (size == 0)
+    {
+        keyspace().erase(destination);
+    }
+    else
+    {
+        keyspace().store(destination, std::move(result));
+    }
+    return createIntegerReply(static_cast<long long>(size));
+}
+} // namespace
+
+// -------------------
+// SADD Command
+// -------------------
+redisReply* SAddTag::call(std::string_view key, ArgPack members)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    auto [set, wrongType] = keyspace().findOrCreate<SetValue>(key);
+    if (wrongType)
+    {
+        return createWrongTypeReply();
+    }
+
+    int added = 0;
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+        added += set->add(members[i]) ? 1 : 0;
+    }
+    return createIntegerReply(added);
+}
 
 // -------------------
 // SMEMBERS Command
 // -------------------
-struct SMembersTag : AutoRegister<SMembersTag>
+template <typename Form> auto SMembersTag::emit(std::string_view key) -> typename Form::Result
+{
+    if (!isAuth)
+    {
+        return Form::noAuth();
+    }
+
+    auto [members, wrongType] = keyspace().find<SetValue>(key);
+    if (wrongType)
+    {
+        return Form::wrongType();
+    }
+    if (members == nullptr)
+    {
+        return Form::emptyArray();
+    }
+
+    typename Form::ArrayBuilder builder;
+    members->forEach([&](std::string_view item) { builder.measure(item.size()); });
+    builder.start();
+    members->forEach([&](std::string_view item) { builder.append(item); });
+    return builder.finish();
+}
+template redis::Reply SMembersTag::emit<ValueReplyForm>(std::string_view);
+
+CommandResult SMembersTag::call(std::string_view key)
+{
+    return emit<RawReplyForm>(key);
+}
+
+// -------------------
+// SREM Command
+// -------------------
+redisReply* SRemTag::call(std::string_view key, ArgPack members)
 {
-    static constexpr const char* tag = "SMEMBERS";
-    static constexpr const char* format = "SMEMBERS %s"; // %s for key
-    using ArgTypes = std::tuple<std::string>;            // key (name of the set)
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
 
-    static CommandResult call(const std::string& key)
+    auto [set, wrongType] = keyspace().find<SetValue>(key);
+    if (wrongType)
+    {
+        return createWrongTypeReply();
+    }
+    if (set == nullptr)
     {
-        auto* reply = createRedisReply();
+        return createIntegerReply(0);
+    }
 
-        if (!isAuth)
-        {
-            reply->type = REDIS_REPLY_ERROR;
-            reply->str = (char*)"-NOAUTH Authentication required";
-            reply->len = strlen(reply->str);
-            return reply;
-        }
+    int removed = 0;
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+        removed += set->remove(members[i]) ? 1 : 0;
+    }
+    if (set->empty()) keyspace().erase(key);
 
-        auto it = setDb.find(key);
-        if (it == setDb.end())
-        {
-            reply->type = REDIS_REPLY_ARRAY;
-            reply->len = 0;
-            reply->element = nullptr;
-        }
-        else
-        {
-            reply->type = REDIS_REPLY_ARRAY;
-            reply->len = it->second.size();
-            reply->element = (redisReply**)malloc(it->second.size() * sizeof(redisReply*));
+    return createIntegerReply(removed);
+}
 
-            int i = 0;
-            for (const auto& item : it->second)
-            {
-                reply->element[i] = (redisReply*)malloc(sizeof(redisReply));
-                reply->element[i]->type = REDIS_REPLY_STRING;
-                reply->element[i]->str = (char*)item.c_str();
-                reply->element[i]->len = item.length();
-                i++;
-            }
-        }
+// -------------------
+// SSCAN Command
+// -------------------
+redisReply* SScanTag::call(std::string_view key, ArgPack args)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    ScanArgs scan;
+    if (const char* error = parseScanArgs(args, false, scan))
+    {
+        return createErrorReply(error);
+    }
 
-        return reply;
+    auto [set, wrongType] = keyspace().find<SetValue>(key);
+    if (wrongType)
+    {
+        return createWrongTypeReply();
+    }
+
+    ScanBatch& batch = scanBatch();
+    batch.clear();
+    if (set == nullptr)
+    {
+        return scanReply(0, batch);
     }
-};
+
+    auto visit = [&](std::string_view member)
+    {
+        if (scan.pattern.empty() || globMatch(scan.pattern, member)) batch.add(member);
+    };
+    uint64_t cursor = scanSteps(scan, batch, 1, [&](uint64_t at) { return set->scan(at, visit); });
+    return scanReply(cursor, batch);
+}
 
 // -------------------
-// SREM Command
+// SINTER / SINTERSTORE / SINTERCARD Commands
 // -------------------
-struct SRemTag : AutoRegister<SRemTag>
+redisReply* SInterTag::call(ArgPack keys)
 {
-    static constexpr const char* tag = "SREM";
-    static constexpr const char* format = "SREM %s %s"; // %s for key and member
-    using ArgTypes = std::tuple<std::string, std::string>;
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    return setOpReply(SetOp::Inter, keys);
+}
+
+redisReply* SInterStoreTag::call(std::string_view destination, ArgPack keys)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    return setOpStore(SetOp::Inter, destination, keys);
+}
 
-    static redisReply* call(const std::string& key, const std::string& member)
+redisReply* SInterCardTag::call(int numKeys, ArgPack args)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    if (numKeys <= 0)
+    {
+        return createErrorReply("ERR numkeys should be greater than 0");
+    }
+    if (static_cast<size_t>(numKeys) > args.size())
     {
-        auto* reply = createRedisReply();
+        return createErrorReply("ERR Number of keys can't be greater than number of args");
+    }
 
-        if (!isAuth)
+    // LIMIT 0, the default, counts the whole intersection
+    long long limit = 0;
+    for (size_t i = static_cast<size_t>(numKeys); i < args.size(); i += 2)
+    {
+        if (!equalsIgnoreCase(args[i], "LIMIT") || i + 1 >= args.size())
         {
-            reply->type = REDIS_REPLY_ERROR;
-            reply->str = (char*)"-NOAUTH Authentication required";
-            reply->len = strlen(reply->str);
-            return reply;
+            return createErrorReply("ERR syntax error");
         }
-
-        auto it = setDb.find(key);
-        bool removed = false;
-        if (it != setDb.end())
+        std::string_view value = args[i + 1];
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), limit);
+        if (ec != std::errc() || end != value.data() + value.size())
+        {
+            return createErrorReply(argvIntegerError);
+        }
+        if (limit < 0)
         {
-            removed = it->second.erase(member) > 0;
+            return createErrorReply("ERR LIMIT can't be negative");
         }
+    }
 
-        reply->type = REDIS_REPLY_INTEGER;
-        reply->integer = removed ? 1 : 0;
-        return reply;
+    thread_local std::vector<const SetValue*> sets;
+    if (!findSets(ArgPack{args.argv, args.argvlen, static_cast<size_t>(numKeys)}, sets))
+    {
+        return createWrongTypeReply();
     }
-};
+
+    // Counting stops at the limit instead of finishing the intersection
+    long long count = 0;
+    intersect(sets, [&](std::string_view) { return ++count != limit; });
+    return createIntegerReply(count);
+}
+
+// -------------------
+// SUNION / SUNIONSTORE Commands
+// -------------------
+redisReply* SUnionTag::call(ArgPack keys)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    return setOpReply(SetOp::Union, keys);
+}
+
+redisReply* SUnionStoreTag::call(std::string_view destination, ArgPack keys)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    return setOpStore(SetOp::Union, destination, keys);
+}
+
+// -------------------
+// SDIFF / SDIFFSTORE Commands
+// -------------------
+redisReply* SDiffTag::call(ArgPack keys)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    return setOpReply(SetOp::Diff, keys);
+}
+
+redisReply* SDiffStoreTag::call(std::string_view destination, ArgPack keys)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    return setOpStore(SetOp::Diff, destination, keys);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// Set commands (mock_redis_set.cpp)
+// -------------------
+
+struct SAddTag
+{
+    static constexpr const char* tag = "SADD";
+    static constexpr const char* format = "SADD %s %s"; // key, member [member ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static redisReply* call(std::string_view key, ArgPack members);
+};
+
+struct SMembersTag
+{
+    static constexpr const char* tag = "SMEMBERS";
+    static constexpr const char* format = "SMEMBERS %s"; // %s for key
+    using ArgTypes = std::tuple<std::string_view>;       // key (name of the set)
+
+    template <typename Form> static auto emit(std::string_view key) -> typename Form::Result;
+    static CommandResult call(std::string_view key);
+};
+
+struct SRemTag
+{
+    static constexpr const char* tag = "SREM";
+    static constexpr const char* format = "SREM %s %s"; // key, member [member ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static redisReply* call(std::string_view key, ArgPack members);
+};
+
+struct SScanTag
+{
+    static constexpr const char* tag = "SSCAN";
+    static constexpr const char* format = "SSCAN %s %s"; // key, cursor [MATCH pattern] [COUNT count]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static redisReply* call(std::string_view key, ArgPack args);
+};
+
+struct SInterTag
+{
+    static constexpr const char* tag = "SINTER";
+    static constexpr const char* format = "SINTER %s"; // key [key ...]
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static redisReply* call(ArgPack keys);
+};
+
+struct SInterStoreTag
+{
+    static constexpr const char* tag = "SINTERSTORE";
+    static constexpr const char* format = "SINTERSTORE %s %s"; // destination, key [key ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static redisReply* call(std::string_view destination, ArgPack keys);
+};
+
+struct SInterCardTag
+{
+    static constexpr const char* tag = "SINTERCARD";
+    static constexpr const char* format = "SINTERCARD %d %s"; // numkeys, key [key ...] [LIMIT limit]
+    using ArgTypes = std::tuple<int, ArgPack>;
+
+    static redisReply* call(int numKeys, ArgPack args);
+};
+
+struct SUnionTag
+{
+    static constexpr const char* tag = "SUNION";
+    static constexpr const char* format = "SUNION %s"; // key [key ...]
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static redisReply* call(ArgPack keys);
+};
+
+struct SUnionStoreTag
+{
+    static constexpr const char* tag = "SUNIONSTORE";
+    static constexpr const char* format = "SUNIONSTORE %s %s"; // destination, key [key ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static redisReply* call(std::string_view destination, ArgPack keys);
+};
+
+struct SDiffTag
+{
+    static constexpr const char* tag = "SDIFF";
+    static constexpr const char* format = "SDIFF %s"; // key [key ...]
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static redisReply* call(ArgPack keys);
+};
+
+struct SDiffStoreTag
+{
+    static constexpr const char* tag = "SDIFFSTORE";
+    static constexpr const char* format = "SDIFFSTORE %s %s"; // destination, key [key ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static redisReply* call(std::string_view destination, ArgPack keys);
+};
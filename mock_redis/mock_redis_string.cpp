@@ -1,241 +1,418 @@
-#include "mock_redis.h"
+#include "mock_redis_string.h"
+#include "keyspace.h"
 
-static std::unordered_map<std::string, std::pair<std::string, std::chrono::time_point<std::chrono::system_clock>>>
-    strDb;
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <vector>
 
-// Helper function to check expiration
-bool isExpired(const std::chrono::time_point<std::chrono::system_clock>& expiryTime)
+namespace
 {
-    return std::chrono::system_clock::now() > expiryTime;
+// INCR, INCRBY, DECR, DECRBY: a missing key counts as 0 and an existing one keeps its TTL
+auto incrBy(std::string_view key, int64_t delta) -> CommandResult
+{
+    auto [value, wrongType] = keyspace().find<StringValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (value == nullptr)
+    {
+        keyspace().store(key, StringValue(delta));
+        return createIntegerReply(delta);
+    }
+
+    int64_t result = 0;
+    switch (value->incrBy(delta, result))
+    {
+    case IncrResult::Ok:
+        return createIntegerReply(result);
+    case IncrResult::NotInteger:
+        return createErrorReply(argvIntegerError);
+    case IncrResult::Overflow:
+        break;
+    }
+    return createErrorReply("ERR increment or decrement would overflow");
 }
 
-struct SetBinaryCmd : AutoRegister<SetBinaryCmd>
+// A long double as INCRBYFLOAT reads one: the whole text, finite
+auto parseLongDouble(std::string_view s, long double& value) -> bool
 {
-    static constexpr const char* tag = "SETB";                      // distinguish from regular SET
-    static constexpr const char* format = "SET %s %b";              // format string
-    using ArgTypes = std::tuple<std::string, BinaryValue>;          // tuple of expected argument types
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && end == s.data() + s.size() && !s.empty() && std::isfinite(value);
+}
+} // namespace
 
-    static CommandResult call(const std::string& key, const BinaryValue& binVal)
+// -------------------
+// Set Binary Command
+// -------------------
+
+CommandResult SetBinaryCmd::call(std::string_view key, BinaryView binVal)
+{
+    if (!isAuth)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
+        return createAuthErrorReply();
+    }
+
+    keyspace().setString(key, binVal.view());
+
+    return createOkStatusReply();
+}
 
-        strDb[key] = {binVal.data, std::chrono::time_point<std::chrono::system_clock>::max()};
+// -------------------
+// SetEx Binary Command
+// -------------------
 
-        return createOkStatusReply();
+CommandResult SetExBinaryCmd::call(std::string_view key, int seconds, BinaryView binVal)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
     }
 
-};
+    auto expiry = commandNow() + std::chrono::seconds(seconds);
+    keyspace().setString(key, binVal.view(), expiry);
 
+    return createOkStatusReply();
+}
 
-struct SetExBinaryCmd : AutoRegister<SetExBinaryCmd>
+// -------------------
+// Get Command
+// -------------------
+template <typename Form> auto GetCmd::emit(std::string_view key) -> typename Form::Result
 {
-    static constexpr const char* tag = "SETEXB";
-    static constexpr const char* format = "SETEX %s %d %b"; // key, seconds, binary
-    using ArgTypes = std::tuple<std::string, int, BinaryValue>;
+    if (!isAuth)
+    {
+        return Form::noAuth();
+    }
 
-    static CommandResult call(const std::string& key, int seconds, const BinaryValue& binVal)
+    auto [value, wrongType] = keyspace().find<StringValue>(key);
+    if (wrongType)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
+        return Form::wrongType();
+    }
+    if (value == nullptr)
+    {
+        return Form::nil();
+    }
 
-        auto expiry = std::chrono::system_clock::now() + std::chrono::seconds(seconds);
-        strDb[key] = {binVal.data, expiry};
+    Digits digits;
+    return Form::bulk(value->view(digits));
+}
+template redis::Reply GetCmd::emit<ValueReplyForm>(std::string_view);
 
-        return createOkStatusReply();
-    }
-};
+CommandResult GetCmd::call(std::string_view key)
+{
+    return emit<RawReplyForm>(key);
+}
 
 // -------------------
-// Exists Command
+// Set Command
 // -------------------
 
-struct ExistsCmd: AutoRegister<ExistsCmd>
+CommandResult SetCmd::call(std::string_view key, std::string_view val)
 {
-    static constexpr const char* tag = "EXISTS";
-    static constexpr const char* format = "EXISTS %s"; // key
-    using ArgTypes = std::tuple<std::string>;
 
-    static CommandResult call(const std::string& key)
+    if (!isAuth)
     {
+        return createAuthErrorReply();
+    }
 
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
-
-        if (!strDb.contains(key))
-        {
-            return createIntegerReply(0);
-        }
+    // No expiration: a plain SET also clears any previous TTL
+    keyspace().setString(key, val);
 
-        const auto& [value, expiry] = strDb.at(key);
-        if (isExpired(expiry))
-        {
-            return createIntegerReply(0);
-        }
+    return createOkStatusReply();
+}
+// -------------------
+// SetEx Command
+// -------------------
 
-        return createIntegerReply(1);
+CommandResult SetExCmd::call(std::string_view key, int seconds, std::string_view val)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
     }
-};
+
+    auto expiry = commandNow() + std::chrono::seconds(seconds);
+    keyspace().setString(key, val, expiry);
+
+    return createOkStatusReply();
+}
 
 // -------------------
-// Expire Command
+// MSet Command
 // -------------------
 
-struct ExpireCmd: AutoRegister<ExpireCmd>
+CommandResult MSetCmd::call(ArgPack pairs)
 {
-    static constexpr const char* tag = "EXPIRE";
-    static constexpr const char* format = "EXPIRE %s %d"; // key, seconds
-    using ArgTypes = std::tuple<std::string, int>;
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+    if (pairs.size() % 2 != 0)
+    {
+        return createErrorReply("ERR wrong number of arguments for 'mset' command");
+    }
 
-    static CommandResult call(const std::string& key, int seconds)
+    for (size_t i = 0; i < pairs.size(); i += 2)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
+        keyspace().setString(pairs[i], pairs[i + 1]);
+    }
 
-        if (!strDb.contains(key))
-        {
-            return createIntegerReply(0); // not found
-        }
+    return createOkStatusReply();
+}
 
-        auto& [value, expiry] = strDb.at(key);
+// -------------------
+// MGet Command
+// -------------------
 
-        if (isExpired(expiry))
+template <typename Form> auto MGetCmd::emit(ArgPack keys) -> typename Form::Result
+{
+    if (!isAuth)
+    {
+        return Form::noAuth();
+    }
+
+    // Each key is looked up once, while measuring; a key of another type reads as nil, as in Redis
+    thread_local std::vector<const StringValue*> values;
+    Keyspace& ks = keyspace();
+    auto lookUp = [&]
+    {
+        values.clear();
+        for (size_t i = 0; i < keys.size(); ++i)
         {
-            return createIntegerReply(0); // already expired
+            values.push_back(ks.find<StringValue>(keys[i]).value);
         }
+    };
 
-        expiry = std::chrono::system_clock::now() + std::chrono::seconds(seconds);
-        return createIntegerReply(1); // updated
+    uint64_t expiredBefore = ks.expiredCount();
+    lookUp();
+    if (ks.expiredCount() != expiredBefore)
+    {
+        // A lazy expiry erased a key and may have moved entries seen earlier; nothing is left to expire now
+        lookUp();
     }
-};
 
-// -------------------
-// Get Command
-// -------------------
-struct GetCmd: AutoRegister<GetCmd>
-{
-    static constexpr const char* tag = "GET";
-    static constexpr const char* format = "GET %s"; // %s for key
-    using ArgTypes = std::tuple<std::string>;       // key
-
-    static CommandResult call(const std::string& key)
+    // An integer is formatted once to measure it and again to copy it, which is cheaper than keeping it
+    Digits digits;
+    typename Form::ArrayBuilder builder;
+    for (const StringValue* value : values)
     {
-        if (!isAuth)
+        if (value != nullptr)
         {
-            return createAuthErrorReply();
+            builder.measure(value->view(digits).size());
         }
-
-        if (!strDb.contains(key))
+        else
         {
-            return createNilReply();
+            builder.measureNil();
         }
-
-        auto& [value, expiry] = strDb.at(key);
-
-        if (isExpired(expiry))
+    }
+    builder.start();
+    for (const StringValue* value : values)
+    {
+        if (value != nullptr)
         {
-            strDb.erase(key); // Remove expired key
-            return createNilReply();
+            builder.append(value->view(digits));
+        }
+        else
+        {
+            builder.appendNil();
         }
-
-        return createStringReply(value);
     }
-};
+    return builder.finish();
+}
+template redis::Reply MGetCmd::emit<ValueReplyForm>(ArgPack);
+
+CommandResult MGetCmd::call(ArgPack keys)
+{
+    return emit<RawReplyForm>(keys);
+}
 
 // -------------------
-// Set Command
+// Incr / Decr Commands
 // -------------------
 
-struct SetCmd: AutoRegister<SetCmd>
+CommandResult IncrCmd::call(std::string_view key)
 {
-    static constexpr const char* tag = "SET";
-    static constexpr const char* format = "SET %s %s";
-    using ArgTypes = std::tuple<std::string, std::string>;
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
 
-    static CommandResult call(const std::string& key, const std::string& val)
+    return incrBy(key, 1);
+}
+
+CommandResult DecrCmd::call(std::string_view key)
+{
+    if (!isAuth)
     {
+        return createAuthErrorReply();
+    }
 
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
+    return incrBy(key, -1);
+}
+
+CommandResult IncrByCmd::call(std::string_view key, std::string_view increment)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    int64_t delta = 0;
+    if (!IntSet::parse(increment, delta))
+    {
+        return createErrorReply(argvIntegerError);
+    }
 
-        // No expiration: store with epoch time (never expires)
-        strDb[key] = {val, std::chrono::time_point<std::chrono::system_clock>::max()};
+    return incrBy(key, delta);
+}
 
-        return createOkStatusReply();
+CommandResult DecrByCmd::call(std::string_view key, std::string_view decrement)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
     }
-};
+
+    int64_t delta = 0;
+    if (!IntSet::parse(decrement, delta))
+    {
+        return createErrorReply(argvIntegerError);
+    }
+    if (delta == std::numeric_limits<int64_t>::min())
+    {
+        return createErrorReply("ERR decrement would overflow");
+    }
+
+    return incrBy(key, -delta);
+}
+
 // -------------------
-// SetEx Command
+// IncrByFloat Command
 // -------------------
 
-struct SetExCmd: AutoRegister<SetExCmd>
+CommandResult IncrByFloatCmd::call(std::string_view key, std::string_view increment)
 {
-    static constexpr const char* tag = "SETEX";
-    static constexpr const char* format = "SETEX %s %d %s"; // key, seconds, value
-    using ArgTypes = std::tuple<std::string, int, std::string>;
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
+
+    long double delta = 0;
+    if (!parseLongDouble(increment, delta))
+    {
+        return createErrorReply("ERR value is not a valid float");
+    }
+
+    auto [value, wrongType] = keyspace().find<StringValue>(key);
+    if (wrongType)
+    {
+        return createWrongTypeReply();
+    }
 
-    static CommandResult call(const std::string& key, int seconds, const std::string& val)
+    long double current = 0;
+    if (value != nullptr)
     {
-        if (!isAuth)
+        Digits digits;
+        if (const int64_t* integer = value->integer())
         {
-            return createAuthErrorReply();
+            current = static_cast<long double>(*integer);
         }
+        else if (!parseLongDouble(value->view(digits), current))
+        {
+            return createErrorReply("ERR value is not a valid float");
+        }
+    }
 
-        auto expiry = std::chrono::system_clock::now() + std::chrono::seconds(seconds);
-        strDb[key] = {val, expiry};
+    long double result = current + delta;
+    if (!std::isfinite(result))
+    {
+        return createErrorReply("ERR increment would produce NaN or Infinity");
+    }
 
-        return createOkStatusReply();
+    // Fixed notation with 17 decimals and the trailing zeros cut, as Redis formats it: 10.5 + 0.1 is "10.6"
+    char text[5 * 1024];
+    int len = std::snprintf(text, sizeof(text), "%.17Lf", result);
+    if (len <= 0 || static_cast<size_t>(len) >= sizeof(text))
+    {
+        return createErrorReply("ERR increment would produce NaN or Infinity");
     }
-};
+    std::string_view formatted(text, static_cast<size_t>(len));
+    formatted = formatted.substr(0, formatted.find_last_not_of('0') + 1);
+    if (formatted.back() == '.') formatted.remove_suffix(1);
+
+    if (value == nullptr)
+    {
+        keyspace().store(key, StringValue(formatted));
+    }
+    else
+    {
+        value->assign(formatted); // keeps the TTL
+    }
+    return createStringReply(formatted);
+}
 
 // -------------------
-// TTL Command
+// Append Command
 // -------------------
 
-struct TTLCmd: AutoRegister<TTLCmd>
+CommandResult AppendCmd::call(std::string_view key, std::string_view value)
 {
-    static constexpr const char* tag = "TTL";
-    static constexpr const char* format = "TTL %s"; // single string argument
-    using ArgTypes = std::tuple<std::string>;
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
 
-    static CommandResult call(const std::string& key)
+    auto [str, wrongType] = keyspace().findOrCreate<StringValue>(key);
+    if (wrongType)
     {
-        if (!isAuth)
-        {
-            return createAuthErrorReply();
-        }
+        return createWrongTypeReply();
+    }
 
-        if (!strDb.contains(key))
-        {
-            return createIntegerReply(-2); // Key not found
-        }
+    str->append(value);
+    return createIntegerReply(static_cast<long long>(str->size()));
+}
+
+// -------------------
+// StrLen Command
+// -------------------
 
-        auto& [value, expiry] = strDb.at(key);
+redis::Reply StrLenCmd::call(std::string_view key)
+{
+    if (!isAuth)
+    {
+        return redis::noAuth();
+    }
 
-        if (expiry == std::chrono::time_point<std::chrono::system_clock>::max())
-        {
-            return createIntegerReply(-1); // No expiration
-        }
+    auto [value, wrongType] = keyspace().find<StringValue>(key);
+    if (wrongType)
+    {
+        return redis::wrongType();
+    }
 
-        auto now = std::chrono::system_clock::now();
-        auto remaining = std::chrono::duration_cast<std::chrono::seconds>(expiry - now).count();
+    return redis::integer(value != nullptr ? static_cast<long long>(value->size()) : 0);
+}
 
-        if (remaining <= 0)
-        {
-            strDb.erase(key);              // Clean up expired key
-            return createIntegerReply(-2); // Expired = not found
-        }
+// -------------------
+// GetSet Command
+// -------------------
+
+CommandResult GetSetCmd::call(std::string_view key, std::string_view value)
+{
+    if (!isAuth)
+    {
+        return createAuthErrorReply();
+    }
 
-        return createIntegerReply(static_cast<int>(remaining));
+    auto [old, wrongType] = keyspace().find<StringValue>(key);
+    if (wrongType)
+    {
+        return createWrongTypeReply();
     }
-};
+
+    // The reply copies the old value before SET semantics replace it and drop any TTL
+    Digits digits;
+    redisReply* reply = old != nullptr ? createStringReply(old->view(digits)) : createNilReply();
+    keyspace().setString(key, value);
+    return reply;
+}
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// String commands (mock_redis_string.cpp)
+// -------------------
+
+struct SetBinaryCmd
+{
+    static constexpr const char* tag = "SETB";                 // distinguish from regular SET
+    static constexpr const char* format = "SET %s %b";         // format string
+    using ArgTypes = std::tuple<std::string_view, BinaryView>; // tuple of expected argument types
+
+    static CommandResult call(std::string_view key, BinaryView binVal);
+};
+
+struct SetExBinaryCmd
+{
+    static constexpr const char* tag = "SETEXB";
+    static constexpr const char* format = "SETEX %s %d %b"; // key, seconds, binary
+    using ArgTypes = std::tuple<std::string_view, int, BinaryView>;
+
+    static CommandResult call(std::string_view key, int seconds, BinaryView binVal);
+};
+
+struct GetCmd
+{
+    static constexpr const char* tag = "GET";
+    static constexpr const char* format = "GET %s"; // %s for key
+    using ArgTypes = std::tuple<std::string_view>;  // key
+
+    template <typename Form> static auto emit(std::string_view key) -> typename Form::Result;
+    static CommandResult call(std::string_view key);
+};
+
+struct SetCmd
+{
+    static constexpr const char* tag = "SET";
+    static constexpr const char* format = "SET %s %s";
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view val);
+};
+
+struct SetExCmd
+{
+    static constexpr const char* tag = "SETEX";
+    static constexpr const char* format = "SETEX %s %d %s"; // key, seconds, value
+    using ArgTypes = std::tuple<std::string_view, int, std::string_view>;
+
+    static CommandResult call(std::string_view key, int seconds, std::string_view val);
+};
+
+// MSET key value [key value ...]
+struct MSetCmd
+{
+    static constexpr const char* tag = "MSET";
+    static constexpr const char* format = "MSET %s %s"; // key/value pairs
+    using ArgTypes = std::tuple<ArgPack>;
+
+    static CommandResult call(ArgPack pairs);
+};
+
+// MGET key [key ...]: every key in one dispatch and one reply allocation
+struct MGetCmd
+{
+    static constexpr const char* tag = "MGET";
+    static constexpr const char* format = "MGET %s"; // keys
+    using ArgTypes = std::tuple<ArgPack>;
+
+    template <typename Form> static auto emit(ArgPack keys) -> typename Form::Result;
+    static CommandResult call(ArgPack keys);
+};
+
+// -------------------
+// Counters: the value is stored as a 64-bit integer (StringValue, collections.h)
+// -------------------
+
+struct IncrCmd
+{
+    static constexpr const char* tag = "INCR";
+    static constexpr const char* format = "INCR %s"; // key
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+struct DecrCmd
+{
+    static constexpr const char* tag = "DECR";
+    static constexpr const char* format = "DECR %s"; // key
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static CommandResult call(std::string_view key);
+};
+
+// The increment is read as text so it can span 64 bits; "INCRBY %s %d" calls are parsed into argv
+struct IncrByCmd
+{
+    static constexpr const char* tag = "INCRBY";
+    static constexpr const char* format = "INCRBY %s %s"; // key, increment
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view increment);
+};
+
+struct DecrByCmd
+{
+    static constexpr const char* tag = "DECRBY";
+    static constexpr const char* format = "DECRBY %s %s"; // key, decrement
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view decrement);
+};
+
+struct IncrByFloatCmd
+{
+    static constexpr const char* tag = "INCRBYFLOAT";
+    static constexpr const char* format = "INCRBYFLOAT %s %s"; // key, increment
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view increment);
+};
+
+struct AppendCmd
+{
+    static constexpr const char* tag = "APPEND";
+    static constexpr const char* format = "APPEND %s %s"; // key, value
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view value);
+};
+
+struct StrLenCmd
+{
+    static constexpr const char* tag = "STRLEN";
+    static constexpr const char* format = "STRLEN %s"; // key
+    using ArgTypes = std::tuple<std::string_view>;
+
+    static redis::Reply call(std::string_view key);
+};
+
+struct GetSetCmd
+{
+    static constexpr const char* tag = "GETSET";
+    static constexpr const char* format = "GETSET %s %s"; // key, value
+    using ArgTypes = std::tuple<std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view value);
+};
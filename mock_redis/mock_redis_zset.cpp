@@ -0,0 +1,327 @@
+#include "mock_redis_zset.h"
+#include "command_table.h"
+#include "keyspace.h"
+#include "reply_pool.h"
+#include "scan.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace
+{
+// A score as Redis reads one: a decimal, or inf/+inf/-inf in any case.  NaN is refused.
+auto parseScore(std::string_view s, double& score) -> bool
+{
+    if (equalsIgnoreCase(s, "inf") || equalsIgnoreCase(s, "+inf") || equalsIgnoreCase(s, "-inf"))
+    {
+        score = s.front() == '-' ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+        return true;
+    }
+    if (!s.empty() && s.front() == '+') s.remove_prefix(1);
+
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), score);
+    return ec == std::errc() && end == s.data() + s.size() && !s.empty() && !std::isnan(score);
+}
+
+// One end of a ZRANGEBYSCORE interval: "1.5" includes 1.5, "(1.5" excludes it
+struct ScoreBound
+{
+    double value = 0;
+    bool exclusive = false;
+};
+
+auto parseBound(std::string_view s, ScoreBound& bound) -> bool
+{
+    bound.exclusive = !s.empty() && s.front() == '(';
+    if (bound.exclusive) s.remove_prefix(1);
+    return parseScore(s, bound.value);
+}
+
+auto parseCount(std::string_view s, long long& value) -> bool
+{
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && end == s.data() + s.size();
+}
+
+// Shortest text that reads back as the same double, as Redis replies with it
+auto formatScore(char (&digits)[32], double score) -> std::string_view
+{
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), score);
+    return {digits, static_cast<size_t>(end - digits)};
+}
+
+// The members at ranks [first, last], each followed by its score if withScores, in one reply block
+auto rangeReply(const ZSetValue& zset, size_t first, size_t last, bool withScores) -> redisReply*
+{
+    char digits[32];
+    ArrayReplyBuilder builder;
+    zset.forRange(first, last,
+                  [&](std::string_view member, double score)
+                  {
+                      builder.measure(member.size());
+                      if (withScores) builder.measure(formatScore(digits, score).size());
+                  });
+    builder.start();
+    zset.forRange(first, last,
+                  [&](std::string_view member, double score)
+                  {
+                      builder.append(member);
+                      if (withScores) builder.append(formatScore(digits, score));
+                  });
+    return builder.finish();
+}
+
+auto rangeByRank(std::string_view key, int start, int stop, bool withScores) -> CommandResult
+{
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (zset == nullptr) return createArrayReply(0);
+
+    int len = static_cast<int>(zset->size());
+
+    // Normalize negative indices, as LRANGE does
+    if (start < 0) start = len + start;
+    if (stop < 0) stop = len + stop;
+
+    if (start < 0) start = 0;
+    if (stop >= len) stop = len - 1;
+
+    if (start > stop || start >= len) return createArrayReply(0);
+
+    return rangeReply(*zset, static_cast<size_t>(start), static_cast<size_t>(stop), withScores);
+}
+
+// Members scoring within [min, max], skipping `offset` of them and returning at most `count` (all if negative)
+auto rangeByScore(std::string_view key, std::string_view min, std::string_view max, bool withScores,
+                  long long offset, long long count) -> CommandResult
+{
+    ScoreBound low;
+    ScoreBound high;
+    if (!parseBound(min, low) || !parseBound(max, high)) return createErrorReply("ERR min or max is not a float");
+
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (zset == nullptr || offset < 0) return createArrayReply(0);
+
+    // Both ends are found by rank, so the scan touches only the members it returns
+    size_t first = zset->lowerBound(low.value, low.exclusive);
+    size_t end = zset->lowerBound(high.value, !high.exclusive);
+    first += static_cast<size_t>(std::min<long long>(offset, static_cast<long long>(zset->size())));
+    if (count >= 0) end = std::min(end, first + static_cast<size_t>(count));
+    if (first >= end) return createArrayReply(0);
+
+    return rangeReply(*zset, first, end - 1, withScores);
+}
+} // namespace
+
+// ---------
+//  ZADD CMD
+// ---------
+CommandResult ZAddCmd::call(std::string_view key, ArgPack pairs)
+{
+    if (!isAuth) return createAuthErrorReply();
+    if (pairs.size() % 2 != 0) return createErrorReply("ERR syntax error");
+
+    // Every score is checked before anything is stored, so a bad one leaves the set untouched
+    thread_local std::vector<double> scores;
+    scores.resize(pairs.size() / 2);
+    for (size_t i = 0; i < scores.size(); ++i)
+    {
+        if (!parseScore(pairs[2 * i], scores[i])) return createErrorReply("ERR value is not a valid float");
+    }
+
+    auto [zset, wrongType] = keyspace().findOrCreate<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+
+    int added = 0;
+    for (size_t i = 0; i < scores.size(); ++i)
+    {
+        added += zset->add(pairs[2 * i + 1], scores[i]) ? 1 : 0;
+    }
+    return createIntegerReply(added);
+}
+
+// ---------
+//  ZINCRBY CMD
+// ---------
+CommandResult ZIncrByCmd::call(std::string_view key, std::string_view increment, std::string_view member)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    double delta = 0;
+    if (!parseScore(increment, delta)) return createErrorReply("ERR value is not a valid float");
+
+    auto [zset, wrongType] = keyspace().findOrCreate<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+
+    double score = zset->score(member).value_or(0) + delta;
+    if (std::isnan(score))
+    {
+        if (zset->empty()) keyspace().erase(key);
+        return createErrorReply("ERR resulting score is not a number (NaN)");
+    }
+    zset->add(member, score);
+
+    char digits[32];
+    return createStringReply(formatScore(digits, score));
+}
+
+// ---------
+//  ZREM CMD
+// ---------
+CommandResult ZRemCmd::call(std::string_view key, ArgPack members)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (zset == nullptr) return createIntegerReply(0);
+
+    int removed = 0;
+    for (size_t i = 0; i < members.size(); ++i)
+    {
+        removed += zset->remove(members[i]) ? 1 : 0;
+    }
+    if (zset->empty()) keyspace().erase(key);
+
+    return createIntegerReply(removed);
+}
+
+// ---------
+//  ZSCORE CMD
+// ---------
+CommandResult ZScoreCmd::call(std::string_view key, std::string_view member)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+
+    auto score = zset != nullptr ? zset->score(member) : std::nullopt;
+    if (!score) return createNilReply();
+
+    char digits[32];
+    return createStringReply(formatScore(digits, *score));
+}
+
+// ---------
+//  ZCARD CMD
+// ---------
+CommandResult ZCardCmd::call(std::string_view key)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+    if (zset == nullptr) return createIntegerReply(0);
+
+    return createIntegerReply(static_cast<long long>(zset->size()));
+}
+
+// ---------
+//  ZRANK CMD
+// ---------
+CommandResult ZRankCmd::call(std::string_view key, std::string_view member)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+
+    auto rank = zset != nullptr ? zset->rank(member) : std::nullopt;
+    if (!rank) return createNilReply();
+
+    return createIntegerReply(static_cast<long long>(*rank));
+}
+
+// ---------
+//  ZRANGE CMD
+// ---------
+CommandResult ZRangeCmd::call(std::string_view key, int start, int stop)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    return rangeByRank(key, start, stop, false);
+}
+
+CommandResult ZRangeOptsCmd::call(std::string_view key, int start, int stop, ArgPack options)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    for (size_t i = 0; i < options.size(); ++i)
+    {
+        if (!equalsIgnoreCase(options[i], "WITHSCORES")) return createErrorReply("ERR syntax error");
+    }
+    return rangeByRank(key, start, stop, true);
+}
+
+// ---------
+//  ZRANGEBYSCORE CMD
+// ---------
+CommandResult ZRangeByScoreCmd::call(std::string_view key, std::string_view min, std::string_view max)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    return rangeByScore(key, min, max, false, 0, -1);
+}
+
+CommandResult ZRangeByScoreOptsCmd::call(std::string_view key, std::string_view min, std::string_view max,
+                                         ArgPack options)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    bool withScores = false;
+    long long offset = 0;
+    long long count = -1;
+    for (size_t i = 0; i < options.size(); ++i)
+    {
+        if (equalsIgnoreCase(options[i], "WITHSCORES"))
+        {
+            withScores = true;
+        }
+        else if (equalsIgnoreCase(options[i], "LIMIT") && i + 2 < options.size())
+        {
+            if (!parseCount(options[i + 1], offset) || !parseCount(options[i + 2], count))
+            {
+                return createErrorReply(argvIntegerError);
+            }
+            i += 2;
+        }
+        else
+        {
+            return createErrorReply("ERR syntax error");
+        }
+    }
+    return rangeByScore(key, min, max, withScores, offset, count);
+}
+
+// ---------
+//  ZSCAN CMD
+// ---------
+CommandResult ZScanCmd::call(std::string_view key, ArgPack args)
+{
+    if (!isAuth) return createAuthErrorReply();
+
+    ScanArgs scan;
+    if (const char* error = parseScanArgs(args, false, scan)) return createErrorReply(error);
+
+    auto [zset, wrongType] = keyspace().find<ZSetValue>(key);
+    if (wrongType) return createWrongTypeReply();
+
+    ScanBatch& batch = scanBatch();
+    batch.clear();
+    if (zset == nullptr) return scanReply(0, batch);
+
+    char digits[32];
+    auto visit = [&](std::string_view member, double score)
+    {
+        if (!scan.pattern.empty() && !globMatch(scan.pattern, member)) return;
+        batch.add(member);
+        batch.add(formatScore(digits, score));
+    };
+    uint64_t cursor = scanSteps(scan, batch, 2, [&](uint64_t at) { return zset->scan(at, visit); });
+    return scanReply(cursor, batch);
+}
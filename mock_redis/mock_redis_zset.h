@@ -0,0 +1,106 @@
+#pragma once
+
+#include "mock_redis.h"
+
+// -------------------
+// Sorted set commands (mock_redis_zset.cpp)
+// -------------------
+
+struct ZAddCmd
+{
+    static constexpr const char* tag = "ZADD";
+    static constexpr const char* format = "ZADD %s %s %s"; // key, score member [score member ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack pairs);
+};
+
+struct ZIncrByCmd
+{
+    static constexpr const char* tag = "ZINCRBY";
+    static constexpr const char* format = "ZINCRBY %s %s %s"; // key, increment, member
+    using ArgTypes = std::tuple<std::string_view, std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view increment, std::string_view member);
+};
+
+struct ZRemCmd
+{
+    static constexpr const char* tag = "ZREM";
+    static constexpr const char* format = "ZREM %s %s"; // key, member [member ...]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack members);
+};
+
+struct ZScoreCmd
+{
+    static constexpr const char* tag = "ZSCORE";
+    static constexpr const char* format = "ZSCORE %s %s";
+    using ArgTypes = std::tuple<std::string_view, std::string_view>; // key, member
+
+    static CommandResult call(std::string_view key, std::string_view member);
+};
+
+struct ZCardCmd
+{
+    static constexpr const char* tag = "ZCARD";
+    static constexpr const char* format = "ZCARD %s";
+    using ArgTypes = std::tuple<std::string_view>; // key
+
+    static CommandResult call(std::string_view key);
+};
+
+struct ZRankCmd
+{
+    static constexpr const char* tag = "ZRANK";
+    static constexpr const char* format = "ZRANK %s %s";
+    using ArgTypes = std::tuple<std::string_view, std::string_view>; // key, member
+
+    static CommandResult call(std::string_view key, std::string_view member);
+};
+
+struct ZRangeCmd
+{
+    static constexpr const char* tag = "ZRANGE";
+    static constexpr const char* format = "ZRANGE %s %d %d";
+    using ArgTypes = std::tuple<std::string_view, int, int>; // key, start, stop
+
+    static CommandResult call(std::string_view key, int start, int stop);
+};
+
+struct ZRangeOptsCmd
+{
+    static constexpr const char* tag = "ZRANGE";
+    static constexpr const char* format = "ZRANGE %s %d %d %s"; // key, start, stop, WITHSCORES
+    using ArgTypes = std::tuple<std::string_view, int, int, ArgPack>;
+
+    static CommandResult call(std::string_view key, int start, int stop, ArgPack options);
+};
+
+struct ZRangeByScoreCmd
+{
+    static constexpr const char* tag = "ZRANGEBYSCORE";
+    static constexpr const char* format = "ZRANGEBYSCORE %s %s %s"; // key, min, max: "(1.5", "-inf", ...
+    using ArgTypes = std::tuple<std::string_view, std::string_view, std::string_view>;
+
+    static CommandResult call(std::string_view key, std::string_view min, std::string_view max);
+};
+
+struct ZRangeByScoreOptsCmd
+{
+    static constexpr const char* tag = "ZRANGEBYSCORE";
+    static constexpr const char* format = "ZRANGEBYSCORE %s %s %s %s"; // ..., [WITHSCORES] [LIMIT offset count]
+    using ArgTypes = std::tuple<std::string_view, std::string_view, std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, std::string_view min, std::string_view max, ArgPack options);
+};
+
+struct ZScanCmd
+{
+    static constexpr const char* tag = "ZSCAN";
+    static constexpr const char* format = "ZSCAN %s %s"; // key, cursor [MATCH pattern] [COUNT count]
+    using ArgTypes = std::tuple<std::string_view, ArgPack>;
+
+    static CommandResult call(std::string_view key, ArgPack args);
+};
@@ -0,0 +1,83 @@
+#include "pipeline.h"
+
+#include <cstring>
+
+void CommandPipeline::pushArg(std::string_view bytes)
+{
+    args.push_back(Slice{buffer.size(), bytes.size()});
+    buffer.append(bytes);
+}
+
+void CommandPipeline::append(const char* format, va_list ap)
+{
+    const CommandInfo* info = CommandRegistry::find(format);
+    QueuedCommand cmd{info, static_cast<uint32_t>(args.size()), 0};
+
+    if (info == nullptr)
+    {
+        // Not registered verbatim (a variadic arity, ...): queue it by name, as for argv
+        FormatArgv& parsed = formatArgvScratch();
+        parsed.assign(format, ap, true);
+        appendArgv(static_cast<int>(parsed.size()), parsed.argv.data(), parsed.argvlen.data());
+        return;
+    }
+
+    forEachVaArg(format, ap, [this](std::string_view bytes) { pushArg(bytes); });
+
+    cmd.argc = static_cast<uint32_t>(args.size()) - cmd.firstArg;
+    commands.push_back(cmd);
+}
+
+void CommandPipeline::appendArgv(int argc, const char** argv, const size_t* argvlen)
+{
+    auto arg = [&](int i) { return std::string_view(argv[i], argvlen != nullptr ? argvlen[i] : strlen(argv[i])); };
+
+    const CommandInfo* info = CommandRegistry::findArgv(arg(0), static_cast<size_t>(argc - 1));
+    QueuedCommand cmd{info, static_cast<uint32_t>(args.size()), 0};
+
+    if (info == nullptr)
+    {
+        pushArg(arg(0));
+        commands.push_back(cmd);
+        return;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        pushArg(arg(i));
+    }
+    cmd.argc = static_cast<uint32_t>(argc - 1);
+    commands.push_back(cmd);
+}
+
+auto CommandPipeline::run(const QueuedCommand& cmd) -> redisReply*
+{
+    if (cmd.info == nullptr)
+    {
+        std::string msg = CommandRegistry::lookupError(std::string_view(argPtrs[cmd.firstArg], argLens[cmd.firstArg]));
+        return createErrorReply(msg.c_str());
+    }
+
+    return dispatchCommand(*cmd.info, argPtrs.data() + cmd.firstArg, argLens.data() + cmd.firstArg, cmd.argc);
+}
+
+void CommandPipeline::execute(std::deque<redisReply*>& replies)
+{
+    // The buffer no longer moves, so argument pointers can be resolved once
+    argPtrs.resize(args.size());
+    argLens.resize(args.size());
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        argPtrs[i] = buffer.data() + args[i].offset;
+        argLens[i] = args[i].len;
+    }
+
+    for (const QueuedCommand& cmd : commands)
+    {
+        replies.push_back(run(cmd));
+    }
+
+    commands.clear();
+    args.clear();
+    buffer.clear();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "hiredis/hiredis.h"
+#include "mock_redis.h"
+
+/*
+ * Command pipelining
+ * ------------------
+ *
+ * Backs redisAppendCommand / redisAppendCommandArgv / redisGetReply in the
+ * hiredis shim.  Appending a command captures its arguments into one shared
+ * byte buffer (the caller's va_list and argv memory are gone by the time the
+ * batch runs), so queuing costs no allocation once the buffers have grown.
+ *
+ * `execute` runs the whole batch in one pass, in append order: every type
+ * shares one keyspace (keyspace.h), so a SET followed by an LPUSH on the same
+ * key must see each other.  Replies are handed back in append order.
+ */
+class CommandPipeline
+{
+  public:
+    // Queue a format-string command, e.g. ("SET %s %s", key, value)
+    void append(const char* format, va_list ap);
+
+    // Queue an argv command; argv[0] is the command name
+    void appendArgv(int argc, const char** argv, const size_t* argvlen);
+
+    // Run every queued command and push the replies, in append order, onto `replies`
+    void execute(std::deque<redisReply*>& replies);
+
+    [[nodiscard]] auto empty() const -> bool { return commands.empty(); }
+    [[nodiscard]] auto size() const -> size_t { return commands.size(); }
+
+  private:
+    struct Slice
+    {
+        size_t offset;
+        size_t len;
+    };
+
+    struct QueuedCommand
+    {
+        const CommandInfo* info; // nullptr for an unknown command
+        uint32_t firstArg;       // index into args
+        uint32_t argc;           // for an unknown command, args[firstArg] holds its name
+    };
+
+    void pushArg(std::string_view bytes);
+    auto run(const QueuedCommand& cmd) -> redisReply*;
+
+    std::vector<QueuedCommand> commands;
+    std::vector<Slice> args;
+    std::string buffer;
+
+    // Scratch reused across batches
+    std::vector<const char*> argPtrs;
+    std::vector<size_t> argLens;
+};
@@ -0,0 +1,297 @@
+#include "quicklist.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+namespace
+{
+// -------------------
+// LZF
+// -------------------
+//
+// The byte format of liblzf, which Redis uses for the same job:
+//
+//     000LLLLL <L+1 literal bytes>
+//     LLLooooo oooooooo            back reference, length L+2 (L < 7), offset o+1
+//     111ooooo LLLLLLLL oooooooo   back reference, length L+9
+//
+// The compressor finds matches through a hash of the next three bytes, keeping only the latest position per hash.
+
+constexpr size_t lzfHashBits = 13;
+constexpr size_t lzfMaxLiteral = 32;
+constexpr size_t lzfMaxOffset = 1 << 13;
+constexpr size_t lzfMaxMatch = 264; // 255 + 9
+
+auto lzfHash(const unsigned char* p) -> size_t
+{
+    uint32_t v = (uint32_t{p[0]} << 16) | (uint32_t{p[1]} << 8) | p[2];
+    return (v * 2654435761u) >> (32 - lzfHashBits);
+}
+
+void lzfLiterals(std::string& out, const char* from, size_t len)
+{
+    while (len > 0)
+    {
+        size_t run = std::min(len, lzfMaxLiteral);
+        out.push_back(static_cast<char>(run - 1));
+        out.append(from, run);
+        from += run;
+        len -= run;
+    }
+}
+
+// False when the output would not be smaller than the input
+auto lzfCompress(std::string_view in, std::string& out) -> bool
+{
+    const auto* src = reinterpret_cast<const unsigned char*>(in.data());
+    size_t n = in.size();
+    std::array<uint32_t, size_t{1} << lzfHashBits> latest{}; // position + 1, 0 for none
+
+    out.clear();
+    out.reserve(n);
+    size_t literalStart = 0;
+    size_t i = 0;
+    while (i + 2 < n)
+    {
+        size_t h = lzfHash(src + i);
+        size_t candidate = latest[h];
+        latest[h] = static_cast<uint32_t>(i + 1);
+
+        if (candidate == 0 || i - (candidate - 1) > lzfMaxOffset || std::memcmp(src + candidate - 1, src + i, 3) != 0)
+        {
+            ++i;
+            continue;
+        }
+
+        size_t ref = candidate - 1;
+        size_t maxLen = std::min(n - i, lzfMaxMatch);
+        size_t len = 3;
+        while (len < maxLen && src[ref + len] == src[i + len])
+        {
+            ++len;
+        }
+
+        lzfLiterals(out, in.data() + literalStart, i - literalStart);
+        size_t offset = i - ref - 1;
+        size_t code = len - 2;
+        if (code < 7)
+        {
+            out.push_back(static_cast<char>((code << 5) | (offset >> 8)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>((7 << 5) | (offset >> 8)));
+            out.push_back(static_cast<char>(code - 7));
+        }
+        out.push_back(static_cast<char>(offset & 0xFF));
+
+        i += len;
+        literalStart = i;
+        if (out.size() >= n) return false;
+    }
+    lzfLiterals(out, in.data() + literalStart, n - literalStart);
+    return out.size() < n;
+}
+
+auto lzfDecompress(std::string_view in, size_t rawBytes) -> std::string
+{
+    std::string out;
+    out.reserve(rawBytes);
+    const auto* ip = reinterpret_cast<const unsigned char*>(in.data());
+    const auto* end = ip + in.size();
+    while (ip < end)
+    {
+        size_t ctrl = *ip++;
+        if (ctrl < 32)
+        {
+            out.append(reinterpret_cast<const char*>(ip), ctrl + 1);
+            ip += ctrl + 1;
+            continue;
+        }
+
+        size_t len = ctrl >> 5;
+        if (len == 7) len += *ip++;
+        size_t ref = out.size() - ((ctrl & 0x1F) << 8) - *ip++ - 1;
+        // Byte at a time: a match may overlap the bytes it produces
+        for (len += 2; len > 0; --len)
+        {
+            out.push_back(out[ref++]);
+        }
+    }
+    return out;
+}
+} // namespace
+
+Quicklist::Quicklist(size_t nodeMaxBytes, size_t compressDepth)
+    : nodeMaxBytes(nodeMaxBytes), compressDepth(compressDepth)
+{
+}
+
+Quicklist::Quicklist(Listpack first, size_t nodeMaxBytes, size_t compressDepth)
+    : count(first.size()), nodeMaxBytes(nodeMaxBytes), compressDepth(compressDepth)
+{
+    if (!first.empty())
+    {
+        Node& node = nodes.emplace_back();
+        node.count = static_cast<uint32_t>(first.size());
+        node.entries = std::move(first);
+    }
+}
+
+// -------------------
+// Ends
+// -------------------
+
+void Quicklist::pushFront(std::string_view value)
+{
+    // A node always takes at least one element, however large
+    if (nodes.empty() || nodes.front().entries.bytes() + value.size() + 2 > nodeMaxBytes)
+    {
+        nodes.emplace_front();
+        settleCompression();
+    }
+    Node& head = nodes.front();
+    head.entries.pushFront(value);
+    ++head.count;
+    ++count;
+}
+
+void Quicklist::pushBack(std::string_view value)
+{
+    if (nodes.empty() || nodes.back().entries.bytes() + value.size() + 2 > nodeMaxBytes)
+    {
+        nodes.emplace_back();
+        settleCompression();
+    }
+    Node& tail = nodes.back();
+    tail.entries.pushBack(value);
+    ++tail.count;
+    ++count;
+}
+
+auto Quicklist::front() const -> std::string_view
+{
+    const Listpack& entries = nodes.front().entries;
+    return entries.get(entries.begin());
+}
+
+auto Quicklist::back() const -> std::string_view
+{
+    const Listpack& entries = nodes.back().entries;
+    return entries.get(entries.last());
+}
+
+void Quicklist::popFront()
+{
+    Node& head = nodes.front();
+    head.entries.erase(head.entries.begin());
+    --head.count;
+    --count;
+    if (head.count == 0)
+    {
+        nodes.pop_front();
+        settleCompression();
+    }
+}
+
+void Quicklist::popBack()
+{
+    Node& tail = nodes.back();
+    tail.entries.erase(tail.entries.last());
+    --tail.count;
+    --count;
+    if (tail.count == 0)
+    {
+        nodes.pop_back();
+        settleCompression();
+    }
+}
+
+// -------------------
+// Indexed access
+// -------------------
+
+auto Quicklist::locate(size_t index) const -> std::pair<NodeIter, size_t>
+{
+    if (index < count / 2)
+    {
+        auto it = nodes.begin();
+        while (index >= it->count)
+        {
+            index -= it->count;
+            ++it;
+        }
+        return {it, index};
+    }
+
+    size_t fromBack = count - 1 - index;
+    auto it = nodes.rbegin();
+    while (fromBack >= it->count)
+    {
+        fromBack -= it->count;
+        ++it;
+    }
+    return {std::prev(it.base()), it->count - 1 - fromBack};
+}
+
+auto Quicklist::contents(const Node& node, Listpack& scratch) -> const Listpack&
+{
+    if (!node.isCompressed) return node.entries;
+    scratch = Listpack::fromRaw(lzfDecompress(node.compressed, node.rawBytes), node.count);
+    return scratch;
+}
+
+// -------------------
+// Compression
+// -------------------
+
+void Quicklist::compress(Node& node)
+{
+    std::string out;
+    if (!lzfCompress(node.entries.raw(), out)) return; // incompressible: stays raw
+
+    node.rawBytes = static_cast<uint32_t>(node.entries.bytes());
+    node.compressed = std::move(out);
+    node.entries = Listpack();
+    node.isCompressed = true;
+}
+
+void Quicklist::decompress(Node& node)
+{
+    node.entries = Listpack::fromRaw(lzfDecompress(node.compressed, node.rawBytes), node.count);
+    node.compressed = std::string();
+    node.isCompressed = false;
+}
+
+void Quicklist::settleCompression()
+{
+    if (compressDepth == 0) return;
+
+    // Only ends change, so only the nodes compressDepth - 1 and compressDepth from an end can have crossed over
+    size_t n = nodes.size();
+    auto settle = [&](Node& node, size_t index)
+    {
+        bool interior = index >= compressDepth && index + compressDepth < n;
+        if (interior && !node.isCompressed)
+        {
+            compress(node);
+        }
+        else if (!interior && node.isCompressed)
+        {
+            decompress(node);
+        }
+    };
+
+    auto head = nodes.begin();
+    for (size_t i = 0; i <= compressDepth && head != nodes.end(); ++i, ++head)
+    {
+        if (i + 1 >= compressDepth) settle(*head, i);
+    }
+    auto tail = nodes.rbegin();
+    for (size_t i = 0; i <= compressDepth && tail != nodes.rend(); ++i, ++tail)
+    {
+        if (i + 1 >= compressDepth) settle(*tail, n - 1 - i);
+    }
+}
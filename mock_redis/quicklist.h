@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "listpack.h"
+
+/*
+ * Quicklist
+ * ---------
+ *
+ * The general list encoding, after Redis's quicklist: a doubly linked list
+ * of nodes, each holding a Listpack of up to `nodeMaxBytes` bytes.
+ *
+ *   - Push and pop touch only the head or tail node, so both ends are O(1)
+ *     however long the list gets (the vector it replaces shifted every
+ *     element on LPUSH and LPOP).
+ *   - An element costs its bytes plus 2-3 bytes of listpack framing, and a
+ *     node is one allocation for hundreds of elements.
+ *   - Indexed access skips whole nodes by their entry counts, from
+ *     whichever end is nearer, and then walks inside one node.
+ *   - With a compress depth d > 0, every node more than d nodes from both
+ *     ends is kept LZF-compressed.  Job queues mostly touch their ends, so
+ *     the middle of a long list sits compressed until LRANGE reads it; a
+ *     read decompresses into scratch space and leaves the node compressed.
+ *     A node whose data does not shrink stays raw.
+ */
+class Quicklist
+{
+  public:
+    Quicklist(size_t nodeMaxBytes, size_t compressDepth);
+
+    // Take over a listpack as the first node
+    Quicklist(Listpack first, size_t nodeMaxBytes, size_t compressDepth);
+
+    [[nodiscard]] auto size() const -> size_t { return count; }
+    [[nodiscard]] auto empty() const -> bool { return count == 0; }
+    [[nodiscard]] auto nodeCount() const -> size_t { return nodes.size(); }
+
+    void pushFront(std::string_view value);
+    void pushBack(std::string_view value);
+
+    // Valid until the list is modified; the list must not be empty
+    [[nodiscard]] auto front() const -> std::string_view;
+    [[nodiscard]] auto back() const -> std::string_view;
+
+    void popFront();
+    void popBack();
+
+    // fn(element) for the elements at indices [start, stop], already clamped to the list
+    template <typename Fn> void forRange(size_t start, size_t stop, Fn&& fn) const
+    {
+        auto [node, offset] = locate(start);
+        Listpack scratch;
+        for (size_t remaining = stop - start + 1; remaining > 0; ++node, offset = 0)
+        {
+            const Listpack& entries = contents(*node, scratch);
+            for (size_t pos = entries.seek(static_cast<long long>(offset)); pos != entries.end() && remaining > 0;
+                 pos = entries.next(pos), --remaining)
+            {
+                fn(entries.get(pos));
+            }
+        }
+    }
+
+  private:
+    struct Node
+    {
+        Listpack entries;       // empty while compressed
+        std::string compressed; // LZF of the entries' buffer, while compressed
+        uint32_t count = 0;     // entries in the node, compressed or not
+        uint32_t rawBytes = 0;  // size of the buffer before compression
+        bool isCompressed = false;
+    };
+    using NodeIter = std::list<Node>::const_iterator;
+
+    // The node holding element `index`, and the element's offset inside it
+    [[nodiscard]] auto locate(size_t index) const -> std::pair<NodeIter, size_t>;
+
+    // The node's entries, decompressed into scratch if need be
+    static auto contents(const Node& node, Listpack& scratch) -> const Listpack&;
+
+    static void compress(Node& node);
+    static void decompress(Node& node);
+
+    // Re-establish "compressed iff more than compressDepth nodes from both ends" after an end changed
+    void settleCompression();
+
+    std::list<Node> nodes;
+    size_t count = 0;
+    size_t nodeMaxBytes;
+    size_t compressDepth;
+};
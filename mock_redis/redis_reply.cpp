@@ -4,22 +4,85 @@
 #include <memory>
 
 #include "hiredis/hiredis.h"
+#include "reply_pool.h"
 
 namespace
 {
 redisReply* allocRawReply()
 {
-    auto* r = static_cast<redisReply*>(std::malloc(sizeof(redisReply)));
-    if (r)
+    return allocPooledReply();
+}
+
+// The elements of an Array, Set or Push reply
+const std::vector<redis::Reply>& elementsOf(const redis::Reply& reply)
+{
+    switch (reply.type)
     {
-        std::memset(r, 0, sizeof(redisReply));
+    case redis::Type::Set: return std::get<redis::Set>(reply.value).data;
+    case redis::Type::Push: return std::get<redis::Push>(reply.value).data;
+    default: return std::get<redis::Array>(reply.value).data;
     }
-    return r;
+}
+
+// An array of bulk strings and nils (MGET, HGETALL, SMEMBERS, LRANGE, ...) is laid out in one block,
+// like the raw handlers build it, rather than node by node
+redisReply* convertFlatArray(const std::vector<redis::Reply>& items)
+{
+    for (const redis::Reply& item : items)
+    {
+        if (item.type != redis::Type::String && item.type != redis::Type::Nil) return nullptr;
+    }
+
+    ArrayReplyBuilder builder;
+    for (const redis::Reply& item : items)
+    {
+        if (item.type == redis::Type::Nil)
+        {
+            builder.measureNil();
+        }
+        else
+        {
+            builder.measure(std::get<std::string>(item.value).size());
+        }
+    }
+    builder.start();
+    for (const redis::Reply& item : items)
+    {
+        if (item.type == redis::Type::Nil)
+        {
+            builder.appendNil();
+        }
+        else
+        {
+            builder.append(std::get<std::string>(item.value));
+        }
+    }
+    return builder.finish();
 }
 
 // Internal recursive helper
 redisReply* convertToRawReply(const redis::Reply& reply)
 {
+    // Constant results map onto the shared, never-freed replies
+    if (reply.type == redis::Type::Nil)
+    {
+        return sharedReply(SharedReply::Nil);
+    }
+    if (reply.type == redis::Type::Integer)
+    {
+        if (redisReply* shared = sharedIntegerReply(std::get<long long>(reply.value)))
+        {
+            return shared;
+        }
+    }
+    if (reply.type == redis::Type::Array)
+    {
+        if (redisReply* flat = convertFlatArray(std::get<redis::Array>(reply.value).data))
+        {
+            return flat;
+        }
+    }
+
     redisReply* r = allocRawReply();
     if (!r) return nullptr;
 
@@ -34,10 +97,7 @@ redisReply* convertToRawReply(const redis::Reply& reply)
     case redis::Type::Verb:
     {
         const auto& str = std::get<std::string>(reply.value);
-        r->len = str.size();
-        r->str = static_cast<char*>(std::malloc(r->len + 1));
-        std::memcpy(r->str, str.data(), r->len);
-        r->str[r->len] = '\0';
+        assignReplyString(r, str);
 
         if (reply.type == redis::Type::Verb && reply.vtype.has_value())
         {
@@ -61,12 +121,11 @@ redisReply* convertToRawReply(const redis::Reply& reply)
     case redis::Type::Set:
     case redis::Type::Push:
     {
-        const auto& vec = std::get<redis::Array>(reply.value);
-        r->len = vec.data.size();
-        r->element = static_cast<redisReply**>(std::malloc(sizeof(redisReply*) * r->len));
-        for (size_t i = 0; i < r->len; ++i)
+        const auto& items = elementsOf(reply);
+        allocReplyElements(r, items.size());
+        for (size_t i = 0; i < r->elements; ++i)
         {
-            r->element[i] = convertToRawReply(vec.data[i]);
+            r->element[i] = convertToRawReply(items[i]);
         }
         break;
     }
@@ -74,8 +133,7 @@ redisReply* convertToRawReply(const redis::Reply& reply)
     case redis::Type::Map:
     {
         const auto& map = std::get<redis::Map>(reply.value);
-        r->len = map.data.size() * 2;
-        r->element = static_cast<redisReply**>(std::malloc(sizeof(redisReply*) * r->len));
+        allocReplyElements(r, map.data.size() * 2);
         size_t i = 0;
         for (const auto& [key, val] : map.data)
         {
@@ -89,11 +147,70 @@ redisReply* convertToRawReply(const redis::Reply& reply)
     return r;
 }
 
+redis::Array convertElements(const redisReply* r)
+{
+    redis::Array out;
+    out.data.reserve(r->elements);
+    for (size_t i = 0; i < r->elements; ++i)
+    {
+        out.data.push_back(redis::FromRedisReply(r->element[i]));
+    }
+    return out;
+}
+
 } // namespace
 
 namespace redis
 {
 
+UniqueRedisReply ToRedisReply(const Reply& reply)
+{
+    return UniqueRedisReply(convertToRawReply(reply));
+}
+
+Reply FromRedisReply(const redisReply* r)
+{
+    if (r == nullptr)
+    {
+        return nil();
+    }
+
+    auto type = static_cast<Type>(r->type);
+    switch (type)
+    {
+    case Type::String:
+    case Type::Status:
+    case Type::Error:
+    case Type::BigNum: return Reply(type, std::string(r->str, r->len));
 
+    case Type::Verb: return Reply(type, std::string(r->str, r->len), std::string(r->vtype));
+
+    case Type::Integer: return Reply(type, r->integer);
+
+    case Type::Double: return Reply(type, r->dval);
+
+    case Type::Bool: return Reply(type, r->integer != 0);
+
+    case Type::Nil: return nil();
+
+    case Type::Array: return Reply(type, convertElements(r));
+
+    case Type::Set: return Reply(type, Set{convertElements(r).data});
+
+    case Type::Push: return Reply(type, Push{convertElements(r).data});
+
+    case Type::Map:
+    {
+        Map map;
+        for (size_t i = 0; i + 1 < r->elements; i += 2)
+        {
+            map.data.emplace(FromRedisReply(r->element[i]), FromRedisReply(r->element[i + 1]));
+        }
+        return Reply(type, std::move(map));
+    }
+    }
+
+    return error("ERR unsupported reply type");
+}
 
 } // namespace redis
@@ -12,50 +12,60 @@ template <class... Ts> overloaded(Ts...) -> overloaded<Ts...>;
 #include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <variant>
 #include <vector>
 
 #include "hiredis/hiredis.h"
 
+// Defined in mock_redis.cpp (declared again in mock_redis.h).  The deleter calls it rather than
+// freeReplyObject, which lives in mock_hiredis and would make mock_redis depend on the shim.
+void releaseRedisReply(redisReply* reply);
+
 namespace redis
 {
 
 // Forward declare Reply
 struct Reply;
 
-// Custom deleter for hiredis reply objects
+// Custom deleter for reply trees built by the mock (pooled or shared, see reply_pool.h)
 struct RedisReplyDeleter
 {
     void operator()(redisReply* reply) const
     {
         if (reply)
         {
-            freeReplyObject(reply);
+            releaseRedisReply(reply);
         }
     }
 };
 
 using UniqueRedisReply = std::unique_ptr<redisReply, RedisReplyDeleter>;
 
+// Build the hiredis-compatible tree for a reply.  Only the C API needs this;
+// in-process callers keep working with the Reply value.
 UniqueRedisReply ToRedisReply(const Reply& reply);
 
-// Enum for Redis reply types
+// The inverse: copy a hiredis tree into a Reply value (the tree is not freed)
+Reply FromRedisReply(const redisReply* reply);
+
+// Enum for Redis reply types; the values are hiredis' REDIS_REPLY_* codes
 enum class Type
 {
-    String = 1,
-    Array = 2,
-    Integer = 3,
-    Nil = 4,
-    Status = 5,
-    Error = 6,
-    Double = 7,
-    Bool = 8,
-    Map = 9,
-    Set = 10,
-    Push = 11,
-    BigNum = 12,
-    Verb = 13
+    String = REDIS_REPLY_STRING,
+    Array = REDIS_REPLY_ARRAY,
+    Integer = REDIS_REPLY_INTEGER,
+    Nil = REDIS_REPLY_NIL,
+    Status = REDIS_REPLY_STATUS,
+    Error = REDIS_REPLY_ERROR,
+    Double = REDIS_REPLY_DOUBLE,
+    Bool = REDIS_REPLY_BOOL,
+    Map = REDIS_REPLY_MAP,
+    Set = REDIS_REPLY_SET,
+    Push = REDIS_REPLY_PUSH,
+    BigNum = REDIS_REPLY_BIGNUM,
+    Verb = REDIS_REPLY_VERB
 };
 
 // Generic container holder template with a Tag type to make unique types
@@ -194,4 +204,63 @@ struct Reply
     }
 };
 
+// Shorthands for handlers that return a Reply
+inline Reply nil()
+{
+    return Reply(Type::Nil, std::monostate{});
+}
+
+inline Reply status(std::string s)
+{
+    return Reply(Type::Status, std::move(s));
+}
+
+inline Reply error(std::string s)
+{
+    return Reply(Type::Error, std::move(s));
+}
+
+inline Reply integer(long long value)
+{
+    return Reply(Type::Integer, value);
+}
+
+inline Reply bulk(std::string s)
+{
+    return Reply(Type::String, std::move(s));
+}
+
+inline Reply array(std::vector<Reply> items)
+{
+    return Reply(Type::Array, Array{std::move(items)});
+}
+
+// ArrayReplyBuilder's interface (reply_pool.h) over a Reply array, so a handler written against
+// one builds either form: measure() only counts, for the reserve in start()
+class ArrayBuilder
+{
+  public:
+    void measure(size_t /*len*/) { ++count; }
+    void measureNil() { ++count; }
+    void start() { items.reserve(count); }
+    void append(std::string_view s) { items.push_back(bulk(std::string(s))); }
+    void appendNil() { items.push_back(nil()); }
+    Reply finish() { return array(std::move(items)); }
+
+  private:
+    size_t count = 0;
+    std::vector<Reply> items;
+};
+
+// The same texts as the shared NOAUTH and WRONGTYPE raw replies (reply_pool.h)
+inline Reply noAuth()
+{
+    return error("-NOAUTH Authentication required");
+}
+
+inline Reply wrongType()
+{
+    return error("WRONGTYPE Operation against a key holding the wrong kind of value");
+}
+
 } // namespace redis
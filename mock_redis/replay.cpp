@@ -0,0 +1,148 @@
+// replay.cpp : Re-drives a command log written by startCommandRecording
+// (command_recorder.h) against the command table and reports throughput and
+// latency percentiles.
+//
+//     replay <log> [--paced] [--repeat N]
+//
+// By default commands run back to back; --paced waits for each command's
+// recorded start offset.  Replies whose type differs from the recorded one are
+// counted as divergent, which usually means the store behaves differently.
+//
+// Each command goes through dispatchCommand like a live one, so the timings
+// include the command clock, stats and the expiry cron.  Blocking pops on an
+// empty key time out at once: with one thread nothing could ever serve them.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "blocking.h"
+#include "command_recorder.h"
+#include "command_stats.h"
+#include "mock_redis.h"
+
+namespace
+{
+struct Histogram
+{
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(latencyBucketCount);
+    uint64_t count = 0;
+    uint64_t maxNanos = 0;
+
+    void add(uint64_t nanos)
+    {
+        ++buckets[latencyBucketOf(nanos)];
+        ++count;
+        maxNanos = nanos > maxNanos ? nanos : maxNanos;
+    }
+
+    [[nodiscard]] auto percentile(double fraction) const -> uint64_t
+    {
+        auto target = static_cast<uint64_t>(fraction * static_cast<double>(count));
+        uint64_t seen = 0;
+        for (size_t b = 0; b < buckets.size(); ++b)
+        {
+            seen += buckets[b];
+            if (seen > 0 && seen >= target) return latencyBucketFloor(b);
+        }
+        return 0;
+    }
+};
+
+void printLine(const char* name, const Histogram& h)
+{
+    std::printf("%-24s %10llu %10llu %10llu %10llu %10llu %12llu\n", name, static_cast<unsigned long long>(h.count),
+                static_cast<unsigned long long>(h.percentile(0.50)), static_cast<unsigned long long>(h.percentile(0.90)),
+                static_cast<unsigned long long>(h.percentile(0.99)),
+                static_cast<unsigned long long>(h.percentile(0.999)), static_cast<unsigned long long>(h.maxNanos));
+}
+} // namespace
+
+auto main(int argc, char** argv) -> int
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: replay <log> [--paced] [--repeat N]\n";
+        return 2;
+    }
+
+    bool paced = false;
+    int repeat = 1;
+    for (int i = 2; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--paced") == 0)
+        {
+            paced = true;
+        }
+        else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeat = std::atoi(argv[++i]);
+        }
+    }
+
+    auto log = loadCommandLog(argv[1]);
+    if (!log)
+    {
+        std::cerr << "replay: cannot read command log " << argv[1] << "\n";
+        return 1;
+    }
+
+    blockedClients().setNeverBlock(true);
+
+    Histogram overall;
+    std::vector<Histogram> perFormat(log->formats.size());
+    uint64_t divergent = 0;
+    uint64_t skipped = 0;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < repeat; ++round)
+    {
+        auto roundStart = std::chrono::steady_clock::now();
+        for (const LoggedCommand& cmd : log->commands)
+        {
+            if (cmd.info == nullptr)
+            {
+                ++skipped;
+                continue;
+            }
+
+            if (paced)
+            {
+                std::this_thread::sleep_until(roundStart + std::chrono::nanoseconds(cmd.nanos));
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            redisReply* reply = dispatchCommand(*cmd.info, log->argPtrs.data() + cmd.firstArg,
+                                                log->argLens.data() + cmd.firstArg, cmd.argc);
+            auto nanos = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start)
+                    .count());
+
+            divergent += reply->type != cmd.replyType ? 1 : 0;
+            releaseRedisReply(reply);
+
+            overall.add(nanos);
+            perFormat[cmd.format].add(nanos);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::printf("replayed %llu commands in %.3f s (%s): %.0f ops/s, %llu divergent replies, %llu skipped\n",
+                static_cast<unsigned long long>(overall.count), seconds, paced ? "paced" : "flat out",
+                static_cast<double>(overall.count) / seconds, static_cast<unsigned long long>(divergent),
+                static_cast<unsigned long long>(skipped));
+    std::printf("\n%-24s %10s %10s %10s %10s %10s %12s\n", "latency (ns)", "calls", "p50", "p90", "p99", "p99.9",
+                "max");
+    printLine("all", overall);
+    for (size_t i = 0; i < perFormat.size(); ++i)
+    {
+        if (perFormat[i].count != 0) printLine(log->formats[i].c_str(), perFormat[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,391 @@
+#include "reply_pool.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace
+{
+constexpr size_t nodesPerSlab = 256;
+constexpr size_t chunkBytes = 64 * 1024;
+constexpr size_t dedicatedThreshold = chunkBytes / 4; // larger requests get their own chunk
+
+// A run of arena memory.  `live` counts the strings/arrays carved from it,
+// plus one while it is some thread's current chunk; the release that drops
+// it to zero recycles the chunk.
+struct ArenaChunk
+{
+    std::atomic<uint32_t> live;
+    size_t capacity;
+    size_t used;
+
+    auto data() -> char* { return reinterpret_cast<char*>(this + 1); }
+};
+
+struct ReplyNode
+{
+    redisReply reply;  // must stay first: callers only ever see &reply
+    ArenaChunk* chunk; // backs reply.str or reply.element, nullptr if unused or inline
+    bool block;        // elements live inside `chunk` (ArrayReplyBuilder), not in nodes
+    char inlineStr[128 - sizeof(redisReply) - sizeof(ArenaChunk*) - sizeof(bool)];
+};
+static_assert(sizeof(ReplyNode) == 128, "ReplyNode should fill exactly two cache lines");
+
+// Overlays a node sitting on a free list
+struct FreeNode
+{
+    FreeNode* next;
+};
+
+auto newChunk(size_t capacity) -> ArenaChunk*
+{
+    void* mem = ::operator new(sizeof(ArenaChunk) + capacity);
+    return new (mem) ArenaChunk{{0}, capacity, 0};
+}
+
+// Slabs are never freed: a node may be released on another thread long after
+// the thread that carved it has exited.  Keeping them listed here also keeps
+// them reachable for leak checkers.
+auto allocSlab() -> ReplyNode*
+{
+    static std::mutex mutex;
+    static auto* slabs = new std::vector<void*>; // never destroyed, like the slabs themselves
+
+    void* mem = ::operator new(sizeof(ReplyNode) * nodesPerSlab, std::align_val_t{64});
+    std::lock_guard lock(mutex);
+    slabs->push_back(mem);
+    return static_cast<ReplyNode*>(mem);
+}
+
+class ThreadReplyPool
+{
+  public:
+    ThreadReplyPool() = default;
+    ThreadReplyPool(const ThreadReplyPool&) = delete;
+    auto operator=(const ThreadReplyPool&) -> ThreadReplyPool& = delete;
+
+    size_t bytesAllocated = 0; // running total, never decremented
+
+    ~ThreadReplyPool()
+    {
+        if (current != nullptr) releaseChunk(current);
+        ::operator delete(spare);
+    }
+
+    auto allocNode() -> ReplyNode*
+    {
+        bytesAllocated += sizeof(ReplyNode);
+        if (freeList == nullptr)
+        {
+            ReplyNode* slab = allocSlab();
+            for (size_t i = nodesPerSlab; i-- > 0;)
+            {
+                auto* node = reinterpret_cast<FreeNode*>(&slab[i]);
+                node->next = freeList;
+                freeList = node;
+            }
+        }
+
+        FreeNode* node = freeList;
+        freeList = node->next;
+        return reinterpret_cast<ReplyNode*>(node);
+    }
+
+    // Splice a chain of released nodes back onto the free list
+    void freeNodes(FreeNode* head, FreeNode* tail)
+    {
+        tail->next = freeList;
+        freeList = head;
+    }
+
+    // Bump-allocate `size` bytes, recording the chunk that backs them
+    auto allocBytes(size_t size, ArenaChunk*& owner) -> char*
+    {
+        size = (size + 7) & ~size_t{7};
+        bytesAllocated += size;
+
+        if (size > dedicatedThreshold)
+        {
+            owner = newChunk(size);
+            owner->live.store(1, std::memory_order_relaxed);
+            owner->used = size;
+            return owner->data();
+        }
+
+        if (current == nullptr || current->used + size > current->capacity)
+        {
+            if (current != nullptr && current->live.load(std::memory_order_acquire) == 1)
+            {
+                // Everything carved from it has been released already: rewind in place
+                current->used = 0;
+            }
+            else
+            {
+                if (current != nullptr) releaseChunk(current);
+                current = takeChunk();
+            }
+        }
+
+        char* p = current->data() + current->used;
+        current->used += size;
+        current->live.fetch_add(1, std::memory_order_relaxed);
+        owner = current;
+        return p;
+    }
+
+    void releaseChunk(ArenaChunk* chunk)
+    {
+        if (chunk->live.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+        if (chunk->capacity == chunkBytes && spare == nullptr)
+        {
+            spare = chunk;
+            return;
+        }
+        ::operator delete(chunk);
+    }
+
+  private:
+    auto takeChunk() -> ArenaChunk*
+    {
+        ArenaChunk* chunk = spare != nullptr ? spare : newChunk(chunkBytes);
+        spare = nullptr;
+        chunk->used = 0;
+        chunk->live.store(1, std::memory_order_relaxed); // the arena's own reference
+        return chunk;
+    }
+
+    FreeNode* freeList = nullptr;
+    ArenaChunk* current = nullptr;
+    ArenaChunk* spare = nullptr; // one recycled standard chunk
+};
+
+thread_local ThreadReplyPool pool;
+
+// -------------------
+// Shared replies
+// -------------------
+constexpr long long sharedIntegerMin = -2; // TTL's "no key"
+constexpr long long sharedIntegerEnd = 1024;
+constexpr size_t sharedIntegerCount = sharedIntegerEnd - sharedIntegerMin;
+
+char okText[] = "+OK";
+char pongText[] = "+PONG";
+char noAuthText[] = "-NOAUTH Authentication required";
+char wrongTypeText[] = "WRONGTYPE Operation against a key holding the wrong kind of value";
+
+struct SharedReplies
+{
+    redisReply fixed[6]; // indexed by SharedReply
+    redisReply integers[sharedIntegerCount];
+};
+
+constexpr auto constantReply(int type, char* str, size_t len) -> redisReply
+{
+    redisReply r{};
+    r.type = type;
+    r.str = str;
+    r.len = len;
+    return r;
+}
+
+constexpr auto makeSharedReplies() -> SharedReplies
+{
+    SharedReplies shared{};
+    shared.fixed[static_cast<size_t>(SharedReply::Ok)] = constantReply(REDIS_REPLY_STATUS, okText, 3);
+    shared.fixed[static_cast<size_t>(SharedReply::Pong)] = constantReply(REDIS_REPLY_STRING, pongText, 5);
+    shared.fixed[static_cast<size_t>(SharedReply::Nil)] = constantReply(REDIS_REPLY_NIL, nullptr, 0);
+    shared.fixed[static_cast<size_t>(SharedReply::NoAuth)] =
+        constantReply(REDIS_REPLY_ERROR, noAuthText, sizeof(noAuthText) - 1);
+    shared.fixed[static_cast<size_t>(SharedReply::EmptyArray)] = constantReply(REDIS_REPLY_ARRAY, nullptr, 0);
+    shared.fixed[static_cast<size_t>(SharedReply::WrongType)] =
+        constantReply(REDIS_REPLY_ERROR, wrongTypeText, sizeof(wrongTypeText) - 1);
+
+    for (size_t i = 0; i < sharedIntegerCount; ++i)
+    {
+        shared.integers[i] = constantReply(REDIS_REPLY_INTEGER, nullptr, 0);
+        shared.integers[i].integer = sharedIntegerMin + static_cast<long long>(i);
+    }
+    return shared;
+}
+
+// Constant-initialized: usable from any static initializer, nothing to build at startup
+constinit SharedReplies sharedReplies = makeSharedReplies();
+
+auto nodeOf(redisReply* reply) -> ReplyNode*
+{
+    return reinterpret_cast<ReplyNode*>(reply);
+}
+
+// Releases the subtree's arena memory and threads its nodes into a chain
+void collect(redisReply* reply, FreeNode*& head, FreeNode*& tail)
+{
+    ReplyNode* node = nodeOf(reply);
+
+    if (reply->element != nullptr && !node->block)
+    {
+        for (size_t i = 0; i < reply->elements; ++i)
+        {
+            redisReply* child = reply->element[i];
+            if (child != nullptr && !isSharedReply(child)) collect(child, head, tail);
+        }
+    }
+
+    if (node->chunk != nullptr)
+    {
+        pool.releaseChunk(node->chunk);
+    }
+
+    auto* free = reinterpret_cast<FreeNode*>(node);
+    free->next = head;
+    head = free;
+    if (tail == nullptr) tail = free;
+}
+} // namespace
+
+auto allocPooledReply() -> redisReply*
+{
+    ReplyNode* node = pool.allocNode();
+    std::memset(static_cast<void*>(node), 0, offsetof(ReplyNode, inlineStr));
+    return &node->reply;
+}
+
+void assignReplyString(redisReply* reply, std::string_view s)
+{
+    ReplyNode* node = nodeOf(reply);
+
+    char* dst = nullptr;
+    if (s.size() < sizeof(node->inlineStr))
+    {
+        dst = node->inlineStr;
+    }
+    else
+    {
+        dst = pool.allocBytes(s.size() + 1, node->chunk);
+    }
+
+    std::memcpy(dst, s.data(), s.size());
+    dst[s.size()] = '\0';
+    reply->str = dst;
+    reply->len = s.size();
+}
+
+void allocReplyElements(redisReply* reply, size_t count)
+{
+    reply->elements = count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    ReplyNode* node = nodeOf(reply);
+    size_t bytes = count * sizeof(redisReply*);
+    reply->element = reinterpret_cast<redisReply**>(pool.allocBytes(bytes, node->chunk));
+    std::memset(static_cast<void*>(reply->element), 0, bytes);
+}
+
+void releaseReplyTree(redisReply* reply)
+{
+    if (reply == nullptr || isSharedReply(reply))
+    {
+        return;
+    }
+
+    FreeNode* head = nullptr;
+    FreeNode* tail = nullptr;
+    collect(reply, head, tail);
+    pool.freeNodes(head, tail);
+}
+
+void ArrayReplyBuilder::measure(size_t len)
+{
+    ++count;
+    bytes += len + 1;
+}
+
+void ArrayReplyBuilder::start()
+{
+    if (count == 0)
+    {
+        reply = sharedReply(SharedReply::EmptyArray);
+        return;
+    }
+
+    reply = allocPooledReply();
+    reply->type = REDIS_REPLY_ARRAY;
+    reply->elements = count;
+
+    // [element pointers][child replies][string bytes], one arena allocation
+    ReplyNode* node = nodeOf(reply);
+    size_t headerBytes = count * (sizeof(redisReply*) + sizeof(redisReply));
+    char* block = pool.allocBytes(headerBytes + bytes, node->chunk);
+    node->block = true;
+
+    reply->element = reinterpret_cast<redisReply**>(block);
+    children = reinterpret_cast<redisReply*>(block + count * sizeof(redisReply*));
+    cursor = block + headerBytes;
+    next = 0;
+}
+
+void ArrayReplyBuilder::append(std::string_view s)
+{
+    redisReply* child = &children[next];
+    std::memset(static_cast<void*>(child), 0, sizeof(redisReply));
+    child->type = REDIS_REPLY_STRING;
+    child->str = cursor;
+    child->len = s.size();
+
+    std::memcpy(cursor, s.data(), s.size());
+    cursor[s.size()] = '\0';
+    cursor += s.size() + 1;
+
+    reply->element[next++] = child;
+}
+
+void ArrayReplyBuilder::appendNil()
+{
+    redisReply* child = &children[next];
+    std::memset(static_cast<void*>(child), 0, sizeof(redisReply));
+    child->type = REDIS_REPLY_NIL;
+
+    reply->element[next++] = child;
+}
+
+auto ArrayReplyBuilder::finish() -> redisReply*
+{
+    return reply;
+}
+
+auto replyBytesAllocated() -> size_t
+{
+    return pool.bytesAllocated;
+}
+
+auto replyInlineCapacity() -> size_t
+{
+    return sizeof(ReplyNode::inlineStr) - 1;
+}
+
+auto sharedReply(SharedReply which) -> redisReply*
+{
+    return &sharedReplies.fixed[static_cast<size_t>(which)];
+}
+
+auto sharedIntegerReply(long long value) -> redisReply*
+{
+    if (value < sharedIntegerMin || value >= sharedIntegerEnd)
+    {
+        return nullptr;
+    }
+    return &sharedReplies.integers[value - sharedIntegerMin];
+}
+
+auto isSharedReply(const redisReply* reply) -> bool
+{
+    auto addr = reinterpret_cast<uintptr_t>(reply);
+    auto begin = reinterpret_cast<uintptr_t>(&sharedReplies);
+    return addr - begin < sizeof(SharedReplies);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+#include "hiredis/hiredis.h"
+
+/*
+ * Reply allocation
+ * ----------------
+ *
+ * Every redisReply the mock hands out comes from here instead of calloc/strdup:
+ *
+ *   - Nodes are carved from 256-node slabs and recycled through a thread-local
+ *     free list.  Each node reserves room past the hiredis struct for its
+ *     string, so short keys and values need no second allocation.
+ *   - Longer strings and element arrays are bump-allocated from a thread-local
+ *     arena of 64 KiB chunks.  A chunk counts the allocations it still backs
+ *     and is recycled as soon as the last of them is released.
+ *   - `releaseReplyTree` returns a whole tree, arrays included, to the pools
+ *     in one call.  freeReplyObject in the hiredis shim routes here, so
+ *     RedisReplyPtr and plain freeReplyObject keep working.
+ *   - `ArrayReplyBuilder` lays out a whole array of strings (pointer array,
+ *     child replies and string bytes) in a single block, freed as one.
+ *
+ * A reply may be released on a different thread than the one that built it.
+ * Slabs are never returned to the system; the pool stays at its high-water mark.
+ *
+ * Shared replies
+ * --------------
+ *
+ * Like Redis's `shared` objects, the most common constant results (+OK, +PONG,
+ * nil, the NOAUTH error, the empty array and integers in [-2, 1024)) are
+ * preallocated once and handed out to every caller.  `releaseReplyTree` skips
+ * them wherever they appear in a tree, so callers free them as usual but must
+ * never modify one.
+ */
+
+// Allocate a zeroed reply node from the calling thread's pool
+redisReply* allocPooledReply();
+
+// Copy `s` into storage owned by the reply and point str/len at it (NUL-terminated)
+void assignReplyString(redisReply* reply, std::string_view s);
+
+// Give the reply a zeroed element array of `count` entries and set `elements`
+void allocReplyElements(redisReply* reply, size_t count);
+
+// Return a reply and all of its elements to the pools
+void releaseReplyTree(redisReply* reply);
+
+// Builds an array-of-strings reply in one contiguous allocation.  Measure every
+// element first, then start() and append the same elements in order:
+//
+//     ArrayReplyBuilder builder;
+//     for (const auto& m : members) builder.measure(m.size());
+//     builder.start();
+//     for (const auto& m : members) builder.append(m);
+//     return builder.finish();
+//
+// The children are plain structs inside the block: free only the returned array.
+// A nil element (MGET of a missing key) is measureNil() and appendNil().
+class ArrayReplyBuilder
+{
+  public:
+    void measure(size_t len);
+    void measureNil() { ++count; }
+    void start();
+    void append(std::string_view s);
+    void appendNil();
+    redisReply* finish();
+
+  private:
+    size_t count = 0;
+    size_t bytes = 0;
+    size_t next = 0;
+    redisReply* reply = nullptr;
+    redisReply* children = nullptr;
+    char* cursor = nullptr;
+};
+
+// Running total of reply bytes (nodes and arena) allocated by the calling thread
+size_t replyBytesAllocated();
+
+// Bytes available for a string stored inside the node itself (excluding the NUL)
+size_t replyInlineCapacity();
+
+enum class SharedReply : unsigned char
+{
+    Ok,         // status "+OK"
+    Pong,       // string "+PONG"
+    Nil,
+    NoAuth,     // error "-NOAUTH Authentication required"
+    EmptyArray,
+    WrongType,  // error "WRONGTYPE Operation against a key holding the wrong kind of value"
+};
+
+// The preallocated reply for `which`
+redisReply* sharedReply(SharedReply which);
+
+// The preallocated integer reply for `value`, or nullptr if it is out of the shared range
+redisReply* sharedIntegerReply(long long value);
+
+// True for replies returned by sharedReply / sharedIntegerReply
+bool isSharedReply(const redisReply* reply);
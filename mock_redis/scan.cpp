@@ -0,0 +1,173 @@
+#include "scan.h"
+#include "command_table.h"
+#include "reply_pool.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace
+{
+auto parseUnsigned(std::string_view s, uint64_t& value) -> bool
+{
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && end == s.data() + s.size() && !s.empty();
+}
+
+// Match c against the class starting after '[' at pattern[i]; i is left on the closing ']'
+auto matchClass(std::string_view pattern, size_t& i, char c) -> bool
+{
+    bool negate = i < pattern.size() && pattern[i] == '^';
+    if (negate) ++i;
+
+    bool matched = false;
+    for (; i < pattern.size() && pattern[i] != ']'; ++i)
+    {
+        if (pattern[i] == '\\' && i + 1 < pattern.size())
+        {
+            matched |= pattern[++i] == c;
+        }
+        else if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']')
+        {
+            auto [low, high] = std::minmax(pattern[i], pattern[i + 2]);
+            matched |= c >= low && c <= high;
+            i += 2;
+        }
+        else
+        {
+            matched |= pattern[i] == c;
+        }
+    }
+    return matched != negate;
+}
+} // namespace
+
+auto parseScanArgs(ArgPack args, bool allowType, ScanArgs& out) -> const char*
+{
+    if (!parseUnsigned(args[0], out.cursor)) return "ERR invalid cursor";
+
+    for (size_t i = 1; i < args.size(); i += 2)
+    {
+        if (i + 1 >= args.size()) return "ERR syntax error";
+
+        std::string_view option = args[i];
+        std::string_view value = args[i + 1];
+        if (equalsIgnoreCase(option, "MATCH"))
+        {
+            out.pattern = value == "*" ? std::string_view() : value;
+        }
+        else if (equalsIgnoreCase(option, "COUNT"))
+        {
+            uint64_t count = 0;
+            if (!parseUnsigned(value, count)) return argvIntegerError;
+            if (count == 0) return "ERR syntax error";
+            out.count = static_cast<size_t>(count);
+        }
+        else if (allowType && equalsIgnoreCase(option, "TYPE"))
+        {
+            out.type = value;
+        }
+        else
+        {
+            return "ERR syntax error";
+        }
+    }
+    return nullptr;
+}
+
+auto globMatch(std::string_view pattern, std::string_view s) -> bool
+{
+    // Backtracking only ever resumes at the last '*', so this stays linear in practice
+    size_t p = 0;
+    size_t i = 0;
+    size_t starP = std::string_view::npos;
+    size_t starI = 0;
+    while (i < s.size())
+    {
+        if (p < pattern.size())
+        {
+            char c = pattern[p];
+            if (c == '*')
+            {
+                starP = p++;
+                starI = i;
+                continue;
+            }
+            if (c == '?')
+            {
+                ++p;
+                ++i;
+                continue;
+            }
+            if (c == '[')
+            {
+                size_t end = p + 1;
+                bool matched = matchClass(pattern, end, s[i]);
+                if (matched)
+                {
+                    p = end < pattern.size() ? end + 1 : end;
+                    ++i;
+                    continue;
+                }
+            }
+            else
+            {
+                if (c == '\\' && p + 1 < pattern.size()) c = pattern[++p];
+                if (c == s[i])
+                {
+                    ++p;
+                    ++i;
+                    continue;
+                }
+            }
+        }
+        if (starP == std::string_view::npos) return false;
+        p = starP + 1;
+        i = ++starI;
+    }
+
+    while (p < pattern.size() && pattern[p] == '*')
+    {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+void ScanBatch::clear()
+{
+    bytes.clear();
+    ends.clear();
+}
+
+void ScanBatch::add(std::string_view element)
+{
+    bytes.append(element);
+    ends.push_back(bytes.size());
+}
+
+auto scanBatch() -> ScanBatch&
+{
+    thread_local ScanBatch batch;
+    return batch;
+}
+
+auto scanReply(uint64_t cursor, const ScanBatch& batch) -> redisReply*
+{
+    char digits[24];
+    auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), cursor);
+
+    ArrayReplyBuilder elements;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        elements.measure(batch[i].size());
+    }
+    elements.start();
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+        elements.append(batch[i]);
+    }
+
+    redisReply* reply = createArrayReply(2);
+    reply->element[0] = createStringReply(std::string_view(digits, end - digits));
+    reply->element[1] = elements.finish();
+    return reply;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "mock_redis.h"
+
+/*
+ * SCAN family
+ * -----------
+ *
+ * SCAN, HSCAN, SSCAN and ZSCAN walk the keyspace or one collection a few
+ * elements per call, so a maintenance sweep never stalls the server or
+ * builds one huge reply the way KEYS, HGETALL or SMEMBERS do.
+ *
+ *   - The cursor is Dict::scan's (dict.h): it counts in reverse binary over
+ *     the table's home groups, so it stays valid while the table grows or
+ *     rehashes between calls.  Everything present for the whole walk is
+ *     returned at least once; an element may come back twice.
+ *   - A call visits buckets until it has COUNT elements (default 10) or has
+ *     looked at ten times that many buckets, then returns the next cursor;
+ *     "0" means the walk is complete.  MATCH and TYPE filter what was
+ *     visited, so a call may return fewer elements, even none, with a
+ *     nonzero cursor.
+ *   - A collection still in a listpack or intset (collections.h) is small
+ *     by definition and is returned whole, with cursor 0, as Redis does.
+ *
+ * The reply is [cursor, [elements]]; the inner array is built in one block
+ * (ArrayReplyBuilder).
+ */
+
+// Cursor and options of a SCAN-family command
+struct ScanArgs
+{
+    uint64_t cursor = 0;
+    std::string_view pattern; // MATCH; empty matches everything
+    size_t count = 10;        // COUNT
+    std::string_view type;    // TYPE (SCAN only); empty for any
+};
+
+// Parse "cursor [MATCH pattern] [COUNT count] [TYPE type]"; returns the error to reply with, or nullptr
+auto parseScanArgs(ArgPack args, bool allowType, ScanArgs& out) -> const char*;
+
+// Glob-style match as in Redis's MATCH and KEYS: * ? [abc] [^a] [a-z], and \ to escape
+auto globMatch(std::string_view pattern, std::string_view s) -> bool;
+
+// The elements one call returns, copied: a key scan expires keys after visiting them, and set
+// algebra (mock_redis_set.cpp) finds intset members as digits in a scratch buffer
+class ScanBatch
+{
+  public:
+    void clear();
+    void add(std::string_view element);
+
+    // Drop the elements keep() rejects, keeping the rest in order
+    template <typename Keep> void keepIf(Keep&& keep)
+    {
+        size_t kept = 0;
+        size_t written = 0;
+        size_t begin = 0;
+        for (size_t i = 0; i < ends.size(); ++i)
+        {
+            size_t end = ends[i];
+            std::string_view element(bytes.data() + begin, end - begin);
+            begin = end;
+            if (!keep(element)) continue;
+
+            // Elements only move left, so nothing unread is overwritten
+            std::char_traits<char>::move(bytes.data() + written, element.data(), element.size());
+            written += element.size();
+            ends[kept++] = written;
+        }
+        bytes.resize(written);
+        ends.resize(kept);
+    }
+
+    [[nodiscard]] auto size() const -> size_t { return ends.size(); }
+    [[nodiscard]] auto operator[](size_t i) const -> std::string_view
+    {
+        size_t begin = i == 0 ? 0 : ends[i - 1];
+        return std::string_view(bytes).substr(begin, ends[i] - begin);
+    }
+
+  private:
+    std::string bytes;
+    std::vector<size_t> ends;
+};
+
+// The calling thread's reusable batch; commands do not nest, so one is enough
+auto scanBatch() -> ScanBatch&;
+
+// Keep calling step(cursor), which visits one bucket and returns the next cursor, until `batch`
+// holds args.count entries (counted by entrySize elements each) or ten times that many buckets were
+// visited; returns the cursor to hand back
+template <typename Step> auto scanSteps(const ScanArgs& args, const ScanBatch& batch, size_t entrySize, Step&& step)
+    -> uint64_t
+{
+    uint64_t cursor = args.cursor;
+    size_t budget = args.count * 10;
+    do
+    {
+        cursor = step(cursor);
+    } while (cursor != 0 && --budget > 0 && batch.size() < args.count * entrySize);
+    return cursor;
+}
+
+// [cursor, [elements of batch]]
+auto scanReply(uint64_t cursor, const ScanBatch& batch) -> redisReply*;
@@ -0,0 +1,246 @@
+#include "score_tree.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace
+{
+auto sumOf(const std::vector<size_t>& counts, size_t n) -> size_t
+{
+    return std::accumulate(counts.begin(), counts.begin() + static_cast<std::ptrdiff_t>(n), size_t{0});
+}
+} // namespace
+
+ScoreTree::ScoreTree() : root(std::make_unique<Leaf>()) {}
+
+auto ScoreTree::entriesOf(const Node& node) -> size_t
+{
+    if (node.isLeaf) return static_cast<const Leaf&>(node).entries.size();
+    const auto& counts = static_cast<const Inner&>(node).counts;
+    return sumOf(counts, counts.size());
+}
+
+auto ScoreTree::widthOf(const Node& node) -> size_t
+{
+    if (node.isLeaf) return static_cast<const Leaf&>(node).entries.size();
+    return static_cast<const Inner&>(node).children.size();
+}
+
+auto ScoreTree::route(const Inner& inner, double score, std::string_view member) -> size_t
+{
+    // The first separator above the key, less one; keys[0] never takes part
+    auto above = std::upper_bound(inner.keys.begin() + 1, inner.keys.end(), 0,
+                                  [&](int, const Entry& key) { return less(score, member, key); });
+    return static_cast<size_t>(above - inner.keys.begin()) - 1;
+}
+
+// -------------------
+// Insert
+// -------------------
+
+void ScoreTree::insert(double score, std::string_view member)
+{
+    std::optional<Split> split = insertInto(*root, score, member);
+    ++count;
+    if (!split) return;
+
+    auto grown = std::make_unique<Inner>();
+    grown->counts = {entriesOf(*root), entriesOf(*split->node)};
+    grown->keys.push_back(Entry{});
+    grown->keys.push_back(std::move(split->key));
+    grown->children.push_back(std::move(root));
+    grown->children.push_back(std::move(split->node));
+    root = std::move(grown);
+}
+
+auto ScoreTree::insertInto(Node& node, double score, std::string_view member) -> std::optional<Split>
+{
+    if (node.isLeaf)
+    {
+        auto& leaf = static_cast<Leaf&>(node);
+        auto pos = std::upper_bound(leaf.entries.begin(), leaf.entries.end(), 0,
+                                    [&](int, const Entry& entry) { return less(score, member, entry); });
+        leaf.entries.insert(pos, Entry{score, std::string(member)});
+        if (leaf.entries.size() <= leafCapacity) return std::nullopt;
+
+        auto right = std::make_unique<Leaf>();
+        auto mid = leaf.entries.begin() + static_cast<std::ptrdiff_t>(leaf.entries.size() / 2);
+        right->entries.assign(std::make_move_iterator(mid), std::make_move_iterator(leaf.entries.end()));
+        leaf.entries.erase(mid, leaf.entries.end());
+        right->entries.reserve(leafCapacity + 1);
+
+        right->prev = &leaf;
+        right->next = leaf.next;
+        if (leaf.next != nullptr) leaf.next->prev = right.get();
+        leaf.next = right.get();
+
+        Entry key = right->entries.front();
+        return Split{std::move(key), std::move(right)};
+    }
+
+    auto& inner = static_cast<Inner&>(node);
+    size_t i = route(inner, score, member);
+    ++inner.counts[i];
+
+    std::optional<Split> split = insertInto(*inner.children[i], score, member);
+    if (!split) return std::nullopt;
+
+    auto at = [&](auto& vec, size_t index) { return vec.begin() + static_cast<std::ptrdiff_t>(index); };
+    inner.counts[i] = entriesOf(*inner.children[i]);
+    inner.counts.insert(at(inner.counts, i + 1), entriesOf(*split->node));
+    inner.keys.insert(at(inner.keys, i + 1), std::move(split->key));
+    inner.children.insert(at(inner.children, i + 1), std::move(split->node));
+    if (inner.children.size() <= innerCapacity) return std::nullopt;
+
+    // The right half's first key moves up as its separator; it stays behind as its unused keys[0]
+    auto right = std::make_unique<Inner>();
+    size_t mid = inner.children.size() / 2;
+    right->keys.assign(std::make_move_iterator(at(inner.keys, mid)), std::make_move_iterator(inner.keys.end()));
+    right->children.assign(std::make_move_iterator(at(inner.children, mid)),
+                           std::make_move_iterator(inner.children.end()));
+    right->counts.assign(at(inner.counts, mid), inner.counts.end());
+    inner.keys.erase(at(inner.keys, mid), inner.keys.end());
+    inner.children.erase(at(inner.children, mid), inner.children.end());
+    inner.counts.erase(at(inner.counts, mid), inner.counts.end());
+
+    Entry key = right->keys.front();
+    return Split{std::move(key), std::move(right)};
+}
+
+// -------------------
+// Erase
+// -------------------
+
+auto ScoreTree::erase(double score, std::string_view member) -> bool
+{
+    if (!eraseFrom(*root, score, member)) return false;
+    --count;
+
+    while (!root->isLeaf && static_cast<Inner&>(*root).children.size() == 1)
+    {
+        std::unique_ptr<Node> only = std::move(static_cast<Inner&>(*root).children.front());
+        root = std::move(only);
+    }
+    return true;
+}
+
+auto ScoreTree::eraseFrom(Node& node, double score, std::string_view member) -> bool
+{
+    if (node.isLeaf)
+    {
+        auto& leaf = static_cast<Leaf&>(node);
+        auto pos = std::upper_bound(leaf.entries.begin(), leaf.entries.end(), 0,
+                                    [&](int, const Entry& entry) { return less(score, member, entry); });
+        if (pos == leaf.entries.begin()) return false;
+        --pos;
+        if (pos->score != score || pos->member != member) return false;
+        leaf.entries.erase(pos);
+        return true;
+    }
+
+    auto& inner = static_cast<Inner&>(node);
+    size_t i = route(inner, score, member);
+    if (!eraseFrom(*inner.children[i], score, member)) return false;
+
+    --inner.counts[i];
+    rebalance(inner, i);
+    return true;
+}
+
+void ScoreTree::rebalance(Inner& inner, size_t i)
+{
+    Node& child = *inner.children[i];
+    size_t capacity = child.isLeaf ? leafCapacity : innerCapacity;
+    if (widthOf(child) >= capacity / 4 || inner.children.size() < 2) return;
+
+    size_t left = i + 1 < inner.children.size() ? i : i - 1;
+    size_t right = left + 1;
+    if (widthOf(*inner.children[left]) + widthOf(*inner.children[right]) > capacity) return;
+
+    if (child.isLeaf)
+    {
+        auto& into = static_cast<Leaf&>(*inner.children[left]);
+        auto& from = static_cast<Leaf&>(*inner.children[right]);
+        into.entries.insert(into.entries.end(), std::make_move_iterator(from.entries.begin()),
+                            std::make_move_iterator(from.entries.end()));
+        into.next = from.next;
+        if (from.next != nullptr) from.next->prev = &into;
+    }
+    else
+    {
+        // The separator between the two becomes a routing key inside the merged node
+        auto& into = static_cast<Inner&>(*inner.children[left]);
+        auto& from = static_cast<Inner&>(*inner.children[right]);
+        into.keys.push_back(std::move(inner.keys[right]));
+        into.keys.insert(into.keys.end(), std::make_move_iterator(from.keys.begin() + 1),
+                         std::make_move_iterator(from.keys.end()));
+        into.children.insert(into.children.end(), std::make_move_iterator(from.children.begin()),
+                             std::make_move_iterator(from.children.end()));
+        into.counts.insert(into.counts.end(), from.counts.begin(), from.counts.end());
+    }
+
+    auto at = [&](auto& vec) { return vec.begin() + static_cast<std::ptrdiff_t>(right); };
+    inner.counts[left] += inner.counts[right];
+    inner.counts.erase(at(inner.counts));
+    inner.keys.erase(at(inner.keys));
+    inner.children.erase(at(inner.children));
+}
+
+// -------------------
+// Ranks
+// -------------------
+
+auto ScoreTree::rank(double score, std::string_view member) const -> size_t
+{
+    size_t before = 0;
+    const Node* node = root.get();
+    while (!node->isLeaf)
+    {
+        const auto& inner = static_cast<const Inner&>(*node);
+        size_t i = route(inner, score, member);
+        before += sumOf(inner.counts, i);
+        node = inner.children[i].get();
+    }
+
+    const auto& entries = static_cast<const Leaf&>(*node).entries;
+    auto pos = std::partition_point(entries.begin(), entries.end(), [&](const Entry& entry)
+                                    { return entry.score < score || (entry.score == score && entry.member < member); });
+    return before + static_cast<size_t>(pos - entries.begin());
+}
+
+auto ScoreTree::lowerBound(double min, bool exclusive) const -> size_t
+{
+    auto below = [&](const Entry& entry) { return exclusive ? entry.score <= min : entry.score < min; };
+
+    size_t before = 0;
+    const Node* node = root.get();
+    while (!node->isLeaf)
+    {
+        // The last child whose separator is still below the bound holds the first entry that is not
+        const auto& inner = static_cast<const Inner&>(*node);
+        auto first = std::partition_point(inner.keys.begin() + 1, inner.keys.end(), below);
+        size_t i = static_cast<size_t>(first - inner.keys.begin()) - 1;
+        before += sumOf(inner.counts, i);
+        node = inner.children[i].get();
+    }
+
+    const auto& entries = static_cast<const Leaf&>(*node).entries;
+    return before + static_cast<size_t>(std::partition_point(entries.begin(), entries.end(), below) - entries.begin());
+}
+
+auto ScoreTree::seek(size_t index) const -> std::pair<const Leaf*, size_t>
+{
+    const Node* node = root.get();
+    while (!node->isLeaf)
+    {
+        const auto& inner = static_cast<const Inner&>(*node);
+        size_t i = 0;
+        while (i + 1 < inner.counts.size() && index >= inner.counts[i])
+        {
+            index -= inner.counts[i++];
+        }
+        node = inner.children[i].get();
+    }
+    return {static_cast<const Leaf*>(node), index};
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/*
+ * ScoreTree
+ * ---------
+ *
+ * The ordered index of a large sorted set (see ZSetValue in collections.h):
+ * a B+-tree of (score, member) entries, ordered by score and then by member
+ * bytes as Redis orders them.  Redis uses a skiplist with span counts here;
+ * the tree gives the same O(log n) operations with far fewer cache misses.
+ *
+ *   - Leaves hold up to `leafCapacity` entries in one sorted array and are
+ *     linked in order, so ZRANGE and ZRANGEBYSCORE find their first entry
+ *     and then read whole leaves front to back.
+ *   - Inner nodes keep, next to their child pointers, an array with each
+ *     child's entry count.  A rank is found by summing counts on the way
+ *     down, so ZRANK and a seek by rank are O(log n) without touching the
+ *     nodes they skip.
+ *   - Inner nodes route on a copy of the first key of each child but the
+ *     first, taken when the child was split off.  Erasing that entry leaves
+ *     the copy behind, which still separates the two children correctly.
+ *   - A node that falls below a quarter full is merged into a neighbour
+ *     when the two fit in one node, and a root left with one child is
+ *     replaced by it.
+ *
+ * The tree does not look members up: the sorted set keeps a member->score
+ * dictionary beside it and passes the current score in.
+ */
+class ScoreTree
+{
+  public:
+    static constexpr size_t leafCapacity = 64;
+    static constexpr size_t innerCapacity = 64;
+
+    ScoreTree();
+
+    [[nodiscard]] auto size() const -> size_t { return count; }
+    [[nodiscard]] auto empty() const -> bool { return count == 0; }
+
+    // member must not already be in the tree
+    void insert(double score, std::string_view member);
+
+    // True if (score, member) was in the tree
+    auto erase(double score, std::string_view member) -> bool;
+
+    // Number of entries ordered before (score, member)
+    [[nodiscard]] auto rank(double score, std::string_view member) const -> size_t;
+
+    // Rank of the first entry whose score is >= min (> min if exclusive); size() if there is none
+    [[nodiscard]] auto lowerBound(double min, bool exclusive) const -> size_t;
+
+    // fn(member, score) for the entries at ranks [start, stop], already clamped to the tree
+    template <typename Fn> void forRange(size_t start, size_t stop, Fn&& fn) const
+    {
+        auto [leaf, offset] = seek(start);
+        for (size_t remaining = stop - start + 1; remaining > 0; leaf = leaf->next, offset = 0)
+        {
+            for (; offset < leaf->entries.size() && remaining > 0; ++offset, --remaining)
+            {
+                const Entry& entry = leaf->entries[offset];
+                fn(std::string_view(entry.member), entry.score);
+            }
+        }
+    }
+
+  private:
+    struct Entry
+    {
+        double score;
+        std::string member;
+    };
+
+    struct Node
+    {
+        explicit Node(bool leaf) : isLeaf(leaf) {}
+        virtual ~Node() = default;
+
+        bool isLeaf;
+    };
+
+    struct Leaf : Node
+    {
+        Leaf() : Node(true) {}
+
+        std::vector<Entry> entries; // sorted
+        Leaf* prev = nullptr;
+        Leaf* next = nullptr;
+    };
+
+    struct Inner : Node
+    {
+        Inner() : Node(false) {}
+
+        std::vector<Entry> keys; // keys[i] is at or below every entry in children[i]; keys[0] is unused
+        std::vector<std::unique_ptr<Node>> children;
+        std::vector<size_t> counts; // entries under each child
+    };
+
+    // A node split off to the right of the one inserted into, with its first key
+    struct Split
+    {
+        Entry key;
+        std::unique_ptr<Node> node;
+    };
+
+    static auto less(double score, std::string_view member, const Entry& entry) -> bool
+    {
+        return score < entry.score || (score == entry.score && member < entry.member);
+    }
+
+    static auto entriesOf(const Node& node) -> size_t;
+    static auto widthOf(const Node& node) -> size_t;
+
+    // Index of the child of `inner` whose range holds (score, member)
+    static auto route(const Inner& inner, double score, std::string_view member) -> size_t;
+
+    static auto insertInto(Node& node, double score, std::string_view member) -> std::optional<Split>;
+    static auto eraseFrom(Node& node, double score, std::string_view member) -> bool;
+
+    // Merge child i of `inner` into a neighbour if it has become too small
+    static void rebalance(Inner& inner, size_t i);
+
+    // The leaf holding rank `index` and the offset in it
+    [[nodiscard]] auto seek(size_t index) const -> std::pair<const Leaf*, size_t>;
+
+    std::unique_ptr<Node> root;
+    size_t count = 0;
+};
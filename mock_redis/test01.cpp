@@ -1,6 +1,129 @@
 #include "hiredis/hiredis.h"
+#include "blocking.h"
+#include "clock.h"
+#include "collections.h"
+#include "command_recorder.h"
+#include "dict.h"
+#include "keyspace.h"
 #include "mock_redis.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace
+{
+int failures = 0;
+
+// Report a failed expectation; main's exit code says whether any failed
+void check(bool ok, const char* what)
+{
+    if (!ok)
+    {
+        std::cerr << "FAILED: " << what << "\n";
+        ++failures;
+    }
+}
+
+// The reply to a command, copied out and freed
+struct Result
+{
+    int type = 0;
+    std::string str;
+    long long integer = 0;
+    std::vector<Result> elements;
+};
+
+auto copyReply(const redisReply* reply) -> Result
+{
+    Result result;
+    result.type = reply->type;
+    result.integer = reply->integer;
+    if (reply->str != nullptr) result.str.assign(reply->str, reply->len);
+    for (size_t i = 0; i < reply->elements; ++i)
+    {
+        result.elements.push_back(copyReply(reply->element[i]));
+    }
+    return result;
+}
+
+template <typename... Args> auto run(redisContext* c, const char* format, Args... args) -> Result
+{
+    auto* reply = static_cast<redisReply*>(redisCommand(c, format, args...));
+    if (reply == nullptr) return Result{};
+    Result result = copyReply(reply);
+    freeReplyObject(reply);
+    return result;
+}
+
+// The elements of an array reply as strings; a nil element reads as "(nil)"
+auto strings(const Result& result) -> std::vector<std::string>
+{
+    std::vector<std::string> out;
+    for (const Result& element : result.elements)
+    {
+        out.push_back(element.type == REDIS_REPLY_NIL ? "(nil)" : element.str);
+    }
+    return out;
+}
+
+using Strings = std::vector<std::string>;
+
+// expired_keys from INFO stats
+auto expiredKeys(redisContext* c) -> long long
+{
+    std::string info = run(c, "INFO %s", "stats").str;
+    size_t at = info.find("expired_keys:");
+    return at == std::string::npos ? -1 : std::atoll(info.c_str() + at + 13);
+}
+
+// One field of a command's INFO commandstats line, e.g. ("get", "calls"); 0 before its first call
+auto commandStat(redisContext* c, const std::string& command, const std::string& field) -> long long
+{
+    std::string info = run(c, "INFO %s", "commandstats").str;
+    size_t line = info.find("cmdstat_" + command + ":");
+    if (line == std::string::npos) return 0;
+    std::string_view stats(info.c_str() + line, info.find("\r\n", line) - line);
+    for (const char* separator : {":", ","})
+    {
+        size_t at = stats.find(separator + field + "=");
+        if (at != std::string_view::npos) return std::atoll(stats.data() + at + field.size() + 2);
+    }
+    return -1;
+}
+
+// Clients parked in a blocking pop, read under the command lock
+auto blockedCount() -> size_t
+{
+    std::lock_guard lock(commandMutex());
+    return blockedClients().blockedCount();
+}
+
+// Wait until a blocking pop on another thread has parked itself
+void waitUntilBlocked()
+{
+    while (blockedCount() == 0)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+} // namespace
+
 auto main() -> int
 {
     redisContext* redisContext = redisConnect("127.0.0.1", 6379);
@@ -37,6 +160,7 @@ auto main() -> int
     redisCommand(redisContext, "SET %s %s", "foo", "bar"); // SET foo bar -> +OK
     redisCommand(redisContext, "AUTH %s", "badpass");      // AUTH badpass -> -ERR invalid password
     redisCommand(redisContext, "PING");                    // PING -> -NOAUTH
+    freeReplyObject(redisCommand(redisContext, "AUTH %s", "hunter2")); // +OK, for everything below
 
     // --- TEST HSET/HGET ---
     redisCommand(redisContext, "HSET %s %s %s", "myhash", "field1", "hello"); // :1
@@ -54,13 +178,497 @@ auto main() -> int
     redisCommand(redisContext, "SREM %s %s", "myset", "notfound"); // :0 (not present)
     redisCommand(redisContext, "SMEMBERS %s", "myset");            // one, three, four
 
-    auto& registry = CommandRegistry::get();
+    // --- TEST argv form (no format parsing) ---
+    const char* argv[] = {"set", "argvkey", "argv\0value"};
+    const size_t argvlen[] = {3, 7, 11};
+    freeReplyObject(redisCommandArgv(redisContext, 3, argv, argvlen)); // +OK
+    freeReplyObject(redisCommand(redisContext, "GET %s", "argvkey"));  // argv\0value
+
+    // --- CHECK lookup errors: the command name alone, and a wrong arity told apart from an unknown name ---
+    {
+        const std::string unknown = "ERR unknown command 'FOO'";
+        const std::string wrongArity = "ERR wrong number of arguments for 'get' command";
+        check(run(redisContext, "FOO %s", "x").str == unknown, "an unknown format command names only the command");
+        check(run(redisContext, "GET %s %s", "a", "b").str == wrongArity, "GET with two arguments is a wrong arity");
+        const char* badArgv[] = {"get"};
+        auto* reply = static_cast<redisReply*>(redisCommandArgv(redisContext, 1, badArgv, nullptr));
+        check(reply != nullptr && std::string(reply->str, reply->len) == wrongArity, "argv GET without a key");
+        freeReplyObject(reply);
+        check(redis::execute("FOO", "x") == redis::error(unknown), "execute of an unknown command");
+        check(redis::execute("GET", "a", "b") == redis::error(wrongArity), "execute GET with two arguments");
+
+        redisAppendCommand(redisContext, "FOO %s", "x");
+        redisAppendCommand(redisContext, "GET %s %s", "a", "b");
+        for (const std::string& expected : {unknown, wrongArity})
+        {
+            void* piped = nullptr;
+            redisGetReply(redisContext, &piped);
+            auto* r = static_cast<redisReply*>(piped);
+            check(r != nullptr && std::string(r->str, r->len) == expected, "pipelined lookup errors");
+            freeReplyObject(piped);
+        }
+    }
+
+    // --- TEST one keyspace for every type ---
+    freeReplyObject(redisCommand(redisContext, "LPUSH %s %s", "argvkey", "x")); // -WRONGTYPE
+    freeReplyObject(redisCommand(redisContext, "TYPE %s", "myset"));           // +set
+    freeReplyObject(redisCommand(redisContext, "DEL %s", "argvkey"));          // :1
+
+    // --- CHECK compact encodings: small collections are listpacks, all-integer sets intsets ---
+    {
+        auto encoding = [&](const char* key) { return run(redisContext, "OBJECT %s %s", "ENCODING", key).str; };
+        const EncodingLimits& limits = encodingLimits();
+
+        check(encoding("myhash") == "listpack", "a small hash is a listpack");
+        run(redisContext, "SADD %s %s", "userids", "1001");
+        check(encoding("userids") == "intset", "an all-integer set is an intset");
+
+        // A hash converts on a value past hash-max-listpack-value and on an entry past hash-max-listpack-entries
+        std::string longValue(limits.hashMaxListpackValue + 1, 'x');
+        run(redisContext, "HSET %s %s %s", "enc:hash", "short", "v");
+        check(encoding("enc:hash") == "listpack", "a hash of short values is a listpack");
+        run(redisContext, "HSET %s %s %s", "enc:hash", "long", longValue.c_str());
+        check(encoding("enc:hash") == "hashtable" &&
+                  run(redisContext, "HGET %s %s", "enc:hash", "long").str == longValue &&
+                  run(redisContext, "HGET %s %s", "enc:hash", "short").str == "v",
+              "a long hash value converts to a hashtable and keeps every field");
+        for (size_t i = 0; i < limits.hashMaxListpackEntries; ++i)
+        {
+            run(redisContext, "HSET %s %s %s", "enc:fields", ("f" + std::to_string(i)).c_str(), "1");
+        }
+        check(encoding("enc:fields") == "listpack", "a hash at hash-max-listpack-entries is a listpack");
+        run(redisContext, "HSET %s %s %s", "enc:fields", "one-more", "1");
+        check(encoding("enc:fields") == "hashtable" &&
+                  run(redisContext, "HLEN %s", "enc:fields").integer ==
+                      static_cast<long long>(limits.hashMaxListpackEntries) + 1,
+              "a hash past hash-max-listpack-entries converts to a hashtable");
+
+        // A non-integer member turns an intset into a listpack, or a hashtable when it is too long for one
+        run(redisContext, "SADD %s %s", "userids", "alice");
+        check(encoding("userids") == "listpack" &&
+                  strings(run(redisContext, "SMEMBERS %s", "userids")).size() == 2,
+              "a non-integer member converts an intset to a listpack");
+        run(redisContext, "SADD %s %s", "enc:ids", "1");
+        run(redisContext, "SADD %s %s", "enc:ids", std::string(limits.setMaxListpackValue + 1, 'x').c_str());
+        check(encoding("enc:ids") == "hashtable", "a long non-integer member converts an intset to a hashtable");
+
+        // Integers past set-max-intset-entries, or strings past set-max-listpack-entries, make a hashtable
+        for (size_t i = 0; i < limits.setMaxIntsetEntries; ++i)
+        {
+            run(redisContext, "SADD %s %s", "enc:ints", std::to_string(i).c_str());
+        }
+        check(encoding("enc:ints") == "intset", "a set at set-max-intset-entries is an intset");
+        run(redisContext, "SADD %s %s", "enc:ints", "-1");
+        check(encoding("enc:ints") == "hashtable" &&
+                  strings(run(redisContext, "SMEMBERS %s", "enc:ints")).size() == limits.setMaxIntsetEntries + 1,
+              "an intset past set-max-intset-entries converts to a hashtable");
+        for (size_t i = 0; i <= limits.setMaxListpackEntries; ++i)
+        {
+            run(redisContext, "SADD %s %s", "enc:words", ("w" + std::to_string(i)).c_str());
+        }
+        check(encoding("enc:words") == "hashtable", "a set past set-max-listpack-entries converts to a hashtable");
+
+        run(redisContext, "DEL %s %s %s %s %s", "enc:hash", "enc:fields", "enc:ids", "enc:ints", "enc:words");
+    }
+
+    // --- CHECK variadic commands: every key or element in one dispatch ---
+    check(run(redisContext, "MSET %s %s %s %s", "k1", "v1", "k2", "v2").str == "+OK", "MSET of two pairs");
+    check(strings(run(redisContext, "MGET %s %s %s", "k1", "nokey", "k2")) == Strings{"v1", "(nil)", "v2"},
+          "MGET of three keys keeps the nil in place");
+    check(run(redisContext, "MSET %s %s %s", "k1", "v1", "k2").type == REDIS_REPLY_ERROR, "MSET of an odd count");
+    check(run(redisContext, "RPUSH %s %s %s %s", "mylist", "a", "b", "c").integer == 3, "RPUSH of three elements");
+    check(strings(run(redisContext, "LRANGE %s %d %d", "mylist", 0, -1)) == Strings{"a", "b", "c"},
+          "RPUSH keeps the elements in argument order");
+    check(run(redisContext, "DEL %s %s %s %s", "k1", "k2", "mylist", "nokey").integer == 3,
+          "DEL counts only the keys it removed");
+
+    // --- CHECK counters: integers are stored as int64 and formatted only when read ---
+    {
+        const char* overflow = "ERR increment or decrement would overflow";
+        const char* notInteger = "ERR value is not an integer or out of range";
+        auto encoding = [&](const char* key) { return run(redisContext, "OBJECT %s %s", "ENCODING", key).str; };
+
+        run(redisContext, "SET %s %s", "hits", "9223372036854775806");
+        check(run(redisContext, "INCR %s", "hits").integer == std::numeric_limits<int64_t>::max(),
+              "INCR up to INT64_MAX");
+        check(run(redisContext, "INCR %s", "hits").str == overflow, "INCR past INT64_MAX overflows");
+        check(run(redisContext, "GET %s", "hits").str == "9223372036854775807", "an overflowing INCR keeps the value");
+        check(run(redisContext, "DECRBY %s %s", "hits", "-9223372036854775808").str == "ERR decrement would overflow",
+              "DECRBY INT64_MIN is refused");
+        run(redisContext, "SET %s %s", "hits", "-9223372036854775808");
+        check(run(redisContext, "DECR %s", "hits").str == overflow, "DECR past INT64_MIN overflows");
+        check(run(redisContext, "INCRBY %s %s", "hits", "9223372036854775807").integer == -1,
+              "INCRBY INT64_MAX from INT64_MIN");
+
+        // Only canonical decimals are integers: "012" and "+5" stay text and do not count
+        for (const char* text : {"012", "+5"})
+        {
+            run(redisContext, "SET %s %s", "hits", text);
+            check(run(redisContext, "GET %s", "hits").str == text && encoding("hits") == "embstr",
+                  "a non-canonical integer is kept as text");
+            check(run(redisContext, "INCR %s", "hits").str == notInteger, "INCR of a non-canonical integer");
+            check(run(redisContext, "INCRBY %s %s", "fresh", text).str == notInteger,
+                  "INCRBY by a non-canonical integer");
+        }
+        check(run(redisContext, "EXISTS %s", "fresh").integer == 0, "a refused INCRBY creates nothing");
+
+        run(redisContext, "SET %s %s", "price", "10.5");
+        check(run(redisContext, "INCRBYFLOAT %s %s", "price", "0.1").str == "10.6", "INCRBYFLOAT 10.5 + 0.1");
+        check(run(redisContext, "GET %s", "price").str == "10.6", "INCRBYFLOAT stores the formatted value");
+        check(run(redisContext, "INCRBYFLOAT %s %s", "price", "-0.6").str == "10", "INCRBYFLOAT cuts trailing zeros");
+
+        // APPEND turns an int-encoded value into text; a canonical result still counts
+        run(redisContext, "DEL %s", "hits");
+        check(run(redisContext, "INCRBY %s %d", "hits", 41).integer == 41 &&
+                  run(redisContext, "INCR %s", "hits").integer == 42 && encoding("hits") == "int",
+              "INCR stores an int");
+        check(run(redisContext, "APPEND %s %s", "hits", "0").integer == 3 && encoding("hits") == "embstr",
+              "APPEND to an int makes text");
+        check(run(redisContext, "GET %s", "hits").str == "420", "APPEND to an int");
+        check(run(redisContext, "INCR %s", "hits").integer == 421, "INCR of canonical text");
+        check(run(redisContext, "APPEND %s %s", "hits", "x").integer == 4 &&
+                  run(redisContext, "INCR %s", "hits").str == notInteger,
+              "INCR of text that is not an integer");
+
+        // HINCRBY on both hash encodings: the small listpack one and the hashtable past hashMaxListpackEntries
+        auto hashChecks = [&](const char* expected)
+        {
+            std::string name = std::string("HINCRBY on a ") + expected + " hash";
+            check(encoding("counts") == expected, name.c_str());
+            long long before = std::stoll(run(redisContext, "HGET %s %s", "counts", "n").str);
+            check(run(redisContext, "HINCRBY %s %s %d", "counts", "n", -7).integer == before - 7, name.c_str());
+            check(run(redisContext, "HGET %s %s", "counts", "n").str == std::to_string(before - 7), name.c_str());
+            check(run(redisContext, "HINCRBY %s %s %d", "counts", "text", 1).str == "ERR hash value is not an integer",
+                  name.c_str());
+            check(run(redisContext, "HINCRBY %s %s %d", "counts", "padded", 1).str ==
+                      "ERR hash value is not an integer",
+                  name.c_str());
+            check(run(redisContext, "HINCRBY %s %s %d", "counts", "max", 1).str == overflow, name.c_str());
+            check(run(redisContext, "HGET %s %s", "counts", "max").str == "9223372036854775807", name.c_str());
+        };
+        check(run(redisContext, "HINCRBY %s %s %d", "counts", "n", 5).integer == 5, "HINCRBY creates the field");
+        check(run(redisContext, "HINCRBY %s %s %s", "counts", "n", "4294967296").integer == 4294967301LL &&
+                  redis::execute("HINCRBY", "counts", "n", "-4294967296") == redis::integer(5),
+              "HINCRBY by an increment past 32 bits");
+        check(run(redisContext, "HINCRBY %s %s %s", "counts", "n", "1.5").str == notInteger,
+              "HINCRBY by a non-integer increment");
+        run(redisContext, "HSET %s %s %s %s %s %s %s", "counts", "text", "abc", "padded", "012", "max",
+            "9223372036854775807");
+        hashChecks("listpack");
+        for (size_t i = 0; i <= encodingLimits().hashMaxListpackEntries; ++i)
+        {
+            run(redisContext, "HSET %s %s %s", "counts", ("f" + std::to_string(i)).c_str(), "1");
+        }
+        hashChecks("hashtable");
+        check(run(redisContext, "HINCRBY %s %s %d", "counts", "f0", 41).integer == 42, "HINCRBY after the conversion");
+
+        run(redisContext, "DEL %s %s %s", "hits", "price", "counts");
+    }
+
+    // --- TEST sorted sets ---
+    freeReplyObject(redisCommand(redisContext, "ZADD %s %s %s %s %s", "board", "10", "alice", "5", "bob")); // :2
+    freeReplyObject(redisCommand(redisContext, "ZINCRBY %s %s %s", "board", "7", "bob"));                 // 12
+    freeReplyObject(redisCommand(redisContext, "ZRANK %s %s", "board", "bob"));                           // :1
+    freeReplyObject(redisCommand(redisContext, "ZRANGE %s %d %d WITHSCORES", "board", 0, -1));  // alice 10 bob 12
+    freeReplyObject(redisCommand(redisContext, "ZRANGEBYSCORE %s %s %s", "board", "-inf", "(12")); // alice
+
+    // --- CHECK set algebra: all-intset inputs merge sorted arrays, the rest probe smallest first ---
+    {
+        using Members = std::set<std::string>;
+        auto members = [](const Result& result)
+        {
+            Strings list = strings(result);
+            return Members(list.begin(), list.end());
+        };
+        auto fill = [&](const char* key, int from, int to, int step)
+        {
+            Members added;
+            for (int i = from; i <= to; i += step)
+            {
+                run(redisContext, "SADD %s %s", key, std::to_string(i).c_str());
+                added.insert(std::to_string(i));
+            }
+            return added;
+        };
+        auto intersection = [](const Members& a, const Members& b)
+        {
+            Members out;
+            std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::inserter(out, out.end()));
+            return out;
+        };
+        auto difference = [](const Members& a, const Members& b)
+        {
+            Members out;
+            std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::inserter(out, out.end()));
+            return out;
+        };
+
+        Members a = fill("ints:a", -50, 150, 1);
+        Members b = fill("ints:b", 0, 300, 2);
+        Members c = fill("ints:c", -30, 300, 3);
+        check(run(redisContext, "OBJECT %s %s", "ENCODING", "ints:a").str == "intset", "integer sets are intsets");
+
+        check(members(run(redisContext, "SINTER %s %s %s", "ints:a", "ints:b", "ints:c")) ==
+                  intersection(intersection(a, b), c),
+              "SINTER of intsets (retainCommon)");
+        check(members(run(redisContext, "SDIFF %s %s %s", "ints:a", "ints:b", "ints:c")) ==
+                  difference(difference(a, b), c),
+              "SDIFF of intsets (retainMissing)");
+        check(members(run(redisContext, "SINTER %s %s", "ints:a", "nokey")).empty(),
+              "SINTER with a missing key is empty");
+
+        run(redisContext, "SADD %s %s %s %s", "mixed", "4", "6", "text");
+        check(members(run(redisContext, "SINTER %s %s", "ints:a", "mixed")) == Members{"4", "6"},
+              "SINTER of an intset and a listpack set");
+        check(members(run(redisContext, "SDIFF %s %s", "mixed", "ints:a")) == Members{"text"},
+              "SDIFF of a listpack set minus an intset");
+
+        // The destination is also a source: it is replaced only after every input has been read
+        Members ab = intersection(a, b);
+        check(run(redisContext, "SINTERSTORE %s %s %s", "ints:a", "ints:a", "ints:b").integer ==
+                  static_cast<long long>(ab.size()),
+              "SINTERSTORE into one of its sources returns the size");
+        check(members(run(redisContext, "SMEMBERS %s", "ints:a")) == ab, "SINTERSTORE into one of its sources");
+        Members bc = difference(b, c);
+        check(run(redisContext, "SDIFFSTORE %s %s %s", "ints:b", "ints:b", "ints:c").integer ==
+                  static_cast<long long>(bc.size()),
+              "SDIFFSTORE into its first source returns the size");
+        check(members(run(redisContext, "SMEMBERS %s", "ints:b")) == bc, "SDIFFSTORE into its first source");
+        check(run(redisContext, "SDIFFSTORE %s %s %s", "ints:c", "ints:c", "ints:c").integer == 0 &&
+                  run(redisContext, "EXISTS %s", "ints:c").integer == 0,
+              "an empty SDIFFSTORE result deletes the destination");
+
+        // SINTERCARD stops counting at LIMIT, on both the intset and the probing path
+        run(redisContext, "SADD %s %s %s %s %s", "tags:a", "x", "y", "z", "w");
+        run(redisContext, "SADD %s %s %s %s %s", "tags:b", "x", "y", "z", "v");
+        auto card = [&](const char* x, const char* y, int limit)
+        { return run(redisContext, "SINTERCARD %d %s %s LIMIT %d", 2, x, y, limit).integer; };
+        auto full = static_cast<long long>(intersection(ab, bc).size());
+        check(card("ints:a", "ints:b", 5) == 5, "SINTERCARD LIMIT stops early on intsets");
+        check(card("ints:a", "ints:b", 0) == full && card("ints:a", "ints:b", 10000) == full,
+              "SINTERCARD LIMIT 0 or past the size counts everything");
+        check(card("tags:a", "tags:b", 2) == 2 && card("tags:a", "tags:b", 0) == 3,
+              "SINTERCARD LIMIT on listpack sets");
+
+        run(redisContext, "DEL %s %s %s %s %s", "ints:a", "ints:b", "mixed", "tags:a", "tags:b");
+    }
+
+    // --- CHECK incremental iteration: [next cursor, [elements]], "0" once the walk is done ---
+    {
+        // Follow the cursor from "0" back to "0", calling between() after each call; every element of every call
+        auto walk = [&](auto call, auto between)
+        {
+            std::map<std::string, int> seen;
+            std::string cursor = "0";
+            int calls = 0;
+            do
+            {
+                Result page = call(cursor.c_str());
+                cursor = page.elements.size() == 2 ? page.elements[0].str : "0";
+                for (const std::string& element : strings(page.elements.size() == 2 ? page.elements[1] : Result{}))
+                {
+                    ++seen[element];
+                }
+                between();
+            } while (cursor != "0" && ++calls < 100000);
+            return std::make_pair(seen, calls);
+        };
+        auto nothing = [] {};
+
+        for (int i = 0; i < 300; ++i)
+        {
+            run(redisContext, "SET %s %d", ("scan:" + std::to_string(i)).c_str(), i);
+        }
+        auto scanKeys = [&](const char* cursor)
+        { return run(redisContext, "SCAN %s MATCH %s COUNT %d", cursor, "scan:*", 20); };
+
+        auto [keys, calls] = walk(scanKeys, nothing);
+        bool exactlyOnce = keys.size() == 300;
+        for (const auto& [key, times] : keys) exactlyOnce = exactlyOnce && times == 1 && key.rfind("scan:", 0) == 0;
+        check(exactlyOnce, "SCAN MATCH returns each matching key exactly once when nothing changes");
+        check(calls > 1, "SCAN with COUNT walks the keyspace over several calls");
+
+        // 40 keys added after each call grow the keyspace through rehashes; the original keys still all come back
+        int added = 0;
+        auto addKeys = [&]
+        {
+            for (int i = 0; i < 40; ++i, ++added)
+            {
+                run(redisContext, "SET %s %s", ("scan:new:" + std::to_string(added)).c_str(), "v");
+            }
+        };
+        auto [keysWhileGrowing, growingCalls] = walk(scanKeys, addKeys);
+        bool atLeastOnce = true;
+        for (int i = 0; i < 300; ++i)
+        {
+            atLeastOnce = atLeastOnce && keysWhileGrowing.count("scan:" + std::to_string(i)) == 1;
+        }
+        check(atLeastOnce, "SCAN returns every key present for the whole walk while keys are added");
+        check(growingCalls > 1 && added > 1, "keys were added between SCAN calls");
+
+        auto [zsets, zsetCalls] = walk([&](const char* cursor)
+                                       { return run(redisContext, "SCAN %s TYPE %s COUNT %d", cursor, "zset", 50); },
+                                       nothing);
+        check(zsets.size() == 1 && zsets.count("board") == 1, "SCAN TYPE zset returns only the sorted set");
+
+        for (int i = 0; i < 300; ++i)
+        {
+            run(redisContext, "HSET %s %s %d", "scanhash", ("f" + std::to_string(i)).c_str(), i);
+        }
+        auto hashPages = walk([&](const char* cursor)
+                              { return run(redisContext, "HSCAN %s %s COUNT %d", "scanhash", cursor, 25); },
+                              nothing);
+        check(hashPages.first.size() == 600 && hashPages.second > 1,
+              "HSCAN of a hashtable-encoded hash returns every field and value over several calls");
+        bool pairs = true;
+        Result page = run(redisContext, "HSCAN %s %s MATCH %s COUNT %d", "scanhash", "0", "f1?", 1000);
+        Strings fields = strings(page.elements[1]);
+        for (size_t i = 0; i + 1 < fields.size(); i += 2) pairs = pairs && fields[i] == "f" + fields[i + 1];
+        check(pairs && fields.size() == 20, "HSCAN MATCH keeps the matching fields, each followed by its value");
+
+        page = run(redisContext, "ZSCAN %s %s", "board", "0");
+        check(page.elements[0].str == "0" && strings(page.elements[1]) == Strings{"alice", "10", "bob", "12"},
+              "ZSCAN of a listpack sorted set returns it whole with cursor 0");
+
+        run(redisContext, "DEL %s", "scanhash");
+        for (int i = 0; i < 300; ++i) run(redisContext, "DEL %s", ("scan:" + std::to_string(i)).c_str());
+        for (int i = 0; i < added; ++i) run(redisContext, "DEL %s", ("scan:new:" + std::to_string(i)).c_str());
+    }
+
+    // --- TEST blocking pops: an element is already queued, so BLPOP returns at once ---
+    freeReplyObject(redisCommand(redisContext, "RPUSH %s %s", "jobs", "job1")); // :1
+    freeReplyObject(redisCommand(redisContext, "BLPOP %s %d", "jobs", 1));      // [jobs, job1]
+
+    // --- CHECK pipelining: appended commands run in order and their replies come back in that order ---
+    {
+        check(redisAppendCommand(redisContext, "SET %s %s", "piped", "value") == REDIS_OK &&
+                  redisAppendCommand(redisContext, "GET %s", "piped") == REDIS_OK,
+              "redisAppendCommand queues the commands");
+        std::vector<Result> piped;
+        for (int i = 0; i < 2; ++i)
+        {
+            void* reply = nullptr;
+            check(redisGetReply(redisContext, &reply) == REDIS_OK && reply != nullptr, "redisGetReply returns a reply");
+            if (reply == nullptr) continue;
+            piped.push_back(copyReply(static_cast<redisReply*>(reply)));
+            freeReplyObject(reply);
+        }
+        check(piped.size() == 2 && piped[0].type == REDIS_REPLY_STATUS && piped[0].str == "+OK",
+              "the first pipelined reply is SET's +OK");
+        check(piped.size() == 2 && piped[1].type == REDIS_REPLY_STRING && piped[1].str == "value",
+              "the second pipelined reply is GET's value");
+    }
+
+    // --- CHECK command recording: a log loads back as the same commands and replays through dispatchCommand ---
+    {
+        std::string path = (std::filesystem::temp_directory_path() / "test01_commands.log").string();
+        check(startCommandRecording(path.c_str()), "recording starts");
+        run(redisContext, "SET %s %s", "rec:a", "1"); // format path
+        const char* getArgv[] = {"GET", "rec:a"};
+        freeReplyObject(redisCommandArgv(redisContext, 2, getArgv, nullptr)); // argv path
+        redisAppendCommand(redisContext, "INCR %s", "rec:n");                  // pipelined
+        void* piped = nullptr;
+        redisGetReply(redisContext, &piped);
+        freeReplyObject(piped);
+        run(redisContext, "MGET %s %s", "rec:a", "nokey"); // variadic, parsed into FormatArgv
+        run(redisContext, "LPUSH %s %s", "rec:a", "x");    // WRONGTYPE
+        stopCommandRecording();
+
+        struct Expected
+        {
+            std::string format;
+            Strings args;
+            int replyType;
+        };
+        const std::vector<Expected> expected = {
+            {"SET %s %s", {"rec:a", "1"}, REDIS_REPLY_STATUS},
+            {"GET %s", {"rec:a"}, REDIS_REPLY_STRING},
+            {"INCR %s", {"rec:n"}, REDIS_REPLY_INTEGER},
+            {"MGET %s", {"rec:a", "nokey"}, REDIS_REPLY_ARRAY},
+            {"LPUSH %s %s", {"rec:a", "x"}, REDIS_REPLY_ERROR},
+        };
+
+        auto log = loadCommandLog(path.c_str());
+        check(log.has_value() && log->commands.size() == expected.size(), "the log holds every recorded command");
+        if (log && log->commands.size() == expected.size())
+        {
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                const LoggedCommand& cmd = log->commands[i];
+                Strings args;
+                for (uint32_t a = 0; a < cmd.argc; ++a)
+                {
+                    args.emplace_back(log->argPtrs[cmd.firstArg + a], log->argLens[cmd.firstArg + a]);
+                }
+                std::string name = "logged command: " + expected[i].format;
+                check(cmd.info != nullptr && log->formats[cmd.format] == expected[i].format, name.c_str());
+                check(args == expected[i].args && cmd.replyType == expected[i].replyType, name.c_str());
+            }
+
+            // Replayed on a clean slate, every command gives the recorded reply type and the same data
+            run(redisContext, "DEL %s %s", "rec:a", "rec:n");
+            for (const LoggedCommand& cmd : log->commands)
+            {
+                redisReply* reply = dispatchCommand(*cmd.info, log->argPtrs.data() + cmd.firstArg,
+                                                    log->argLens.data() + cmd.firstArg, cmd.argc);
+                check(reply->type == cmd.replyType, "a replayed command gives the recorded reply type");
+                releaseRedisReply(reply);
+            }
+            check(run(redisContext, "GET %s", "rec:a").str == "1" && run(redisContext, "GET %s", "rec:n").str == "1",
+                  "the replay rebuilds the recorded keys");
+        }
+
+        run(redisContext, "DEL %s %s", "rec:a", "rec:n");
+        std::filesystem::remove(path);
+    }
+
+    // --- CHECK in-process C++ API: the read commands return Reply values, no redisReply tree ---
+    check(redis::execute("GET", "piped") == redis::bulk("value"), "execute GET returns the bulk value");
+    check(redis::execute("MGET", "piped", "nokey") == redis::array({redis::bulk("value"), redis::nil()}),
+          "execute MGET returns values and nils");
+    check(redis::execute("HGET", "myhash", "field1") == redis::bulk("hello"), "execute HGET returns the field");
+    check(redis::execute("HMGET", "myhash", "field1", "nofield") == redis::array({redis::bulk("hello"), redis::nil()}),
+          "execute HMGET returns fields and nils");
+    check(strings(run(redisContext, "HMGET %s %s %s", "myhash", "field1", "nofield")) == Strings{"hello", "(nil)"},
+          "HMGET through the C API keeps the nil element");
+    check(redis::execute("SMEMBERS", "nokey") == redis::array({}), "execute SMEMBERS of a missing key is empty");
+    check(redis::execute("LLEN", "myhash") == redis::wrongType(), "execute LLEN of a hash is WRONGTYPE");
+    check(redis::execute("LISTSUB", "ch") == redis::array({}), "execute LISTSUB of an idle channel is empty");
+    check(strings(run(redisContext, "MGET %s %s", "piped", "nokey")) == Strings{"value", "(nil)"},
+          "MGET through the C API keeps the nil element");
+
+    // --- CHECK per-command statistics: calls, failed calls and the latency histogram ---
+    {
+        long long getsBefore = commandStat(redisContext, "get", "calls");
+        for (int i = 0; i < 3; ++i) run(redisContext, "GET %s", "piped");
+        check(commandStat(redisContext, "get", "calls") == getsBefore + 3, "cmdstat_get counts every GET");
+
+        long long failedBefore = commandStat(redisContext, "lpush", "failed_calls");
+        run(redisContext, "LPUSH %s %s", "piped", "x"); // WRONGTYPE
+        check(commandStat(redisContext, "lpush", "failed_calls") == failedBefore + 1,
+              "a failing LPUSH counts in failed_calls");
+
+        redis::Reply histogram = redis::execute("LATENCY", "HISTOGRAM", "GET");
+        const auto* commands = std::get_if<redis::Map>(&histogram.value);
+        bool hasGet = commands != nullptr && commands->data.contains(redis::bulk("get"));
+        check(hasGet, "LATENCY HISTOGRAM has a get entry");
+        if (hasGet)
+        {
+            const auto& entry = std::get<redis::Map>(commands->data.at(redis::bulk("get")).value).data;
+            auto calls = entry.find(redis::bulk("calls"));
+            auto buckets = entry.find(redis::bulk("histogram_nsec"));
+            check(calls != entry.end() && std::get<long long>(calls->second.value) >= 3, "the get entry counts calls");
+            check(buckets != entry.end() && !std::get<redis::Map>(buckets->second.value).empty(),
+                  "the get entry has a non-empty histogram_nsec");
+        }
+    }
+    freeReplyObject(redisCommand(redisContext, "INFO %s", "keyspace"));         // db0:keys=...,expires=...
 
     std::cout << "Registered commands:\n";
 
-    for (const auto& [format, info] : registry)
+    for (const auto& info : CommandRegistry::all())
     {
-        std::cout << format << "\n";
+        std::cout << info.format << "\n";
     }
 
     redisCommand(redisContext , "AUTH %s", "hunter2");
@@ -68,5 +676,293 @@ auto main() -> int
     // Get("key");
     // Get("none");
 
-    return 0;
+    // --- CHECK Dict: every lookup right while an incremental rehash is in progress, tombstones included ---
+    {
+        DictMap<int> dict;
+        std::unordered_map<std::string, int> model;
+        auto keyOf = [](int i) { return "key:" + std::to_string(i); };
+
+        // Every model key found with its value, every erased key gone, and iteration visiting each key once
+        auto matches = [&](int upTo)
+        {
+            if (dict.size() != model.size()) return false;
+            for (int i = 0; i < upTo; ++i)
+            {
+                auto it = dict.find(keyOf(i));
+                auto expected = model.find(keyOf(i));
+                if ((it == dict.end()) != (expected == model.end())) return false;
+                if (it != dict.end() && it->second != expected->second) return false;
+            }
+            size_t visited = 0;
+            for (const auto& [key, value] : dict)
+            {
+                auto expected = model.find(key);
+                if (expected == model.end() || expected->second != value) return false;
+                ++visited;
+            }
+            return visited == model.size();
+        };
+
+        int inserted = 0;
+        int rehashChecks = 0;
+        bool allMatch = true;
+        auto insertUpTo = [&](int n)
+        {
+            for (; inserted < n; ++inserted)
+            {
+                auto [it, isNew] = dict.emplace(keyOf(inserted), inserted);
+                allMatch = allMatch && isNew && it->second == inserted;
+                model.emplace(keyOf(inserted), inserted);
+
+                // Checked a few times over each rehash, which lasts a good share of the inserts that follow a growth
+                if (dict.rehashing() && inserted % 64 == 0)
+                {
+                    allMatch = allMatch && matches(inserted + 1);
+                    ++rehashChecks;
+                }
+            }
+        };
+
+        insertUpTo(20000);
+        check(allMatch, "Dict lookups during growth");
+        check(rehashChecks > 10, "Dict growth was checked mid-rehash");
+        check(!dict.emplace(keyOf(7), -1).second && dict.find(keyOf(7))->second == 7,
+              "Dict emplace of a present key keeps its value");
+
+        // Erase two keys in three, leaving tombstones, then insert past them into rehashes again
+        bool erased = true;
+        for (int i = 0; i < inserted; ++i)
+        {
+            if (i % 3 == 0) continue;
+            erased = erased && dict.erase(keyOf(i)) == 1 && dict.erase(keyOf(i)) == 0;
+            model.erase(keyOf(i));
+            if (dict.rehashing() && i % 257 == 0) allMatch = allMatch && matches(inserted);
+        }
+        check(erased, "Dict erase removes a key exactly once");
+        check(matches(inserted), "Dict lookups after erasing two keys in three");
+
+        rehashChecks = 0;
+        insertUpTo(60000);
+        check(allMatch, "Dict lookups while inserting over tombstones");
+        check(rehashChecks > 0, "Dict rehashed again after the erases");
+        check(matches(inserted), "Dict lookups once every insert is done");
+    }
+
+    // --- CHECK quicklist: 128-byte nodes, all but the end nodes LZF-compressed ---
+    EncodingLimits savedLimits = encodingLimits();
+    encodingLimits().listMaxListpackBytes = 128;
+    encodingLimits().listCompressDepth = 1;
+    {
+        std::deque<std::string> expected;
+        auto lrange = [&](int start, int stop)
+        { return strings(run(redisContext, "LRANGE %s %d %d", "qlist", start, stop)); };
+        auto pushBoth = [&](int from, int to)
+        {
+            for (int i = from; i < to; ++i)
+            {
+                std::string value = "element-" + std::to_string(i) + "-" + std::string(24, 'x'); // compressible
+                if (i % 2 == 0)
+                {
+                    run(redisContext, "RPUSH %s %s", "qlist", value.c_str());
+                    expected.push_back(value);
+                }
+                else
+                {
+                    run(redisContext, "LPUSH %s %s", "qlist", value.c_str());
+                    expected.push_front(value);
+                }
+            }
+        };
+
+        pushBoth(0, 200);
+        check(run(redisContext, "OBJECT %s %s", "ENCODING", "qlist").str == "quicklist", "a long list is a quicklist");
+        check(lrange(0, -1) == Strings(expected.begin(), expected.end()),
+              "LRANGE reads across compressed nodes in order");
+        check(lrange(90, 110) == Strings(expected.begin() + 90, expected.begin() + 111),
+              "LRANGE starting inside a compressed middle node");
+        check(lrange(-3, -1) == Strings(expected.end() - 3, expected.end()), "LRANGE of the raw tail node");
+
+        bool popsInOrder = true;
+        for (int i = 0; i < 70; ++i)
+        {
+            popsInOrder = popsInOrder && run(redisContext, "LPOP %s", "qlist").str == expected.front();
+            expected.pop_front();
+            popsInOrder = popsInOrder && run(redisContext, "RPOP %s", "qlist").str == expected.back();
+            expected.pop_back();
+        }
+        check(popsInOrder, "LPOP and RPOP return the ends while nodes decompress towards them");
+
+        pushBoth(200, 240);
+        check(lrange(0, -1) == Strings(expected.begin(), expected.end()),
+              "LRANGE after popping and pushing at both ends");
+        check(run(redisContext, "LLEN %s", "qlist").integer == static_cast<long long>(expected.size()),
+              "LLEN counts the compressed nodes' entries");
+        run(redisContext, "DEL %s", "qlist");
+    }
+    encodingLimits() = savedLimits;
+
+    // --- CHECK sorted sets past the listpack: B+-tree splits, then merges after most members are removed ---
+    {
+        // (score, member) in ZRANGE order; scores repeat, so ties fall back to the member name
+        std::vector<std::pair<int, std::string>> expected;
+        for (int i = 0; i < 5000; ++i)
+        {
+            std::string member = "m" + std::string(5 - std::to_string(i).size(), '0') + std::to_string(i);
+            expected.emplace_back(i % 100, member);
+            run(redisContext, "ZADD %s %s %s", "ztree", std::to_string(i % 100).c_str(), member.c_str());
+        }
+        std::sort(expected.begin(), expected.end());
+
+        auto members = [&](auto first, auto last)
+        {
+            Strings out;
+            for (auto it = first; it != last; ++it) out.push_back(it->second);
+            return out;
+        };
+        auto byScore = [&](int min, bool minOpen, int max, bool maxOpen)
+        {
+            Strings out;
+            for (const auto& [score, member] : expected)
+            {
+                bool aboveMin = minOpen ? score > min : score >= min;
+                bool belowMax = maxOpen ? score < max : score <= max;
+                if (aboveMin && belowMax) out.push_back(member);
+            }
+            return out;
+        };
+        auto checkTree = [&](const char* stage)
+        {
+            std::string what(stage);
+            auto n = static_cast<long long>(expected.size());
+            check(run(redisContext, "OBJECT %s %s", "ENCODING", "ztree").str == "skiplist",
+                  (what + ": encoding").c_str());
+            check(run(redisContext, "ZCARD %s", "ztree").integer == n, (what + ": ZCARD").c_str());
+
+            bool ranks = true;
+            for (long long rank = 0; rank < n; rank += 37)
+            {
+                const char* member = expected[rank].second.c_str();
+                ranks = ranks && run(redisContext, "ZRANK %s %s", "ztree", member).integer == rank;
+            }
+            check(ranks, (what + ": ZRANK across leaves").c_str());
+
+            int mid = static_cast<int>(n / 2);
+            check(strings(run(redisContext, "ZRANGE %s %d %d", "ztree", mid, mid + 99)) ==
+                      members(expected.begin() + mid, expected.begin() + mid + 100),
+                  (what + ": ZRANGE spanning leaves").c_str());
+            check(strings(run(redisContext, "ZRANGE %s %d %d", "ztree", -70, -1)) ==
+                      members(expected.end() - 70, expected.end()),
+                  (what + ": ZRANGE with negative indices").c_str());
+            check(strings(run(redisContext, "ZRANGEBYSCORE %s %s %s", "ztree", "(10", "20")) ==
+                      byScore(10, true, 20, false),
+                  (what + ": ZRANGEBYSCORE with an exclusive min").c_str());
+            check(strings(run(redisContext, "ZRANGEBYSCORE %s %s %s", "ztree", "(10", "(12")) ==
+                      byScore(10, true, 12, true),
+                  (what + ": ZRANGEBYSCORE exclusive at both ends").c_str());
+
+            Strings window = byScore(30, false, 60, true);
+            Strings limited(window.begin() + 25, window.begin() + std::min<size_t>(window.size(), 25 + 40));
+            check(strings(run(redisContext, "ZRANGEBYSCORE %s %s %s LIMIT %d %d", "ztree", "30", "(60", 25, 40)) ==
+                      limited,
+                  (what + ": ZRANGEBYSCORE with LIMIT").c_str());
+        };
+
+        checkTree("after 5000 ZADDs");
+
+        // Keep every tenth member: whole leaves empty out and neighbours merge
+        std::vector<std::pair<int, std::string>> kept;
+        bool removed = true;
+        for (const auto& entry : expected)
+        {
+            if (std::stoi(entry.second.substr(1)) % 10 == 0)
+            {
+                kept.push_back(entry);
+                continue;
+            }
+            removed = removed && run(redisContext, "ZREM %s %s", "ztree", entry.second.c_str()).integer == 1;
+        }
+        check(removed, "ZREM removes each member once");
+        expected = std::move(kept);
+        checkTree("after removing 90%");
+        check(run(redisContext, "ZRANK %s %s", "ztree", "m00001").type == REDIS_REPLY_NIL,
+              "ZRANK of a removed member is nil");
+        run(redisContext, "DEL %s", "ztree");
+    }
+
+    // --- CHECK virtual time: a TTL runs out without sleeping ---
+    useVirtualClock(true);
+    run(redisContext, "SETEX %s %d %s", "session", 10, "token");
+    check(run(redisContext, "TTL %s", "session").integer == 10, "TTL right after SETEX 10 is 10");
+    advanceVirtualClock(std::chrono::milliseconds(9400));
+    check(run(redisContext, "TTL %s", "session").integer == 1, "TTL rounds 0.6 s up to 1");
+    advanceVirtualClock(std::chrono::milliseconds(200));
+    check(run(redisContext, "TTL %s", "session").integer == 0 && run(redisContext, "EXISTS %s", "session").integer == 1,
+          "TTL of a key with under half a second left is 0 and keeps the key");
+    advanceVirtualClock(std::chrono::milliseconds(1400));
+    check(run(redisContext, "GET %s", "session").type == REDIS_REPLY_NIL, "GET after the TTL is nil");
+    check(run(redisContext, "TTL %s", "session").integer == -2, "TTL after expiry is -2");
+
+    // --- CHECK active expiry: a key nobody reads is still counted in expired_keys ---
+    run(redisContext, "SETEX %s %d %s", "unread", 10, "v");
+    long long expiredBefore = expiredKeys(redisContext);
+    advanceVirtualClock(std::chrono::seconds(11));
+    run(redisContext, "PING"); // the cycle runs after a command, and PING touches no key
+    check(expiredKeys(redisContext) == expiredBefore + 1, "active expiry counted in INFO stats");
+
+    // --- CHECK blocking pops under virtual time: a second client blocks, this one unblocks it ---
+    auto* blocked = redisConnect("127.0.0.1", 6379);
+    Result moved;
+    std::thread timesOut([&] { moved = run(blocked, "BLMOVE %s %s %s %s %d", "empty", "dst", "LEFT", "RIGHT", 1); });
+    waitUntilBlocked();
+    advanceVirtualClock(std::chrono::seconds(2)); // past the deadline: the pop returns nil now
+    timesOut.join();
+    check(moved.type == REDIS_REPLY_NIL, "BLMOVE times out when the virtual clock passes its deadline");
+
+    std::thread servedByPush([&] { moved = run(blocked, "BLMOVE %s %s %s %s %d", "src", "dst", "LEFT", "RIGHT", 5); });
+    waitUntilBlocked();
+    run(redisContext, "RPUSH %s %s", "src", "job"); // handed to the waiter, which moves it to dst
+    servedByPush.join();
+    check(moved.str == "job", "a push wakes a blocked BLMOVE with the element");
+    check(run(redisContext, "LLEN %s", "dst").integer == 1 && run(redisContext, "LLEN %s", "src").integer == 0,
+          "the served element is moved to the destination, not left in the source");
+
+    // Several keys: the first non-empty one is popped at once, else the pop waits on all of them
+    run(redisContext, "RPUSH %s %s", "second", "ready");
+    Result popped = run(redisContext, "BLPOP %s %s %s %s", "first", "second", "third", "0.5");
+    check(strings(popped) == Strings{"second", "ready"}, "BLPOP pops the first non-empty key of several");
+
+    std::thread multiKey([&] { popped = run(blocked, "BRPOP %s %s %s", "first", "third", "2.5"); });
+    waitUntilBlocked();
+    run(redisContext, "LPUSH %s %s", "third", "late");
+    multiKey.join();
+    check(strings(popped) == Strings{"third", "late"}, "a push onto any of the keys serves a multi-key BRPOP");
+    check(blockedCount() == 0, "the served waiter leaves the queues of its other keys");
+    run(redisContext, "RPUSH %s %s", "first", "kept");
+    check(run(redisContext, "LLEN %s", "first").integer == 1, "a later push onto another of its keys is stored");
+    run(redisContext, "DEL %s", "first");
+
+    std::thread fractional([&] { popped = run(blocked, "BLPOP %s %s", "empty", "0.5"); });
+    waitUntilBlocked();
+    advanceVirtualClock(std::chrono::milliseconds(400));
+    check(blockedCount() == 1, "a 0.5 s timeout is still waiting after 0.4 s");
+    advanceVirtualClock(std::chrono::milliseconds(200));
+    fractional.join();
+    check(popped.type == REDIS_REPLY_NIL, "a 0.5 s timeout has passed after 0.6 s");
+
+    check(run(redisContext, "BLPOP %s %s", "empty", "soon").type == REDIS_REPLY_ERROR,
+          "a non-numeric timeout is an error");
+    check(run(redisContext, "BLPOP %s %s", "empty", "-1").type == REDIS_REPLY_ERROR, "a negative timeout is an error");
+    check(run(redisContext, "BLPOP %s", "empty").type == REDIS_REPLY_ERROR, "BLPOP needs a key and a timeout");
+
+    // Switching virtual time off while a pop waits: it times out on the real clock instead of never
+    useVirtualClock(true); // frozen at the current real time, so the deadline is 0.2 s of real time away
+    std::thread outlivesVirtualTime([&] { popped = run(blocked, "BLPOP %s %s", "empty", "0.2"); });
+    waitUntilBlocked();
+    useVirtualClock(false);
+    outlivesVirtualTime.join();
+    check(popped.type == REDIS_REPLY_NIL, "a pop blocked under virtual time times out once it is switched off");
+    redisFree(blocked);
+
+    redisFree(redisContext);
+    return failures == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "trace.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+#ifdef MOCK_REDIS_TRACE_RING
+
+// Bounded multi-producer queue (Vyukov): each slot's sequence number says
+// whether it is free for the producer at that position or holds a record for
+// the consumer.  Producers claim a position with one CAS; nothing blocks.
+class TraceRing
+{
+  public:
+    TraceRing()
+    {
+        for (size_t i = 0; i < slotCount; ++i)
+        {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        drainer = std::thread([this] { drainLoop(); });
+    }
+
+    TraceRing(const TraceRing&) = delete;
+    auto operator=(const TraceRing&) -> TraceRing& = delete;
+
+    ~TraceRing()
+    {
+        stopping.store(true, std::memory_order_release);
+        drainer.join();
+    }
+
+    void push(std::string_view line)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;)
+        {
+            slot = &slots[pos & (slotCount - 1)];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed); // full
+                return;
+            }
+            else
+            {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->len = static_cast<uint16_t>(line.size() < sizeof(slot->text) ? line.size() : sizeof(slot->text));
+        std::memcpy(slot->text, line.data(), slot->len);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+    // Block until everything pushed before the call has been written
+    void flush()
+    {
+        size_t target = head.load(std::memory_order_acquire);
+        while (written.load(std::memory_order_acquire) < target)
+        {
+            std::this_thread::yield();
+        }
+        std::fflush(stdout);
+    }
+
+  private:
+    static constexpr size_t slotCount = 4096;
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        uint16_t len;
+        char text[238];
+    };
+
+    auto drainOnce() -> bool
+    {
+        bool any = false;
+        for (;;)
+        {
+            Slot& slot = slots[tail & (slotCount - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != tail + 1) break;
+
+            std::fwrite(slot.text, 1, slot.len, stdout);
+            std::fputc('\n', stdout);
+            slot.sequence.store(tail + slotCount, std::memory_order_release);
+            written.store(++tail, std::memory_order_release);
+            any = true;
+        }
+
+        if (uint64_t lost = dropped.exchange(0, std::memory_order_relaxed); lost != 0)
+        {
+            std::fprintf(stdout, "[trace] %llu records dropped\n", static_cast<unsigned long long>(lost));
+        }
+        if (any) std::fflush(stdout);
+        return any;
+    }
+
+    void drainLoop()
+    {
+        while (!stopping.load(std::memory_order_acquire))
+        {
+            if (!drainOnce())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        drainOnce();
+    }
+
+    std::array<Slot, slotCount> slots;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) size_t tail = 0; // drainer only
+    std::atomic<size_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> stopping{false};
+    std::thread drainer;
+};
+
+auto ring() -> TraceRing&
+{
+    static TraceRing instance;
+    return instance;
+}
+
+#endif
+} // namespace
+
+void traceWrite(TraceLevel /*level*/, std::string_view line)
+{
+#ifdef MOCK_REDIS_TRACE_RING
+    ring().push(line);
+#else
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+#endif
+}
+
+void flushTrace()
+{
+#ifdef MOCK_REDIS_TRACE_RING
+    ring().flush();
+#else
+    std::fflush(stdout);
+#endif
+}
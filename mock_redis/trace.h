@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdio>
+#include <string_view>
+
+/*
+ * Trace facility
+ * --------------
+ *
+ * Replaces the ad hoc std::cout / std::cerr logging on the dispatch path
+ * (reply dumps, "create" traces, PUBLISH logging).
+ *
+ *   - The level is fixed at compile time by MOCK_REDIS_TRACE_LEVEL (0 off,
+ *     1 error, 2 info, 3 debug, 4 verbose).  It defaults to 0 when NDEBUG is
+ *     defined and to 3 otherwise.  MOCK_REDIS_TRACE expands to an
+ *     `if constexpr`, so a disabled call is compiled out along with the
+ *     evaluation of its arguments.
+ *   - By default enabled records are written straight to stdout, unflushed.
+ *     With MOCK_REDIS_TRACE_RING defined they are instead copied into a
+ *     lock-free ring buffer and a background thread writes them out, so the
+ *     calling thread never takes the stdio lock.  When the ring is full,
+ *     records are dropped and the drop count is reported.
+ *
+ *     MOCK_REDIS_TRACE(TraceLevel::Info, "PUBLISH %.*s -> %d", len, channel, count);
+ */
+
+#ifndef MOCK_REDIS_TRACE_LEVEL
+#ifdef NDEBUG
+#define MOCK_REDIS_TRACE_LEVEL 0
+#else
+#define MOCK_REDIS_TRACE_LEVEL 3
+#endif
+#endif
+
+enum class TraceLevel : unsigned char
+{
+    Off,
+    Error,
+    Info,
+    Debug,
+    Verbose, // per-allocation noise
+};
+
+inline constexpr auto traceLevel = static_cast<TraceLevel>(MOCK_REDIS_TRACE_LEVEL);
+
+constexpr auto traceEnabled(TraceLevel level) -> bool
+{
+    return level != TraceLevel::Off && level <= traceLevel;
+}
+
+// Hand one finished line (no trailing newline) to the sink
+void traceWrite(TraceLevel level, std::string_view line);
+
+// Write out everything recorded so far
+void flushTrace();
+
+// printf-style front end; only reached through MOCK_REDIS_TRACE
+template <typename... Args> void traceFormat(TraceLevel level, const char* format, Args... args)
+{
+    char line[256];
+    int len = std::snprintf(line, sizeof(line), format, args...);
+    if (len < 0)
+    {
+        return;
+    }
+    traceWrite(level, std::string_view(line, len < static_cast<int>(sizeof(line)) ? len : sizeof(line) - 1));
+}
+
+#define MOCK_REDIS_TRACE(level, ...)                                                                                   \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if constexpr (traceEnabled(level))                                                                             \
+        {                                                                                                              \
+            traceFormat(level, __VA_ARGS__);                                                                           \
+        }                                                                                                              \
+    } while (0)